@@ -12,22 +12,29 @@ using StmtPtr = std::unique_ptr<Stmt>;
 
 // Base expression class
 struct Expr {
+    int line = 1;   // source position, filled in by the parser
+    int column = 1;
     virtual ~Expr() = default;
 };
 
 // Expression types
 struct LiteralExpr : Expr {
-    std::variant<int, float, std::string> value;
+    // Float literals keep full double precision; they are typed float unless
+    // used where a double is expected
+    std::variant<int, long long, double, std::string, bool> value;
     LiteralExpr(int v) : value(v) {}
-    LiteralExpr(float v) : value(v) {}
+    LiteralExpr(long long v) : value(v) {}
+    LiteralExpr(double v) : value(v) {}
     LiteralExpr(const std::string &v) : value(v) {}
+    LiteralExpr(bool v) : value(v) {}
 };
 
 struct VarExpr : Expr {
     std::string name;
-    int line;
-    int column;
-    VarExpr(std::string n, int ln = 1, int col = 1) : name(std::move(n)), line(ln), column(col) {}
+    VarExpr(std::string n, int ln = 1, int col = 1) : name(std::move(n)) {
+        line = ln;
+        column = col;
+    }
 };
 
 struct BinaryExpr : Expr {
@@ -55,6 +62,15 @@ struct IndexExpr : Expr {
     IndexExpr(ExprPtr a, ExprPtr idx) : array(std::move(a)), index(std::move(idx)) {}
 };
 
+// a[lo:hi]: a view of elements [lo, hi) sharing a's storage; lo defaults
+// to 0 and hi to the length of a
+struct SliceExpr : Expr {
+    ExprPtr array;
+    ExprPtr lo; // may be nullptr
+    ExprPtr hi; // may be nullptr
+    SliceExpr(ExprPtr a, ExprPtr l, ExprPtr h) : array(std::move(a)), lo(std::move(l)), hi(std::move(h)) {}
+};
+
 struct CallExpr : Expr {
     std::string callee;
     std::vector<ExprPtr> args;
@@ -62,19 +78,54 @@ struct CallExpr : Expr {
         : callee(std::move(c)), args(std::move(a)) {}
 };
 
+// recv(c) yields the next element; recv(c, x) stores it in x and yields
+// false once c is closed and drained
+struct RecvExpr : Expr {
+    ExprPtr chan;
+    std::string target; // empty for recv(c)
+    RecvExpr(ExprPtr c, std::string t) : chan(std::move(c)), target(std::move(t)) {}
+};
+
+// "x=${x} y=${y}": the literal text around each embedded expression, so
+// segments has one more entry than holes
+struct InterpExpr : Expr {
+    std::vector<std::string> segments;
+    std::vector<ExprPtr> holes;
+};
+
 // Base statement class
 struct Stmt { 
+    int line = 1;   // source position, filled in by the parser
+    int column = 1;
     virtual ~Stmt() = default; 
 };
 
 // Statement types
 struct VarDeclStmt : Stmt {
-    enum Kind { INT, FLOAT, STRING, INT_ARRAY, FLOAT_ARRAY, STRING_ARRAY, VOID } type;
+    enum Kind { INT, FLOAT, STRING, INT_ARRAY, FLOAT_ARRAY, STRING_ARRAY, BOOL,
+                INT64, DOUBLE, INT64_ARRAY, DOUBLE_ARRAY,
+                CHAN_INT, CHAN_FLOAT, CHAN_STRING,
+                MAP_INT, MAP_FLOAT, MAP_STRING, // maps have string keys
+                BUILDER, VOID } type; // BUILDER: a string builder, from builder()
     std::string name;
     ExprPtr init;
     VarDeclStmt(Kind t, std::string n, ExprPtr i) : type(t), name(std::move(n)), init(std::move(i)) {}
 };
 
+// chan int(capacity): a new channel; declared here since it needs the kinds
+struct ChanExpr : Expr {
+    VarDeclStmt::Kind elemKind;
+    ExprPtr capacity;
+    ChanExpr(VarDeclStmt::Kind k, ExprPtr c) : elemKind(k), capacity(std::move(c)) {}
+};
+
+// map[string]int() or map[string]int(hint): a new, empty map
+struct MapExpr : Expr {
+    VarDeclStmt::Kind valueKind;
+    ExprPtr sizeHint; // may be nullptr
+    MapExpr(VarDeclStmt::Kind k, ExprPtr h) : valueKind(k), sizeHint(std::move(h)) {}
+};
+
 struct InferDeclStmt : Stmt {
     std::string name;
     ExprPtr init;
@@ -84,17 +135,30 @@ struct InferDeclStmt : Stmt {
 struct AssignStmt : Stmt {
     std::string name;
     ExprPtr expr;
-    int line;
-    int column;
     AssignStmt(std::string n, ExprPtr e, int ln = 1, int col = 1) 
-        : name(std::move(n)), expr(std::move(e)), line(ln), column(col) {}
+        : name(std::move(n)), expr(std::move(e)) {
+        line = ln;
+        column = col;
+    }
+};
+
+struct IndexAssignStmt : Stmt {
+    std::string name;
+    ExprPtr index;
+    ExprPtr expr;
+    IndexAssignStmt(std::string n, ExprPtr i, ExprPtr e, int ln = 1, int col = 1)
+        : name(std::move(n)), index(std::move(i)), expr(std::move(e)) {
+        line = ln;
+        column = col;
+    }
 };
 
 struct PrintStmt : Stmt {
     ExprPtr expr;
-    int line;
-    int column;
-    PrintStmt(ExprPtr e, int ln = 1, int col = 1) : expr(std::move(e)), line(ln), column(col) {}
+    PrintStmt(ExprPtr e, int ln = 1, int col = 1) : expr(std::move(e)) {
+        line = ln;
+        column = col;
+    }
 };
 
 struct IfStmt : Stmt {
@@ -107,8 +171,11 @@ struct IfStmt : Stmt {
 struct WhileStmt : Stmt {
     ExprPtr cond;
     std::vector<StmtPtr> body;
-    WhileStmt(ExprPtr c, std::vector<StmtPtr> b)
-        : cond(std::move(c)), body(std::move(b)) {}
+    WhileStmt(ExprPtr c, std::vector<StmtPtr> b, int ln = 1, int col = 1)
+        : cond(std::move(c)), body(std::move(b)) {
+        line = ln;
+        column = col;
+    }
 };
 
 struct ForStmt : Stmt {
@@ -116,8 +183,25 @@ struct ForStmt : Stmt {
     ExprPtr cond;
     StmtPtr post;
     std::vector<StmtPtr> body;
-    ForStmt(StmtPtr i, ExprPtr c, StmtPtr p, std::vector<StmtPtr> b)
-        : init(std::move(i)), cond(std::move(c)), post(std::move(p)), body(std::move(b)) {}
+    bool parallel = false; // parallel for: iterations run on the runtime thread pool
+    ForStmt(StmtPtr i, ExprPtr c, StmtPtr p, std::vector<StmtPtr> b, int ln = 1, int col = 1)
+        : init(std::move(i)), cond(std::move(c)), post(std::move(p)), body(std::move(b)) {
+        line = ln;
+        column = col;
+    }
+};
+
+// for x in iterable { ... }: x is a copy of each element of an array, or
+// each value received from a channel until it is closed and drained
+struct ForInStmt : Stmt {
+    std::string var;
+    ExprPtr iterable;
+    std::vector<StmtPtr> body;
+    ForInStmt(std::string v, ExprPtr it, std::vector<StmtPtr> b, int ln = 1, int col = 1)
+        : var(std::move(v)), iterable(std::move(it)), body(std::move(b)) {
+        line = ln;
+        column = col;
+    }
 };
 
 struct ExprStmt : Stmt {
@@ -125,6 +209,31 @@ struct ExprStmt : Stmt {
     ExprStmt(ExprPtr e) : expr(std::move(e)) {}
 };
 
+struct GoStmt : Stmt {
+    ExprPtr call; // CallExpr run as a green thread
+    GoStmt(ExprPtr c, int ln = 1, int col = 1) : call(std::move(c)) {
+        line = ln;
+        column = col;
+    }
+};
+
+struct SendStmt : Stmt {
+    ExprPtr chan;
+    ExprPtr value;
+    SendStmt(ExprPtr c, ExprPtr v, int ln = 1, int col = 1) : chan(std::move(c)), value(std::move(v)) {
+        line = ln;
+        column = col;
+    }
+};
+
+struct CloseStmt : Stmt {
+    ExprPtr chan;
+    CloseStmt(ExprPtr c, int ln = 1, int col = 1) : chan(std::move(c)) {
+        line = ln;
+        column = col;
+    }
+};
+
 struct ReturnStmt : Stmt {
     ExprPtr value; // puede ser nullptr para "return;"
     ReturnStmt(ExprPtr v = nullptr) : value(std::move(v)) {}
@@ -140,9 +249,13 @@ struct FunctionStmt : Stmt {
     
     // Constructor principal
     FunctionStmt(bool inf, VarDeclStmt::Kind rt, std::string n, 
-                 std::vector<std::string> p, std::vector<bool> pa, std::vector<StmtPtr> b)
+                 std::vector<std::string> p, std::vector<bool> pa, std::vector<StmtPtr> b,
+                 int ln = 1, int col = 1)
         : inference(inf), retType(rt), name(std::move(n)),
-          params(std::move(p)), paramIsArray(std::move(pa)), body(std::move(b)) {}
+          params(std::move(p)), paramIsArray(std::move(pa)), body(std::move(b)) {
+        line = ln;
+        column = col;
+    }
           
     // Constructor de compatibilidad (sin paramIsArray)
     FunctionStmt(bool inf, VarDeclStmt::Kind rt, std::string n, 
@@ -6,31 +6,137 @@
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/Type.h>
 #include <llvm/IR/Function.h>
+#include <llvm/IR/DIBuilder.h>
+#include <llvm/Target/TargetMachine.h>
+#include <functional>
 #include <map>
+#include <set>
 #include <vector>
 #include <memory>
 
 class CodeGenerator {
+public:
+    // --bounds=full|trap|off: diagnostic message, bare trap, or no checks
+    enum class BoundsMode { FULL, TRAP, OFF };
+
+private:
     llvm::LLVMContext &context;
     std::unique_ptr<llvm::Module> module;
     llvm::IRBuilder<> builder;
     std::vector<std::map<std::string, llvm::AllocaInst*>> namedValuesStack;
     std::map<std::string, VarDeclStmt::Kind> variableTypes;
     std::map<std::string, int> arraySizes; // Store array sizes
-    std::map<std::string, llvm::Function*> functions; // function name -> llvm function
-    std::map<std::string, VarDeclStmt::Kind> functionTypes; // function name -> return type
+    std::map<std::string, llvm::AllocaInst*> arrayLengths; // runtime i64 lengths (array parameters, slices)
+    std::map<const Expr*, llvm::Value*> viewLengths; // i32 length of the last value generated by a slice or mapInts/mapFloats
+    std::map<std::string, const FunctionStmt*> functionDecls; // function name -> declaration
+    std::map<std::string, llvm::Function*> functions; // specialization name -> llvm function
+    std::map<std::string, VarDeclStmt::Kind> functionTypes; // specialization name -> return type
+    std::map<std::string, llvm::GlobalVariable*> stringConstants; // interned literals: equal text, equal pointer
+    std::map<std::string, llvm::AllocaInst*> loopBuilders; // string -> gz_sb* it is built in, while in its loop
     llvm::Function *mainFunction;
     llvm::Function *currentFunction;
     TypeAnalyzer &typeAnalyzer;
 
+    // Optimization and profile-guided optimization settings
+    int optLevel = 0;
+    bool profileGenerate = false;
+    std::string profileGenerateDir; // empty -> current directory
+    std::string profileUseFile;
+
+    // --instrument: call/cycle counters per function, trip counters per loop
+    struct ProfileSite {
+        bool isLoop;
+        std::string label;
+        int line;
+        int column;
+        llvm::GlobalVariable *counters[3]; // calls/inclusive/exclusive or entries/trips
+    };
+    struct ProfileFrame {
+        size_t site;
+        llvm::Value *start;      // cycle counter at function entry
+        llvm::Value *childSlot;  // uint64_t* from gz_prof_child: the task's or thread's accumulator
+        llvm::Value *savedChild; // caller's child-cycle accumulator
+    };
+    bool instrument = false;
+    std::vector<ProfileSite> profileSites;
+    std::map<llvm::Function*, ProfileFrame> profileFrames;
+    llvm::Function *profileReportFunction = nullptr;
+
+    // -g: DWARF line tables plus function and variable DIEs
+    std::unique_ptr<llvm::DIBuilder> diBuilder;
+    llvm::DICompileUnit *diCompileUnit = nullptr;
+    llvm::DIFile *diFile = nullptr;
+    std::map<llvm::Function*, llvm::DISubprogram*> diSubprograms;
+    std::map<VarDeclStmt::Kind, llvm::DIType*> diTypes;
+
+    // Bounds-check failures share one cold block per function
+    BoundsMode boundsMode = BoundsMode::FULL;
+    llvm::Function *boundsFailHandler = nullptr;
+    std::map<llvm::Function*, std::pair<llvm::BasicBlock*, llvm::PHINode*>> boundsFailBlocks;
+    std::map<std::string, llvm::Value*> boundsVarNames;
+
+    // Set when the program calls into runtime/gozero_runtime.c (parallel for, go, channels)
+    bool usesRuntime = false;
+    bool usesTasks = false; // go statements: main joins all tasks before returning
+    std::map<llvm::Function*, llvm::Function*> goThunks; // specialization -> void(i8*) entry
+
+    // (array, index variable) pairs proven in range by the enclosing loops
+    std::set<std::pair<std::string, std::string>> provenIndexes;
+
     // Helper methods
     llvm::Value* createStringConstant(const std::string &str);
+    llvm::Value* createTruthTest(llvm::Value *value);
+    llvm::Value* generateCondition(const Expr *expr);
+    llvm::Value* convertValue(llvm::Value *value, llvm::Type *targetType);
+    llvm::Value* toSlot(llvm::Value *value, VarDeclStmt::Kind kind);
+    llvm::Value* fromSlot(llvm::Value *slot, VarDeclStmt::Kind kind);
+    llvm::Value* generateTyped(const Expr *expr, VarDeclStmt::Kind kind);
+    llvm::Value* generateArrayLiteral(const ArrayExpr *array, VarDeclStmt::Kind elemKind);
+    llvm::StructType* getArrayViewType(VarDeclStmt::Kind kind);
+    llvm::Value* getArrayLength(const std::string &name);
+    llvm::Value* getArrayLength(const Expr *arrayExpr);
+    llvm::Value* generateArrayView(const Expr *arrayExpr);
+    llvm::Value* generateSlice(const SliceExpr *slice);
+    void recordArrayLength(const std::string &name, const Expr *init);
+    void emitCountedLoop(llvm::Value *length, const std::string &name,
+                         const std::function<void(llvm::Value *index)> &body);
     llvm::Value* generateStringConcat(const Expr *left, const Expr *right);
+    llvm::Value* generateStringCompare(const BinaryExpr *bin);
     llvm::Value* generateArrayOperation(const Expr *left, const Expr *right, BinaryExpr::Op op);
     llvm::Value* generateArrayScalarOperation(const Expr *array, const Expr *scalar, BinaryExpr::Op op);
+    void optimizeModule(llvm::TargetMachine *targetMachine);
+    llvm::Function* getSpecialization(const FunctionStmt *stmt, const std::vector<VarDeclStmt::Kind> &argKinds);
+    void generateFunctionBody(const FunctionStmt *stmt, llvm::Function *function,
+                              const std::vector<VarDeclStmt::Kind> &paramKinds, VarDeclStmt::Kind returnKind);
+    llvm::Function* getBoundsFailHandler();
+    std::pair<llvm::BasicBlock*, llvm::PHINode*> getBoundsFailBlock(llvm::Function *function);
+    llvm::GlobalVariable* createProfileCounter(const std::string &name);
+    void incrementProfileCounter(llvm::GlobalVariable *counter, llvm::Value *amount = nullptr);
+    void emitProfileEntry(llvm::Function *function, const std::string &label, int line, int column);
+    void emitProfileExit();
+    size_t createLoopProfileSite(const std::string &label, int line, int column);
+    void emitProfileReport();
+    llvm::DIType* getDebugType(VarDeclStmt::Kind kind);
+    llvm::DISubprogram* createDebugFunction(llvm::Function *function, const std::string &name, int line,
+                                            VarDeclStmt::Kind returnKind,
+                                            const std::vector<VarDeclStmt::Kind> &paramKinds);
+    void emitDebugLocation(int line, int column);
+    bool matchCountingLoop(const Expr *cond, const Stmt *step,
+                           std::string &indexVar, const Expr *&bound, bool &inclusive);
+    void proveLoopIndexes(const std::string &indexVar, const Expr *lowerBound, const Expr *bound,
+                          bool inclusive, const std::vector<StmtPtr> &body, const Stmt *step);
+    void declareDebugVariable(const std::string &name, llvm::AllocaInst *alloca, VarDeclStmt::Kind kind,
+                              int line, int column, unsigned argNo = 0);
 
 public:
     CodeGenerator(llvm::LLVMContext &ctx, TypeAnalyzer &ta);
+
+    void setOptimizationLevel(int level);
+    void setProfileGenerate(const std::string &dir);
+    void setProfileUse(const std::string &profdataFile);
+    void setInstrument(bool enabled);
+    void setDebugInfo(const std::string &sourceFile);
+    void setBoundsMode(BoundsMode mode);
     
     void pushScope();
     void popScope();
@@ -39,24 +145,64 @@ public:
     void createBoundsCheck(llvm::Value *index, llvm::Value *size, const std::string &varName);
     void declareVariable(const std::string &name, llvm::AllocaInst *alloca);
     llvm::AllocaInst* createEntryBlockAlloca(const std::string &varName, llvm::Type *type);
+    llvm::Value* createHeapArray(llvm::Type *elementType, llvm::Value *length, const std::string &name);
     llvm::Type* getLLVMType(VarDeclStmt::Kind kind);
     
     void generateVarDecl(const VarDeclStmt *stmt);
     void generateInferDecl(const InferDeclStmt *stmt);
     void generateAssign(const AssignStmt *stmt);
+    void generateIndexAssign(const IndexAssignStmt *stmt);
     llvm::Value* generate(const Expr *expr);
+    llvm::Value* generateNode(const Expr *expr);
     
     void generatePrintStmt(const PrintStmt *stmt);
-    void printArrayElements(const std::string &arrayName, VarDeclStmt::Kind arrayType);
+    void printArrayElements(llvm::Value *arrayPtr, llvm::Value *length, VarDeclStmt::Kind arrayType);
     void generateStatement(const Stmt *stmt);
     void generateIf(const IfStmt *stmt);
     void generateWhile(const WhileStmt *stmt);
     void generateFor(const ForStmt *stmt);
+    void generateForIn(const ForInStmt *stmt);
+    void generateParallelFor(const ForStmt *stmt);
+    void generateGo(const GoStmt *stmt);
+    void generateSend(const SendStmt *stmt);
+    void generateClose(const CloseStmt *stmt);
+    llvm::Value* generateChan(const ChanExpr *expr);
+    llvm::Value* generateRecv(const RecvExpr *expr);
+    llvm::Value* emitChanRecv(llvm::Value *chan, VarDeclStmt::Kind elemKind, llvm::Value *&more);
+    llvm::Value* generateMap(const MapExpr *expr);
+    std::pair<llvm::Value*, llvm::Value*> generateMapKey(const Expr *keyExpr); // key, 64-bit hash
+    llvm::Value* generateMapGet(const IndexExpr *expr, VarDeclStmt::Kind mapKind);
+    void generateMapSet(const IndexAssignStmt *stmt, VarDeclStmt::Kind mapKind);
+    llvm::Value* generateMapBuiltin(const CallExpr *call);
+    llvm::Value* emitMapNext(llvm::Value *map, llvm::Value *cursor, llvm::Value *keyOut);
+    llvm::Value* generateFileBuiltin(const CallExpr *call);
+    llvm::Value* emitLinesOpen(const CallExpr *call);
+    llvm::Value* emitNextLine(llvm::Value *lines);
+    llvm::Value* generateReadBuiltin(const CallExpr *call);
+    llvm::Value* generateBuilderBuiltin(const CallExpr *call);
+    void emitBuilderAppend(llvm::Value *sb, const Expr *value);
+    llvm::Value* generateAsString(const Expr *expr);
+    llvm::Value* generateInterpolation(const InterpExpr *expr);
+    std::vector<std::string> beginLoopBuilders(const Stmt *loop);
+    void endLoopBuilders(const std::vector<std::string> &names);
+    void generateLoopAppend(const AssignStmt *stmt);
     void generateFunction(const FunctionStmt *stmt);
     void generateReturn(const ReturnStmt *stmt);
     
+    // --jit (src/jit.cpp): the specialization of stmt for argKinds plus an
+    // entry that takes and returns interpreter slots; nullptr when the code
+    // needs the runtime library, which the compiler process does not have
+    llvm::Function* generateJitEntry(const FunctionStmt *stmt, const std::vector<VarDeclStmt::Kind> &argKinds);
+    // cached sees the module before optimization; true skips the optimizer
+    // because its machine code is already in the object cache
+    std::unique_ptr<llvm::Module> takeJitModule(llvm::Function *entry, llvm::TargetMachine *targetMachine,
+                                                const std::function<bool(llvm::Module&)> &cached);
+
     void finalize();
     void printIR();
     void generateToObjectFile(const std::string &filename);
     void linkToExecutable(const std::string &objectFile, const std::string &executableName);
+
+    // $XDG_CACHE_HOME/gozero (~/.cache/gozero); empty without a home
+    static std::string cacheDirectory();
 };
@@ -0,0 +1,167 @@
+#pragma once
+#include "ast.h"
+#include "type_analyzer.h"
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+// Opcodes of the register bytecode run by --interp. Arithmetic and
+// comparisons are typed: _I works on int (wrapping at 32 bits), _L on int64
+// and bools, _F on float (rounded to 32 bits after every operation), _D on
+// double and _S on strings.
+#define GZ_OPCODES(X) \
+    X(MOVE) X(LOADK) \
+    X(ADD_I) X(SUB_I) X(MUL_I) X(DIV_I) \
+    X(ADD_L) X(SUB_L) X(MUL_L) X(DIV_L) \
+    X(ADD_F) X(SUB_F) X(MUL_F) X(DIV_F) \
+    X(ADD_D) X(SUB_D) X(MUL_D) X(DIV_D) \
+    X(EQ_L) X(NE_L) X(LT_L) X(LE_L) X(GT_L) X(GE_L) \
+    X(EQ_D) X(NE_D) X(LT_D) X(LE_D) X(GT_D) X(GE_D) \
+    X(EQ_S) X(NE_S) X(LT_S) X(LE_S) X(GT_S) X(GE_S) \
+    X(TRUTH_L) X(TRUTH_D) X(TO_I32) X(I2F) X(I2D) X(D2F) X(D2I) X(D2L) \
+    X(CONCAT) X(STR_L) X(STR_D) X(STR_CHAR) \
+    X(ARR_NEW) X(ARR_ALLOC) X(ARR_INIT) X(ARR_GET) X(ARR_SET) X(ARR_LEN) X(SLICE) \
+    X(SB_NEW) X(SB_APPEND_S) X(SB_APPEND_L) X(SB_APPEND_D) X(SB_FINISH) \
+    X(READ_INT) X(READ_FLOAT) X(READ_LINE) X(READ_FILE) \
+    X(PRINT_L) X(PRINT_D) X(PRINT_S) X(PRINT_C) X(PRINT_ARR) \
+    X(JMP) X(JMPF) X(JMPT) X(CALL) X(RET) X(RETV)
+
+class JitCompiler; // --jit only (include/jit.h); the VM itself needs no LLVM
+
+class Interpreter {
+public:
+    // Native code for a function: JitCompiler::Entry
+    using NativeEntry = int64_t (*)(const void *args);
+
+    enum class Op : uint16_t {
+#define GZ_OPCODE_ENUM(name) name,
+        GZ_OPCODES(GZ_OPCODE_ENUM)
+#undef GZ_OPCODE_ENUM
+    };
+
+    // a is the destination (or the register tested or stored into); jump
+    // targets and constant indexes take b and c together as 32 bits
+    struct Instr {
+        Op op;
+        uint16_t a = 0, b = 0, c = 0;
+        uint32_t wide() const { return b | (static_cast<uint32_t>(c) << 16); }
+    };
+
+    struct Array;
+    union Slot {
+        int64_t i; // int, int64 and bool (0/1); int stays sign-extended
+        double f;  // float and double; a float holds a value rounded to 32 bits
+        const char *s;
+        Array *array;
+        std::string *builder;
+    };
+    // Arrays are views, like the compiled code's: slices share the data
+    struct Array {
+        Slot *data;
+        int64_t length;
+    };
+
+    struct Function {
+        std::string name;
+        std::vector<Instr> code;
+        std::vector<Slot> constants;
+        uint16_t numParams = 0;
+        uint16_t numRegisters = 0;
+        std::map<uint32_t, std::string> checkNames; // pc of a bounds check -> name in its error
+
+        // The specialization this is (main has no decl), for the JIT
+        const FunctionStmt *decl = nullptr;
+        std::vector<VarDeclStmt::Kind> paramKinds;
+        VarDeclStmt::Kind returnKind = VarDeclStmt::VOID;
+        uint32_t heat = 0; // calls plus loop back-edges taken
+        std::atomic<NativeEntry> native{nullptr}; // set once compiled
+    };
+
+    explicit Interpreter(TypeAnalyzer &analyzer);
+
+    // Compile the whole program; main is functions[0]
+    void compile(const std::vector<StmtPtr> &program);
+    // --jit: send hot functions to this compiler (see src/jit.cpp)
+    void setJit(JitCompiler *compiler) { jit = compiler; }
+    // Run main; returns the process exit code
+    int run();
+
+private:
+    TypeAnalyzer &typeAnalyzer;
+    std::vector<std::unique_ptr<Function>> functions;
+    std::map<std::string, const FunctionStmt*> functionDecls;
+    std::map<std::string, uint16_t> specializations; // mangled name -> index in functions
+    std::set<std::string> literals; // string constants, kept alive for the run
+    JitCompiler *jit = nullptr;
+
+    // State of the function being compiled
+    struct Local {
+        uint16_t reg;
+        VarDeclStmt::Kind kind;
+    };
+    Function *fn = nullptr;
+    VarDeclStmt::Kind returnKind = VarDeclStmt::VOID;
+    std::vector<std::map<std::string, Local>> scopes;
+    uint16_t nextReg = 0;  // first free register
+    uint16_t localTop = 0; // registers below it hold variables
+    std::vector<uint16_t> scopeMarks; // localTop when each scope opened
+    uint32_t labelPc = UINT32_MAX; // a jump lands on the next instruction
+
+    // Storage created while running; never freed before exit, like the
+    // runtime's strings
+    std::vector<std::unique_ptr<char[]>> strings;
+    std::vector<std::unique_ptr<Slot[]>> arrayData;
+    std::vector<std::unique_ptr<Array>> arrays;
+    std::vector<std::unique_ptr<std::string>> builders;
+
+    // Bytecode compiler (src/bytecode.cpp)
+    [[noreturn]] void unsupported(const std::string &what, int line, int column);
+    uint32_t emit(Op op, uint16_t a = 0, uint16_t b = 0, uint16_t c = 0);
+    uint32_t emitJump(Op op, uint16_t reg = 0);
+    void patchJump(uint32_t at, uint32_t target);
+    uint16_t newRegister();
+    uint16_t newLocal(const std::string &name, VarDeclStmt::Kind kind); // empty name: hidden
+    const Local *findLocal(const std::string &name) const;
+    uint32_t constant(Slot value);
+    uint16_t loadConstant(Slot value, uint16_t dest);
+    void moveTo(uint16_t src, uint16_t dest);
+    const char *internString(const std::string &text);
+    void pushScope();
+    void popScope();
+
+    void compileStatement(const Stmt *stmt);
+    void compileBlock(const std::vector<StmtPtr> &body);
+    void compileDecl(const std::string &name, VarDeclStmt::Kind kind, const Expr *init, bool typed);
+    void compileAssign(const AssignStmt *stmt);
+    void compileIndexAssign(const IndexAssignStmt *stmt);
+    void compilePrint(const PrintStmt *stmt);
+    void compileIf(const IfStmt *stmt);
+    void compileWhile(const WhileStmt *stmt);
+    void compileFor(const ForStmt *stmt);
+    void compileForIn(const ForInStmt *stmt);
+    void compileReturn(const ReturnStmt *stmt);
+
+    uint16_t compileExpr(const Expr *expr);
+    void compileExprTo(const Expr *expr, VarDeclStmt::Kind kind, uint16_t dest);
+    uint16_t compileTyped(const Expr *expr, VarDeclStmt::Kind kind);
+    uint16_t compileCondition(const Expr *expr);
+    void convert(uint16_t src, VarDeclStmt::Kind from, VarDeclStmt::Kind to, uint16_t dest, const Expr *where);
+    uint16_t compileBinary(const BinaryExpr *bin);
+    uint16_t compileArrayOperation(const BinaryExpr *bin);
+    uint16_t compileAsString(const Expr *expr);
+    uint16_t compileIndex(const IndexExpr *index);
+    uint16_t compileCall(const CallExpr *call);
+    void compileAppend(uint16_t builder, const Expr *value);
+    uint16_t specialize(const FunctionStmt *decl, const std::vector<VarDeclStmt::Kind> &argKinds);
+
+    // Virtual machine (src/interpreter.cpp)
+    const char *newString(const char *data, size_t length);
+    Array *newArray(int64_t length);
+    Array *newView(Slot *data, int64_t length);
+    void requestJit(Function *function);
+    int execute();
+};
@@ -0,0 +1,31 @@
+#pragma once
+#include "ast.h"
+#include "type_analyzer.h"
+#include "code_generator.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Tiered execution (--jit): the interpreter asks for hot functions and keeps
+// running while a background thread compiles them with CodeGenerator into an
+// ORC JIT; once compiled, the function's entry pointer is set and later
+// calls run native code. No LLVM is initialized until the first request.
+class JitCompiler {
+public:
+    // i64 entry(i64 *args): arguments and the result in interpreter slots
+    using Entry = int64_t (*)(const void *args);
+
+    JitCompiler(const std::vector<StmtPtr> &program, TypeAnalyzer &analyzer, int optLevel,
+                CodeGenerator::BoundsMode boundsMode);
+    ~JitCompiler(); // waits for the compilation in progress, drops the rest
+
+    // Compile the specialization of decl for argKinds and store its entry in
+    // *entry; on failure (it needs the runtime library) *entry stays null
+    void request(const FunctionStmt *decl, const std::vector<VarDeclStmt::Kind> &argKinds,
+                 std::atomic<Entry> *entry);
+
+private:
+    struct State; // worker thread, queue and the LLJIT (src/jit.cpp)
+    std::unique_ptr<State> state;
+};
@@ -22,4 +22,11 @@ class Lexer {
 public:
     Lexer(const std::string &s);
     std::vector<Token> tokenize();
+
+    // String interpolation scanning, shared with Parser::parseInterpolation:
+    // the index of the '"' closing a string whose text starts at `from`, and
+    // of the '}' closing a ${ whose expression starts at `from` (npos if
+    // missing)
+    static size_t stringEnd(const std::string &text, size_t from);
+    static size_t interpolationEnd(const std::string &text, size_t from);
 };
@@ -12,6 +12,20 @@ class Parser {
     bool match(TokenType t);
     bool check(TokenType t) const;
     void expect(TokenType t, const std::string &msg);
+
+    // Type keywords (int, int64, float, double, string, bool)
+    static bool isTypeKeyword(TokenType t);
+    static VarDeclStmt::Kind typeKeywordKind(TokenType t);
+    VarDeclStmt::Kind parseChanElementType(); // the T of `chan T`
+    VarDeclStmt::Kind parseMapValueType(); // the T of `map[string]T`
+
+    // Stamp a freshly built node with the source position of a token
+    template <typename T>
+    std::unique_ptr<T> at(std::unique_ptr<T> node, const Token &tok) {
+        node->line = tok.line;
+        node->column = tok.column;
+        return node;
+    }
     
     ExprPtr parseExpression();
     ExprPtr parseOr();
@@ -23,11 +37,13 @@ class Parser {
     ExprPtr parseUnary();
     ExprPtr parsePrimary();
     ExprPtr parseArray();
+    ExprPtr parseInterpolation(const Token &stringToken);
     
     std::vector<StmtPtr> parseBlock();
     StmtPtr parseIf();
     StmtPtr parseWhile();
     StmtPtr parseFor();
+    StmtPtr parseForIn();
     StmtPtr parseForInitOrDecl();
     StmtPtr parseForPost();
     StmtPtr parseFunction(bool inference);
@@ -3,11 +3,12 @@
 
 enum class TokenType {
     // Keywords
-    IF, ELSE, WHILE, FOR, FUN, RETURN, VOID,
+    IF, ELSE, WHILE, FOR, IN, PARALLEL, GO, FUN, RETURN, VOID,
+    CHAN, SEND, RECV, CLOSE, MAP,
     
     // Types and literals
-    INT, FLOAT, STRING, IDENT,
-    INT_LITERAL, FLOAT_LITERAL, STRING_LITERAL,
+    INT, FLOAT, STRING, BOOL, INT64, DOUBLE, IDENT,
+    INT_LITERAL, FLOAT_LITERAL, STRING_LITERAL, TRUE, FALSE,
 
     // Operators
     ASSIGN, COLON_ASSIGN,  // = and :=
@@ -17,7 +18,7 @@ enum class TokenType {
     PLUS, MINUS, MUL, DIV,
 
     // Punctuation
-    PRINT, SEMICOLON, LPAREN, RPAREN, LBRACE, RBRACE, LBRACKET, RBRACKET, COMMA, EOF_TOKEN
+    PRINT, SEMICOLON, COLON, LPAREN, RPAREN, LBRACE, RBRACE, LBRACKET, RBRACKET, COMMA, EOF_TOKEN
 };
 
 struct Token {
@@ -1,41 +1,100 @@
 #pragma once
 #include "ast.h"
 #include <map>
+#include <set>
 #include <vector>
+#include <cstddef>
 
 class TypeAnalyzer {
     std::vector<std::map<std::string, VarDeclStmt::Kind>> scopes;
     std::map<std::string, VarDeclStmt::Kind> functions; // function name -> return type
-    std::map<std::string, std::vector<VarDeclStmt::Kind>> functionParams; // function name -> parameter types
+    std::map<std::string, std::vector<std::vector<VarDeclStmt::Kind>>> functionSignatures; // function name -> argument types per distinct call
+    std::map<std::string, const FunctionStmt*> functionDecls; // function name -> declaration
+
+    // Return types of `fun` functions, inferred per argument-type tuple. While a
+    // signature is on the inference stack its entry holds the current fixpoint
+    // approximation (VOID is the bottom of the lattice)
+    using Signature = std::pair<std::string, std::vector<VarDeclStmt::Kind>>;
+    std::map<Signature, VarDeclStmt::Kind> returnTypes;
+    std::vector<Signature> inferenceStack;
+    std::vector<Signature> tentativeReturnTypes; // computed from an approximation
+    size_t lowestDependency = SIZE_MAX; // lowest stack slot read by the current analysis
+    bool verbose = true; // progress messages on stdout
 
 public:
     TypeAnalyzer();
+    // --interp turns progress messages off: stdout belongs to the program
+    void setVerbose(bool enabled) { verbose = enabled; }
     
     void pushScope();
     void popScope();
     
     VarDeclStmt::Kind inferType(const Expr *expr);
+
+    // Kind helpers: arrays, element kinds and numeric promotion
+    // (bool < int < int64 < float < double; int64 with float gives double)
+    static bool isArrayType(VarDeclStmt::Kind kind);
+    static bool isChanType(VarDeclStmt::Kind kind);
+    static bool isMapType(VarDeclStmt::Kind kind);
+    static bool isNumericType(VarDeclStmt::Kind kind);
+    static VarDeclStmt::Kind elementType(VarDeclStmt::Kind containerKind); // arrays, chans, map values
+    static VarDeclStmt::Kind chanTypeOf(VarDeclStmt::Kind elementKind);
+    static VarDeclStmt::Kind mapTypeOf(VarDeclStmt::Kind valueKind);
+    static VarDeclStmt::Kind arrayTypeOf(VarDeclStmt::Kind elementKind);
+    static VarDeclStmt::Kind promoteNumeric(VarDeclStmt::Kind left, VarDeclStmt::Kind right);
     
     void declareFunction(const std::string &name, VarDeclStmt::Kind returnType);
-    void setFunctionParams(const std::string &name, const std::vector<VarDeclStmt::Kind> &paramTypes);
-    std::vector<VarDeclStmt::Kind> getFunctionParams(const std::string &name);
+    void registerFunction(const FunctionStmt *funcStmt);
+    VarDeclStmt::Kind inferReturnType(const std::string &name, const std::vector<VarDeclStmt::Kind> &argTypes);
+    void addFunctionSignature(const std::string &name, const std::vector<VarDeclStmt::Kind> &paramTypes);
+    std::vector<std::vector<VarDeclStmt::Kind>> getFunctionSignatures(const std::string &name);
     bool hasFunction(const std::string &name);
     
     void declareVariable(const std::string &name, VarDeclStmt::Kind type);
     VarDeclStmt::Kind getVariableType(const std::string &name);
     bool hasVariable(const std::string &name);
     
-    // Analyze function calls to infer parameter types
-    void analyzeCallExpr(const CallExpr *call);
+    // Analyze function calls to infer parameter types; returns the argument types
+    std::vector<VarDeclStmt::Kind> analyzeCallExpr(const CallExpr *call);
+    // len(a) on arrays, slices and maps, unless the program declares its own `len`
+    bool isLenBuiltin(const CallExpr *call);
+    // has(m, k) -> bool and delete(m, k); map keys are always strings
+    bool isMapBuiltin(const CallExpr *call);
+    void mapKeyCheck(const Expr *key, int line, int column);
+    // readFile(path) -> string, mapInts/mapFloats(path) -> array views of a
+    // binary file, lines(path) -> only as the iterable of a for-in
+    bool isFileBuiltin(const CallExpr *call);
+    bool isLinesIterable(const Expr *expr);
+    // readInt() -> int, readFloat() -> float, readLine() -> string (stdin)
+    bool isReadBuiltin(const CallExpr *call);
+    // builder() -> builder, append(b, x) with x a number or string,
+    // toString(b) -> string
+    bool isBuilderBuiltin(const CallExpr *call);
     void analyzeExpression(const Expr *expr);
     void analyzeStatement(const Stmt *stmt);
 
+    // Channels: the element kind of a channel operand, and send(c, v) checks
+    // (numbers convert to the element kind, strings only go to chan string)
+    VarDeclStmt::Kind channelElementType(const Expr *chanExpr, int line, int column);
+    VarDeclStmt::Kind analyzeSend(const SendStmt *stmt);
+
+    // for x in iterable: the kind bound to x (arrays and channels only)
+    VarDeclStmt::Kind forInElementType(const ForInStmt *stmt);
+
     // Helper function to detect if a function has explicit return statements
     bool hasExplicitReturn(const std::vector<StmtPtr> &body);
+    VarDeclStmt::Kind analyzeReturnType(const FunctionStmt *funcStmt, const std::vector<VarDeclStmt::Kind> &argTypes);
+    void collectReturnTypes(const Stmt *stmt, const std::string &functionName, VarDeclStmt::Kind &result);
     VarDeclStmt::Kind getFunctionReturnType(const std::string &name);
     
     // Validate function scopes to detect invalid variable access
     void validateFunctionScopes(const FunctionStmt *funcStmt);
     void validateExpressionInFunctionScope(const Expr *expr, const std::map<std::string, VarDeclStmt::Kind> &localVars, const std::string &functionName);
     void validateStatementInFunctionScope(const Stmt *stmt, const std::map<std::string, VarDeclStmt::Kind> &localVars, const std::string &functionName);
+
+    // parallel for: iterations may only write their own locals and array
+    // elements; shared scalars (including the index) are read-only
+    void validateParallelBody(const ForStmt *forStmt);
+    void validateParallelStatement(const Stmt *stmt, std::set<std::string> &locals);
+    void validateParallelExpression(const Expr *expr, const std::set<std::string> &locals);
 };
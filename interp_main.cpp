@@ -0,0 +1,66 @@
+#include "include/lexer.h"
+#include "include/parser.h"
+#include "include/type_analyzer.h"
+#include "include/interpreter.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+// gozero-interp: `gozero archivo.goz --interp` without LLVM. It links only
+// the front end and the bytecode VM, so starting it does not load the LLVM
+// shared libraries that dominate a short script's run time under gozero.
+int main(int argc, char* argv[]) {
+    std::string filename;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--interp") continue; // accepted, like gozero's
+        if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "Error: gozero-interp no admite '" << arg
+                      << "'; usa gozero para compilar o para --jit\n";
+            return 1;
+        }
+        filename = arg;
+    }
+    if (filename.empty()) {
+        std::cerr << "Uso: gozero-interp archivo.goz\n";
+        return 1;
+    }
+
+    std::ifstream infile(filename);
+    if (!infile) {
+        std::cerr << "No se pudo abrir " << filename << "\n";
+        return 1;
+    }
+    std::stringstream buffer;
+    buffer << infile.rdbuf();
+    std::string source = buffer.str();
+
+    Lexer lexer(source);
+    auto tokens = lexer.tokenize();
+    Parser parser(tokens);
+    auto stmts = parser.parse();
+
+    // Same checks as gozero, without its progress messages
+    TypeAnalyzer typeAnalyzer;
+    typeAnalyzer.setVerbose(false);
+    for (const auto &stmt : stmts) {
+        if (auto *funcStmt = dynamic_cast<const FunctionStmt*>(stmt.get())) {
+            typeAnalyzer.registerFunction(funcStmt);
+        }
+    }
+    for (const auto &stmt : stmts) {
+        if (auto *funcStmt = dynamic_cast<const FunctionStmt*>(stmt.get())) {
+            typeAnalyzer.validateFunctionScopes(funcStmt);
+        }
+    }
+
+    Interpreter interpreter(typeAnalyzer);
+    interpreter.compile(stmts);
+    return interpreter.run();
+}
+
+/*
+Compilar con:
+clang++ -O2 -std=c++17 -DGOZERO_NO_JIT interp_main.cpp src/lexer.cpp src/parser.cpp src/type_analyzer.cpp src/bytecode.cpp src/interpreter.cpp -o gozero-interp
+./gozero-interp archivo.goz
+*/
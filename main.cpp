@@ -2,6 +2,8 @@
 #include "include/parser.h"
 #include "include/type_analyzer.h"
 #include "include/code_generator.h"
+#include "include/interpreter.h"
+#include "include/jit.h"
 #include <llvm/IR/LLVMContext.h>
 #include <iostream>
 #include <fstream>
@@ -10,15 +12,61 @@
 int main(int argc, char* argv[]) {
     std::string filename = "mini_input.txt"; // default
     bool showIR = false;
+    int optLevel = 0;
+    bool profileGenerate = false;
+    std::string profileGenerateDir;
+    std::string profileUseFile;
+    bool instrument = false;
+    bool debugInfo = false;
+    bool interpret = false;
+    bool tiered = false;
+    CodeGenerator::BoundsMode boundsMode = CodeGenerator::BoundsMode::FULL;
     // Analizar argumentos
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         if (arg == "--ir" || arg == "-i") {
             showIR = true;
+        } else if (arg.size() == 3 && arg[0] == '-' && arg[1] == 'O' && arg[2] >= '0' && arg[2] <= '3') {
+            optLevel = arg[2] - '0';
+        } else if (arg == "--profile-generate") {
+            profileGenerate = true;
+        } else if (arg.rfind("--profile-generate=", 0) == 0) {
+            profileGenerate = true;
+            profileGenerateDir = arg.substr(std::string("--profile-generate=").size());
+        } else if (arg == "-g") {
+            debugInfo = true;
+        } else if (arg.rfind("--bounds=", 0) == 0) {
+            std::string mode = arg.substr(std::string("--bounds=").size());
+            if (mode == "full") boundsMode = CodeGenerator::BoundsMode::FULL;
+            else if (mode == "trap") boundsMode = CodeGenerator::BoundsMode::TRAP;
+            else if (mode == "off") boundsMode = CodeGenerator::BoundsMode::OFF;
+            else {
+                std::cerr << "Error: modo de --bounds desconocido '" << mode << "' (use full, trap u off)\n";
+                return 1;
+            }
+        } else if (arg == "--interp") {
+            interpret = true;
+        } else if (arg == "--jit") {
+            interpret = true;
+            tiered = true;
+        } else if (arg == "--instrument") {
+            instrument = true;
+        } else if (arg.rfind("--profile-use=", 0) == 0) {
+            profileUseFile = arg.substr(std::string("--profile-use=").size());
         } else {
             filename = arg;
         }
     }
+
+    if (profileGenerate && !profileUseFile.empty()) {
+        std::cerr << "Error: --profile-generate y --profile-use no se pueden usar juntos\n";
+        return 1;
+    }
+    if (!profileUseFile.empty() && !std::ifstream(profileUseFile)) {
+        std::cerr << "No se pudo abrir el perfil " << profileUseFile
+                  << " (genera uno con llvm-profdata merge)\n";
+        return 1;
+    }
     
     std::ifstream infile(filename);
     if (!infile) {
@@ -39,36 +87,52 @@ int main(int argc, char* argv[]) {
 
     // Type analysis
     TypeAnalyzer typeAnalyzer;
+    typeAnalyzer.setVerbose(!interpret);
     
-    // First pass: Declare all functions
+    // First pass: Declare all functions (`fun` return types are inferred per call)
     for (const auto &stmt : stmts) {
         if (auto *funcStmt = dynamic_cast<const FunctionStmt*>(stmt.get())) {
-            VarDeclStmt::Kind retType;
-            if (funcStmt->inference) {
-                // For inference functions, determine return type based on whether there's an explicit return
-                if (typeAnalyzer.hasExplicitReturn(funcStmt->body)) {
-                    retType = VarDeclStmt::INT; // Assume int if there's a return
-                } else {
-                    retType = VarDeclStmt::VOID; // Void if no return
-                }
-            } else {
-                retType = funcStmt->retType;
-            }
-            typeAnalyzer.declareFunction(funcStmt->name, retType);
+            typeAnalyzer.registerFunction(funcStmt);
         }
     }
 
     // Second pass: Validate all functions for scope errors
-    std::cout << "=== Validando scopes de funciones ===\n";
+    if (!interpret) std::cout << "=== Validando scopes de funciones ===\n";
     for (const auto &stmt : stmts) {
         if (auto *funcStmt = dynamic_cast<const FunctionStmt*>(stmt.get())) {
             typeAnalyzer.validateFunctionScopes(funcStmt);
         }
     }
 
+    // --interp: run the program now on the bytecode VM, without LLVM.
+    // --jit also compiles hot functions in the background (at -O2 unless
+    // another level is given)
+    if (interpret) {
+        Interpreter interpreter(typeAnalyzer);
+        interpreter.compile(stmts);
+        std::unique_ptr<JitCompiler> jit;
+        if (tiered) {
+            jit = std::make_unique<JitCompiler>(stmts, typeAnalyzer, optLevel ? optLevel : 2, boundsMode);
+            interpreter.setJit(jit.get());
+        }
+        return interpreter.run();
+    }
+
     // Code generation
     llvm::LLVMContext context;
     CodeGenerator generator(context, typeAnalyzer);
+    generator.setOptimizationLevel(optLevel);
+    generator.setBoundsMode(boundsMode);
+    if (debugInfo) {
+        generator.setDebugInfo(filename);
+    }
+    if (profileGenerate) {
+        generator.setProfileGenerate(profileGenerateDir);
+    }
+    if (!profileUseFile.empty()) {
+        generator.setProfileUse(profileUseFile);
+    }
+    generator.setInstrument(instrument);
 
     std::cout << "=== Generando codigo intermedio ===\n";
     for (const auto &stmt : stmts) {
@@ -0,0 +1,1640 @@
+// GoZero runtime support, linked into programs that need it (see
+// CodeGenerator::linkToExecutable).
+//
+// parallel for: gz_parallel_for(body, ctx, lo, hi) runs body(ctx, a, b) over
+// disjoint chunks covering [lo, hi) on a pool of worker threads sized to the
+// machine (GOZERO_THREADS overrides it). Each worker owns a span of the
+// iteration space and takes grain-sized chunks from its front; a worker whose
+// span is empty steals the back half of another worker's span. The calling
+// thread works as worker 0 and returns once every chunk has run. A parallel
+// for nested inside another runs sequentially on the calling worker.
+//
+// go f(args): gz_go(fn, arg) starts fn(arg) as a green thread. Tasks run on
+// their own mmap'ed stacks (with a guard page) and are multiplexed by
+// ucontext switches over a second set of worker threads (M:N). Each worker
+// has a FIFO run queue; gz_go from a task pushes to its own worker, from the
+// main thread round-robin. An idle worker steals from the others before it
+// sleeps. gz_join_all() blocks until every task has finished; the compiler
+// calls it before main returns. gz_task_park/gz_task_ready let runtime
+// primitives block a task without blocking its worker. gz_prof_child gives
+// --instrument a callee-cycle accumulator that follows the task.
+//
+// Channels: gz_chan_new/send/recv/close. Each channel is a bounded MPMC ring
+// (Vyukov's sequence-numbered cells) whose producer and consumer cursors sit
+// on their own cache lines, so send and recv are lock-free when the ring is
+// neither full nor empty. Only a blocked sender or receiver takes the
+// channel lock: green threads park on the scheduler, other threads wait on
+// a condition variable. A channel of capacity 0 has no ring: send and recv
+// meet under the lock and the value passes from one waiter to the other, so
+// a send returns only once a receiver has taken it, as in Go.
+//
+// Strings: gz_str_eq/gz_str_cmp back ==, != and the ordering operators on
+// strings. Equal pointers (interned literals) answer at once; otherwise 16
+// bytes (SSE2) or 8 bytes (SWAR) are compared per step, looking for the
+// first difference or terminator in the same pass. gz_str_concat backs +:
+// results of up to GZ_STR_SMALL bytes are carved from a per-thread bump
+// arena, longer ones are malloc'ed. Strings are never freed.
+//
+// String interpolation: the compiler sizes "a=${x}" up front and fills one
+// gz_str_alloc'ed buffer in place, formatting numbers with gz_fmt_int and
+// gz_fmt_float. gz_fmt_float prints %f itself for magnitudes below 1e15
+// (exactly as printf rounds) and only falls back to snprintf above that.
+//
+// String builders: gz_sb_* back builder()/append/toString and the loops the
+// compiler rewrites from s = s + x. The buffer doubles when full and
+// gz_sb_finish hands it over as the string, leaving the builder empty.
+//
+// Maps: gz_map_new/get/set/has/delete/len/next implement map[string]T as a
+// Swiss table. One control byte per slot holds EMPTY, DELETED or 7 bits of
+// the key's hash; a probe compares a whole group of control bytes against
+// those bits at once (SSE2, or 8 bytes at a time with SWAR elsewhere) and
+// only touches slots whose byte matches. Callers pass the key's 64-bit hash
+// (gz_str_hash, or a constant the compiler computed for a literal key) and
+// slots keep it, so growing never hashes a string again. Keys are owned by
+// the map and freed on delete; for-in gets copies. Maps are not safe for
+// concurrent writers.
+//
+// Files: gz_file_read/array/lines back readFile, mapInts/mapFloats and
+// lines. The file is mmap'ed over an anonymous reservation one byte larger
+// than it, so the data is always followed by a NUL and can be handed out as
+// a C string without copying. Mappings are private and never unmapped:
+// strings and arrays taken from them may live until the program exits.
+//
+// Standard input: gz_read_int/float/line back readInt, readFloat and
+// readLine. Input is read into one 1 MiB buffer and parsed in place;
+// integers take up to 8 digits per step with SWAR arithmetic on a 64-bit
+// word. At end of input numbers read as 0 and lines as "". Not safe to call
+// from several threads at once.
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <ucontext.h>
+#include <unistd.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+typedef void (*gz_range_fn)(void *ctx, int64_t lo, int64_t hi);
+
+typedef struct {
+    pthread_mutex_t lock;
+    int64_t next; // remaining iterations are [next, end)
+    int64_t end;
+    char pad[64];
+} gz_span;
+
+static struct {
+    pthread_once_t once;
+    int workers;
+    gz_span *spans;
+    pthread_mutex_t submit; // one job at a time
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    unsigned long generation;
+    int running; // helper threads still working on the current job
+    gz_range_fn fn;
+    void *ctx;
+    int64_t grain;
+} gz_pool = { .once = PTHREAD_ONCE_INIT,
+              .submit = PTHREAD_MUTEX_INITIALIZER,
+              .lock = PTHREAD_MUTEX_INITIALIZER,
+              .start = PTHREAD_COND_INITIALIZER,
+              .done = PTHREAD_COND_INITIALIZER };
+
+static __thread int gz_in_parallel;
+
+// Take the next chunk of worker id's own span
+static int gz_take(int id, int64_t *lo, int64_t *hi) {
+    gz_span *span = &gz_pool.spans[id];
+    int found = 0;
+    pthread_mutex_lock(&span->lock);
+    if (span->next < span->end) {
+        *lo = span->next;
+        *hi = span->end - span->next > gz_pool.grain ? span->next + gz_pool.grain : span->end;
+        span->next = *hi;
+        found = 1;
+    }
+    pthread_mutex_unlock(&span->lock);
+    return found;
+}
+
+// Move the back half of some other worker's span into worker id's span
+static int gz_steal(int id) {
+    for (int k = 1; k < gz_pool.workers; k++) {
+        int victim = (id + k) % gz_pool.workers;
+        gz_span *span = &gz_pool.spans[victim];
+        int64_t lo = 0, hi = 0;
+        pthread_mutex_lock(&span->lock);
+        int64_t remaining = span->end - span->next;
+        if (remaining > 0) {
+            lo = remaining > gz_pool.grain ? span->next + remaining / 2 : span->next;
+            hi = span->end;
+            span->end = lo;
+        }
+        pthread_mutex_unlock(&span->lock);
+        if (hi > lo) {
+            gz_span *own = &gz_pool.spans[id];
+            pthread_mutex_lock(&own->lock);
+            own->next = lo;
+            own->end = hi;
+            pthread_mutex_unlock(&own->lock);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void gz_run_job(int id) {
+    int64_t lo, hi;
+    gz_in_parallel = 1;
+    for (;;) {
+        while (gz_take(id, &lo, &hi)) {
+            gz_pool.fn(gz_pool.ctx, lo, hi);
+        }
+        if (!gz_steal(id)) break;
+    }
+    gz_in_parallel = 0;
+}
+
+static void *gz_worker_main(void *arg) {
+    int id = (int)(intptr_t)arg;
+    unsigned long seen = 0;
+    for (;;) {
+        pthread_mutex_lock(&gz_pool.lock);
+        while (gz_pool.generation == seen) {
+            pthread_cond_wait(&gz_pool.start, &gz_pool.lock);
+        }
+        seen = gz_pool.generation;
+        pthread_mutex_unlock(&gz_pool.lock);
+
+        gz_run_job(id);
+
+        pthread_mutex_lock(&gz_pool.lock);
+        if (--gz_pool.running == 0) {
+            pthread_cond_signal(&gz_pool.done);
+        }
+        pthread_mutex_unlock(&gz_pool.lock);
+    }
+    return NULL;
+}
+
+// One worker per online CPU unless GOZERO_THREADS says otherwise
+static int gz_worker_count(void) {
+    long workers = sysconf(_SC_NPROCESSORS_ONLN);
+    const char *env = getenv("GOZERO_THREADS");
+    if (env && atoi(env) > 0) workers = atoi(env);
+    return workers < 1 ? 1 : (int)workers;
+}
+
+static void gz_pool_init(void) {
+    int workers = gz_worker_count();
+
+    gz_pool.workers = workers;
+    gz_pool.spans = calloc((size_t)workers, sizeof(gz_span));
+    for (int i = 0; i < gz_pool.workers; i++) {
+        pthread_mutex_init(&gz_pool.spans[i].lock, NULL);
+    }
+    for (int i = 1; i < gz_pool.workers; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, gz_worker_main, (void *)(intptr_t)i) != 0) {
+            gz_pool.workers = i; // run with the threads we got
+            break;
+        }
+        pthread_detach(thread);
+    }
+}
+
+void gz_parallel_for(gz_range_fn fn, void *ctx, int64_t lo, int64_t hi) {
+    if (hi <= lo) return;
+    if (gz_in_parallel || hi - lo == 1) {
+        fn(ctx, lo, hi);
+        return;
+    }
+    pthread_once(&gz_pool.once, gz_pool_init);
+    if (gz_pool.workers == 1) {
+        fn(ctx, lo, hi);
+        return;
+    }
+
+    pthread_mutex_lock(&gz_pool.submit);
+    int workers = gz_pool.workers;
+    int64_t total = hi - lo;
+
+    // About 8 chunks per worker keeps stealing cheap but balances uneven bodies
+    gz_pool.fn = fn;
+    gz_pool.ctx = ctx;
+    gz_pool.grain = total / ((int64_t)workers * 8);
+    if (gz_pool.grain < 1) gz_pool.grain = 1;
+    for (int i = 0; i < workers; i++) {
+        gz_span *span = &gz_pool.spans[i];
+        pthread_mutex_lock(&span->lock);
+        span->next = lo + total * i / workers;
+        span->end = lo + total * (i + 1) / workers;
+        pthread_mutex_unlock(&span->lock);
+    }
+
+    pthread_mutex_lock(&gz_pool.lock);
+    gz_pool.running = workers - 1;
+    gz_pool.generation++;
+    pthread_cond_broadcast(&gz_pool.start);
+    pthread_mutex_unlock(&gz_pool.lock);
+
+    gz_run_job(0);
+
+    pthread_mutex_lock(&gz_pool.lock);
+    while (gz_pool.running > 0) {
+        pthread_cond_wait(&gz_pool.done, &gz_pool.lock);
+    }
+    pthread_mutex_unlock(&gz_pool.lock);
+    pthread_mutex_unlock(&gz_pool.submit);
+}
+
+// ---------------------------------------------------------------------------
+// Green threads
+
+#define GZ_STACK_SIZE (256 * 1024) // reserved lazily by the kernel
+#define GZ_STACK_CACHE 64          // free stacks kept per worker
+#define GZ_STACK_POOL 1024         // free stacks shared by all threads
+
+typedef enum { GZ_TASK_RUNNABLE, GZ_TASK_PARKED, GZ_TASK_DONE } gz_task_state;
+
+typedef struct gz_task {
+    ucontext_t context;
+    void (*fn)(void *arg);
+    void *arg;
+    char *stack;
+    gz_task_state state;
+    uint64_t prof_child; // --instrument: cycles spent in callees (gz_prof_child)
+    struct gz_task *next; // run queue link
+} gz_task;
+
+typedef struct {
+    pthread_mutex_t lock;
+    gz_task *head; // FIFO run queue
+    gz_task *tail;
+    ucontext_t scheduler;     // the worker's own stack
+    gz_task *current;
+    pthread_mutex_t *unlock_after_switch; // released once the parked task is off its stack
+    char *free_stacks[GZ_STACK_CACHE];
+    int free_count;
+    char pad[64];
+} gz_sched_worker;
+
+static struct {
+    pthread_once_t once;
+    int workers;
+    gz_sched_worker *queues;
+    long queued;  // tasks sitting in some run queue
+    long live;    // tasks started and not finished
+    long sleepers; // workers waiting on `idle`
+    unsigned spread; // round-robin target for gz_go outside tasks
+    pthread_mutex_t idle_lock;
+    pthread_cond_t idle;
+    pthread_mutex_t join_lock;
+    pthread_cond_t joined;
+} gz_sched = { .once = PTHREAD_ONCE_INIT,
+               .idle_lock = PTHREAD_MUTEX_INITIALIZER,
+               .idle = PTHREAD_COND_INITIALIZER,
+               .join_lock = PTHREAD_MUTEX_INITIALIZER,
+               .joined = PTHREAD_COND_INITIALIZER };
+
+static struct {
+    pthread_mutex_t lock;
+    char *stacks[GZ_STACK_POOL];
+    int count;
+} gz_stacks = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static __thread gz_sched_worker *gz_self; // set on scheduler worker threads
+
+// A task can resume on another thread than the one it was suspended on, so
+// code on a task stack must re-read gz_self instead of a cached thread pointer
+__attribute__((noinline)) static gz_sched_worker *gz_worker_self(void) {
+    gz_sched_worker *self = gz_self;
+    __asm__ volatile("" ::: "memory");
+    return self;
+}
+
+static void gz_push(gz_sched_worker *worker, gz_task *task) {
+    task->next = NULL;
+    pthread_mutex_lock(&worker->lock);
+    if (worker->tail) worker->tail->next = task;
+    else worker->head = task;
+    worker->tail = task;
+    pthread_mutex_unlock(&worker->lock);
+
+    // Pairs with the sleepers/queued check in gz_sched_main: either the
+    // sleeper sees the new task or we see the sleeper
+    __atomic_add_fetch(&gz_sched.queued, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&gz_sched.sleepers, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&gz_sched.idle_lock);
+        pthread_cond_signal(&gz_sched.idle);
+        pthread_mutex_unlock(&gz_sched.idle_lock);
+    }
+}
+
+static gz_task *gz_pop(gz_sched_worker *worker) {
+    pthread_mutex_lock(&worker->lock);
+    gz_task *task = worker->head;
+    if (task) {
+        worker->head = task->next;
+        if (!worker->head) worker->tail = NULL;
+    }
+    pthread_mutex_unlock(&worker->lock);
+    if (task) __atomic_sub_fetch(&gz_sched.queued, 1, __ATOMIC_SEQ_CST);
+    return task;
+}
+
+static gz_task *gz_find_task(gz_sched_worker *self) {
+    gz_task *task = gz_pop(self);
+    if (task) return task;
+    int id = (int)(self - gz_sched.queues);
+    for (int k = 1; k < gz_sched.workers; k++) {
+        task = gz_pop(&gz_sched.queues[(id + k) % gz_sched.workers]);
+        if (task) return task;
+    }
+    return NULL;
+}
+
+static char *gz_stack_alloc(gz_sched_worker *worker) {
+    if (worker && worker->free_count > 0) {
+        return worker->free_stacks[--worker->free_count];
+    }
+    pthread_mutex_lock(&gz_stacks.lock);
+    char *pooled = gz_stacks.count > 0 ? gz_stacks.stacks[--gz_stacks.count] : NULL;
+    pthread_mutex_unlock(&gz_stacks.lock);
+    if (pooled) return pooled;
+
+    char *stack = mmap(NULL, GZ_STACK_SIZE, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    if (stack == MAP_FAILED) abort();
+    mprotect(stack, (size_t)sysconf(_SC_PAGESIZE), PROT_NONE); // guard page
+    return stack;
+}
+
+static void gz_stack_free(gz_sched_worker *worker, char *stack) {
+    if (worker->free_count < GZ_STACK_CACHE) {
+        worker->free_stacks[worker->free_count++] = stack;
+        return;
+    }
+    pthread_mutex_lock(&gz_stacks.lock);
+    if (gz_stacks.count < GZ_STACK_POOL) {
+        gz_stacks.stacks[gz_stacks.count++] = stack;
+        stack = NULL;
+    }
+    pthread_mutex_unlock(&gz_stacks.lock);
+    if (stack) munmap(stack, GZ_STACK_SIZE);
+}
+
+static void gz_task_entry(void) {
+    gz_task *task = gz_worker_self()->current;
+    task->fn(task->arg);
+    task->state = GZ_TASK_DONE;
+    swapcontext(&task->context, &gz_worker_self()->scheduler); // never resumed
+}
+
+static void gz_task_finished(gz_sched_worker *self, gz_task *task) {
+    gz_stack_free(self, task->stack);
+    free(task);
+    if (__atomic_sub_fetch(&gz_sched.live, 1, __ATOMIC_SEQ_CST) == 0) {
+        pthread_mutex_lock(&gz_sched.join_lock);
+        pthread_cond_broadcast(&gz_sched.joined);
+        pthread_mutex_unlock(&gz_sched.join_lock);
+    }
+}
+
+static void *gz_sched_main(void *arg) {
+    gz_self = arg;
+    for (;;) {
+        gz_task *task = gz_find_task(gz_self);
+        if (!task) {
+            pthread_mutex_lock(&gz_sched.idle_lock);
+            __atomic_add_fetch(&gz_sched.sleepers, 1, __ATOMIC_SEQ_CST);
+            while (__atomic_load_n(&gz_sched.queued, __ATOMIC_SEQ_CST) <= 0) {
+                pthread_cond_wait(&gz_sched.idle, &gz_sched.idle_lock);
+            }
+            __atomic_sub_fetch(&gz_sched.sleepers, 1, __ATOMIC_SEQ_CST);
+            pthread_mutex_unlock(&gz_sched.idle_lock);
+            continue;
+        }
+
+        gz_self->current = task;
+        task->state = GZ_TASK_RUNNABLE;
+        swapcontext(&gz_self->scheduler, &task->context);
+        // Back on this worker's own stack: the task finished, or parked and
+        // may later resume on another worker. Read its state before the
+        // unlock: from then on a parked task can be woken, run and freed
+        gz_self->current = NULL;
+        int done = task->state == GZ_TASK_DONE;
+        if (gz_self->unlock_after_switch) {
+            pthread_mutex_unlock(gz_self->unlock_after_switch);
+            gz_self->unlock_after_switch = NULL;
+        }
+        if (done) {
+            gz_task_finished(gz_self, task);
+        }
+    }
+    return NULL;
+}
+
+static void gz_sched_init(void) {
+    gz_sched.workers = gz_worker_count();
+    gz_sched.queues = calloc((size_t)gz_sched.workers, sizeof(gz_sched_worker));
+    if (!gz_sched.queues) abort();
+    for (int i = 0; i < gz_sched.workers; i++) {
+        pthread_mutex_init(&gz_sched.queues[i].lock, NULL);
+    }
+    for (int i = 0; i < gz_sched.workers; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, gz_sched_main, &gz_sched.queues[i]) != 0) abort();
+        pthread_detach(thread);
+    }
+}
+
+void gz_go(void (*fn)(void *arg), void *arg) {
+    pthread_once(&gz_sched.once, gz_sched_init);
+
+    gz_task *task = malloc(sizeof(gz_task));
+    if (!task) abort();
+    task->fn = fn;
+    task->arg = arg;
+    gz_sched_worker *self = gz_worker_self();
+    task->stack = gz_stack_alloc(self);
+    task->state = GZ_TASK_RUNNABLE;
+    task->prof_child = 0;
+    getcontext(&task->context);
+    task->context.uc_stack.ss_sp = task->stack;
+    task->context.uc_stack.ss_size = GZ_STACK_SIZE;
+    task->context.uc_link = NULL;
+    makecontext(&task->context, gz_task_entry, 0);
+
+    __atomic_add_fetch(&gz_sched.live, 1, __ATOMIC_SEQ_CST);
+    gz_sched_worker *target = self;
+    if (!target) {
+        unsigned slot = __atomic_fetch_add(&gz_sched.spread, 1, __ATOMIC_RELAXED);
+        target = &gz_sched.queues[slot % (unsigned)gz_sched.workers];
+    }
+    gz_push(target, task);
+}
+
+void gz_join_all(void) {
+    pthread_mutex_lock(&gz_sched.join_lock);
+    while (__atomic_load_n(&gz_sched.live, __ATOMIC_SEQ_CST) > 0) {
+        pthread_cond_wait(&gz_sched.joined, &gz_sched.join_lock);
+    }
+    pthread_mutex_unlock(&gz_sched.join_lock);
+}
+
+// Current task, or NULL on a thread that is not running a green thread
+void *gz_task_current(void) {
+    gz_sched_worker *self = gz_worker_self();
+    return self ? self->current : NULL;
+}
+
+// --instrument keeps the cycles spent in callees per task, since a task can
+// park in a channel operation and resume on another worker; code outside
+// tasks (main, parallel for bodies) never migrates and uses the thread's
+static __thread uint64_t gz_prof_child_thread;
+
+uint64_t *gz_prof_child(void) {
+    gz_task *task = gz_task_current();
+    return task ? &task->prof_child : &gz_prof_child_thread;
+}
+
+// Suspend the current task; `lock` (held by the caller) is released only
+// after the task is off its stack, so whoever wakes it under that lock
+// cannot resume it early
+void gz_task_park(pthread_mutex_t *lock) {
+    gz_sched_worker *self = gz_worker_self();
+    gz_task *task = self->current;
+    task->state = GZ_TASK_PARKED;
+    self->unlock_after_switch = lock;
+    swapcontext(&task->context, &self->scheduler);
+}
+
+// Make a parked task runnable again
+void gz_task_ready(void *handle) {
+    gz_task *task = handle;
+    task->state = GZ_TASK_RUNNABLE;
+    gz_sched_worker *self = gz_worker_self();
+    gz_push(self ? self : &gz_sched.queues[0], task);
+}
+
+// ---------------------------------------------------------------------------
+// Channels
+
+typedef struct {
+    uint64_t seq; // pos when free for the producer at pos, pos + 1 once filled
+    uint64_t value;
+} gz_cell;
+
+typedef struct gz_waiter {
+    void *task; // parked green thread, or NULL for a thread waiting on `cond`
+    int woken;
+    struct gz_waiter *next;
+    // Unbuffered channels: the value offered or received, and whether the
+    // other side took part (a waiter woken by close did not)
+    uint64_t value;
+    int matched;
+} gz_waiter;
+
+typedef struct {
+    gz_waiter *head;
+    gz_waiter *tail;
+    long count; // registered waiters; read without the lock on the fast path
+} gz_wait_list;
+
+typedef struct {
+    _Alignas(64) uint64_t enqueue_pos;
+    _Alignas(64) uint64_t dequeue_pos;
+    _Alignas(64) gz_cell *cells;
+    uint64_t mask;
+    int unbuffered; // capacity 0: no cells, senders and receivers rendezvous
+    int closed;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    gz_wait_list senders;
+    gz_wait_list receivers;
+} gz_chan;
+
+static void gz_chan_fail(const char *message) {
+    fprintf(stderr, "Error: %s\n", message);
+    exit(1);
+}
+
+void *gz_chan_new(int64_t capacity) {
+    if (capacity < 0) gz_chan_fail("capacidad de canal negativa");
+    uint64_t size = 2; // the sequence scheme needs at least two cells
+    while (size < (uint64_t)capacity) size <<= 1;
+
+    gz_chan *ch = aligned_alloc(64, sizeof(gz_chan));
+    if (!ch) abort();
+    ch->enqueue_pos = 0;
+    ch->dequeue_pos = 0;
+    ch->unbuffered = capacity == 0;
+    if (ch->unbuffered) {
+        ch->cells = NULL;
+        ch->mask = 0;
+    } else {
+        ch->cells = aligned_alloc(64, ((size * sizeof(gz_cell)) + 63) & ~(size_t)63);
+        if (!ch->cells) abort();
+        for (uint64_t i = 0; i < size; i++) ch->cells[i].seq = i;
+        ch->mask = size - 1;
+    }
+    ch->closed = 0;
+    pthread_mutex_init(&ch->lock, NULL);
+    pthread_cond_init(&ch->cond, NULL);
+    ch->senders = (gz_wait_list){ NULL, NULL, 0 };
+    ch->receivers = (gz_wait_list){ NULL, NULL, 0 };
+    return ch;
+}
+
+static int gz_ring_push(gz_chan *ch, uint64_t value) {
+    uint64_t pos = __atomic_load_n(&ch->enqueue_pos, __ATOMIC_RELAXED);
+    for (;;) {
+        gz_cell *cell = &ch->cells[pos & ch->mask];
+        int64_t dif = (int64_t)(__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - pos);
+        if (dif == 0) {
+            if (__atomic_compare_exchange_n(&ch->enqueue_pos, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                cell->value = value;
+                __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+                return 1;
+            }
+        } else if (dif < 0) {
+            return 0; // full
+        } else {
+            pos = __atomic_load_n(&ch->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static int gz_ring_pop(gz_chan *ch, uint64_t *value) {
+    uint64_t pos = __atomic_load_n(&ch->dequeue_pos, __ATOMIC_RELAXED);
+    for (;;) {
+        gz_cell *cell = &ch->cells[pos & ch->mask];
+        int64_t dif = (int64_t)(__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - (pos + 1));
+        if (dif == 0) {
+            if (__atomic_compare_exchange_n(&ch->dequeue_pos, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                *value = cell->value;
+                __atomic_store_n(&cell->seq, pos + ch->mask + 1, __ATOMIC_RELEASE);
+                return 1;
+            }
+        } else if (dif < 0) {
+            return 0; // empty
+        } else {
+            pos = __atomic_load_n(&ch->dequeue_pos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// Called with ch->lock held
+static void gz_wake(gz_chan *ch, gz_waiter *waiter) {
+    void *task = waiter->task;
+    waiter->woken = 1; // the waiter may return as soon as this is seen
+    if (task) gz_task_ready(task);
+    else pthread_cond_broadcast(&ch->cond);
+}
+
+// Take the first waiter off list (lock held); NULL if there is none
+static gz_waiter *gz_wait_take(gz_wait_list *list) {
+    gz_waiter *waiter = list->head;
+    if (!waiter) return NULL;
+    list->head = waiter->next;
+    if (!list->head) list->tail = NULL;
+    __atomic_sub_fetch(&list->count, 1, __ATOMIC_SEQ_CST);
+    return waiter;
+}
+
+// After a push (pop), hand the news to one blocked receiver (sender). The
+// fence orders our ring update before the count load; a waiter bumps the
+// count before its final ring check, so one of the two always notices
+static void gz_wake_one(gz_chan *ch, gz_wait_list *list) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&list->count, __ATOMIC_RELAXED) == 0) return;
+    pthread_mutex_lock(&ch->lock);
+    gz_waiter *waiter = gz_wait_take(list);
+    if (waiter) gz_wake(ch, waiter);
+    pthread_mutex_unlock(&ch->lock);
+}
+
+// Register on `list` before the caller's final ring check (lock held)
+static void gz_wait_register(gz_wait_list *list) {
+    __atomic_add_fetch(&list->count, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static void gz_wait_cancel(gz_chan *ch, gz_wait_list *list) {
+    __atomic_sub_fetch(&list->count, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&ch->lock);
+}
+
+// Queue waiter on list and block until woken; entered with ch->lock held,
+// returns without it
+static void gz_wait_as(gz_chan *ch, gz_wait_list *list, gz_waiter *waiter) {
+    waiter->task = gz_task_current();
+    waiter->woken = 0;
+    waiter->next = NULL;
+    if (list->tail) list->tail->next = waiter;
+    else list->head = waiter;
+    list->tail = waiter;
+
+    if (waiter->task) {
+        gz_task_park(&ch->lock);
+        return;
+    }
+    while (!waiter->woken) {
+        pthread_cond_wait(&ch->cond, &ch->lock);
+    }
+    pthread_mutex_unlock(&ch->lock);
+}
+
+static void gz_wait(gz_chan *ch, gz_wait_list *list) {
+    gz_waiter waiter;
+    gz_wait_as(ch, list, &waiter);
+}
+
+// Capacity 0: hand the value to a waiting receiver, or wait for one to
+// take it. Everything happens under the lock, so there is no fast path
+static void gz_chan_send_sync(gz_chan *ch, uint64_t value) {
+    pthread_mutex_lock(&ch->lock);
+    if (ch->closed) gz_chan_fail("send en un canal cerrado");
+    gz_waiter *receiver = gz_wait_take(&ch->receivers);
+    if (receiver) {
+        receiver->value = value;
+        receiver->matched = 1;
+        gz_wake(ch, receiver);
+        pthread_mutex_unlock(&ch->lock);
+        return;
+    }
+    gz_waiter waiter;
+    waiter.value = value;
+    waiter.matched = 0;
+    gz_wait_register(&ch->senders);
+    gz_wait_as(ch, &ch->senders, &waiter);
+    if (!waiter.matched) gz_chan_fail("send en un canal cerrado");
+}
+
+static int gz_chan_recv_sync(gz_chan *ch, uint64_t *value) {
+    pthread_mutex_lock(&ch->lock);
+    gz_waiter *sender = gz_wait_take(&ch->senders);
+    if (sender) {
+        *value = sender->value;
+        sender->matched = 1;
+        gz_wake(ch, sender);
+        pthread_mutex_unlock(&ch->lock);
+        return 1;
+    }
+    if (ch->closed) {
+        pthread_mutex_unlock(&ch->lock);
+        *value = 0;
+        return 0;
+    }
+    gz_waiter waiter;
+    waiter.value = 0;
+    waiter.matched = 0;
+    gz_wait_register(&ch->receivers);
+    gz_wait_as(ch, &ch->receivers, &waiter);
+    *value = waiter.value;
+    return waiter.matched;
+}
+
+void gz_chan_send(gz_chan *ch, uint64_t value) {
+    if (ch->unbuffered) {
+        gz_chan_send_sync(ch, value);
+        return;
+    }
+    for (;;) {
+        if (__atomic_load_n(&ch->closed, __ATOMIC_ACQUIRE)) gz_chan_fail("send en un canal cerrado");
+        if (gz_ring_push(ch, value)) break;
+
+        pthread_mutex_lock(&ch->lock);
+        gz_wait_register(&ch->senders);
+        if (ch->closed) {
+            gz_wait_cancel(ch, &ch->senders);
+            continue;
+        }
+        if (gz_ring_push(ch, value)) {
+            gz_wait_cancel(ch, &ch->senders);
+            break;
+        }
+        gz_wait(ch, &ch->senders);
+    }
+    gz_wake_one(ch, &ch->receivers);
+}
+
+// Returns 0 (and a zero value) once the channel is closed and drained
+int gz_chan_recv(gz_chan *ch, uint64_t *value) {
+    if (ch->unbuffered) return gz_chan_recv_sync(ch, value);
+    for (;;) {
+        if (gz_ring_pop(ch, value)) break;
+        if (__atomic_load_n(&ch->closed, __ATOMIC_ACQUIRE)) {
+            // Everything sent before close is still delivered
+            if (gz_ring_pop(ch, value)) break;
+            *value = 0;
+            return 0;
+        }
+
+        pthread_mutex_lock(&ch->lock);
+        gz_wait_register(&ch->receivers);
+        int popped = gz_ring_pop(ch, value);
+        if (popped || ch->closed) {
+            gz_wait_cancel(ch, &ch->receivers);
+            if (popped) break;
+            continue;
+        }
+        gz_wait(ch, &ch->receivers);
+    }
+    gz_wake_one(ch, &ch->senders);
+    return 1;
+}
+
+static void gz_wake_all(gz_chan *ch, gz_wait_list *list) {
+    while (list->head) {
+        gz_waiter *waiter = list->head;
+        list->head = waiter->next;
+        __atomic_sub_fetch(&list->count, 1, __ATOMIC_SEQ_CST);
+        gz_wake(ch, waiter);
+    }
+    list->tail = NULL;
+}
+
+void gz_chan_close(gz_chan *ch) {
+    pthread_mutex_lock(&ch->lock);
+    if (ch->closed) gz_chan_fail("close de un canal ya cerrado");
+    __atomic_store_n(&ch->closed, 1, __ATOMIC_SEQ_CST);
+    gz_wake_all(ch, &ch->senders);
+    gz_wake_all(ch, &ch->receivers);
+    pthread_mutex_unlock(&ch->lock);
+}
+
+// ---------------------------------------------------------------------------
+// Strings
+
+// A block load at p stays inside p's page, so it cannot fault even when the
+// string ends a few bytes in
+static inline int gz_block_fits(const char *p, uintptr_t block) {
+    return ((uintptr_t)p & 4095) <= 4096 - block;
+}
+
+// Index of the first byte where a and b differ or a ends (b then ends too)
+static size_t gz_str_mismatch(const char *a, const char *b) {
+    size_t i = 0;
+    for (;;) {
+#if defined(__SSE2__)
+        if (gz_block_fits(a + i, 16) && gz_block_fits(b + i, 16)) {
+            __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+            __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+            unsigned stop = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) ^ 0xFFFFu;
+            stop |= (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(va, _mm_setzero_si128()));
+            if (stop) return i + (size_t)__builtin_ctz(stop);
+            i += 16;
+            continue;
+        }
+#else
+        if (gz_block_fits(a + i, 8) && gz_block_fits(b + i, 8)) {
+            uint64_t wa, wb;
+            memcpy(&wa, a + i, 8);
+            memcpy(&wb, b + i, 8);
+            // High bit of each byte that differs, and of the lowest zero byte of a
+            // (bytes above a zero may be flagged too, which never matters)
+            const uint64_t lows = 0x7F7F7F7F7F7F7F7FULL;
+            uint64_t diff = wa ^ wb;
+            uint64_t stop = (((diff & lows) + lows) | diff) & ~lows;
+            stop |= (wa - 0x0101010101010101ULL) & ~wa & ~lows;
+            if (stop) return i + (size_t)(__builtin_ctzll(stop) >> 3);
+            i += 8;
+            continue;
+        }
+#endif
+        // Close to a page end: a byte at a time until past it
+        if (a[i] != b[i] || a[i] == '\0') return i;
+        i++;
+    }
+}
+
+int gz_str_eq(const char *a, const char *b) {
+    if (a == b) return 1;
+    size_t i = gz_str_mismatch(a, b);
+    return a[i] == b[i];
+}
+
+// <0, 0 or >0 as a sorts before, equal to or after b (bytewise, like strcmp)
+int gz_str_cmp(const char *a, const char *b) {
+    if (a == b) return 0;
+    size_t i = gz_str_mismatch(a, b);
+    return (int)(unsigned char)a[i] - (int)(unsigned char)b[i];
+}
+
+#define GZ_STR_SMALL 64          // bytes, terminator included
+#define GZ_STR_CHUNK (64 * 1024)
+
+static __thread char *gz_str_next;
+static __thread char *gz_str_end;
+
+char *gz_str_alloc(size_t size) {
+    if (size > GZ_STR_SMALL) {
+        char *out = malloc(size);
+        if (!out) abort();
+        return out;
+    }
+    if ((size_t)(gz_str_end - gz_str_next) < size) {
+        // The rest of the old chunk (under GZ_STR_SMALL bytes) is left unused
+        gz_str_next = malloc(GZ_STR_CHUNK);
+        if (!gz_str_next) abort();
+        gz_str_end = gz_str_next + GZ_STR_CHUNK;
+    }
+    char *out = gz_str_next;
+    gz_str_next += size;
+    return out;
+}
+
+// a + b in new memory
+char *gz_str_concat(const char *a, const char *b) {
+    size_t la = strlen(a);
+    size_t lb = strlen(b);
+    char *out = gz_str_alloc(la + lb + 1);
+    memcpy(out, a, la);
+    memcpy(out + la, b, lb + 1);
+    return out;
+}
+
+// Decimal digits of v, written backwards ending at end; returns the start
+static char *gz_format_int(int64_t v, char *end) {
+    uint64_t magnitude = v < 0 ? 0 - (uint64_t)v : (uint64_t)v;
+    char *p = end;
+    do {
+        *--p = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (v < 0) *--p = '-';
+    return p;
+}
+
+// Numbers as operands of +, formatted as print shows them
+char *gz_str_of_int(int64_t v) {
+    char digits[24];
+    char *start = gz_format_int(v, digits + sizeof digits);
+    size_t length = (size_t)(digits + sizeof digits - start);
+    char *out = gz_str_alloc(length + 1);
+    memcpy(out, start, length);
+    out[length] = '\0';
+    return out;
+}
+
+char *gz_str_of_float(double v) {
+    int length = snprintf(NULL, 0, "%f", v);
+    char *out = gz_str_alloc((size_t)length + 1);
+    snprintf(out, (size_t)length + 1, "%f", v);
+    return out;
+}
+
+// Formatters for string interpolation. They write at out without a
+// terminator and return the length; the caller has reserved room: 20 bytes
+// for an int, 48 for a float and gz_fmt_float_bound(v) for a double.
+size_t gz_fmt_int(char *out, int64_t v) {
+    char digits[24];
+    char *start = gz_format_int(v, digits + sizeof digits);
+    size_t length = (size_t)(digits + sizeof digits - start);
+    memcpy(out, start, length);
+    return length;
+}
+
+#define GZ_FIXED_MAX 1e15 // below it, %f has at most 15 integer digits
+
+size_t gz_fmt_float_bound(double v) {
+    // Sign, 15 digits (16 after rounding up), '.' and 6 decimals
+    if (v > -GZ_FIXED_MAX && v < GZ_FIXED_MAX) return 24;
+    return (size_t)snprintf(NULL, 0, "%f", v);
+}
+
+// The rounding error of p = a * b, so that p + error == a * b exactly
+// (Dekker's product; a and b must be far from underflow)
+static double gz_product_error(double a, double b, double p) {
+    const double split = 134217729.0; // 2^27 + 1
+    double t = split * a;
+    double ah = t - (t - a), al = a - ah;
+    t = split * b;
+    double bh = t - (t - b), bl = b - bh;
+    return ((ah * bh - p) + ah * bl + al * bh) + al * bl;
+}
+
+size_t gz_fmt_float(char *out, double v) {
+    if (!(v > -GZ_FIXED_MAX && v < GZ_FIXED_MAX)) {
+        return (size_t)sprintf(out, "%f", v); // also inf and nan
+    }
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof bits);
+    char *p = out;
+    if (bits >> 63) *p++ = '-'; // -0.0 prints as -0.000000, like printf
+    double magnitude = v < 0 ? -v : v;
+
+    // Six decimals, rounded half to even on the exact value as printf does
+    uint64_t whole = (uint64_t)magnitude;
+    double frac = magnitude - (double)whole; // exact
+    uint64_t micros = 0;
+    if (frac >= 1e-7) {
+        double scaled = frac * 1e6;
+        double error = gz_product_error(frac, 1e6, scaled);
+        micros = (uint64_t)scaled;
+        double rest = (scaled - (double)micros) - 0.5; // exact
+        double above = rest + error; // its sign is exact
+        if (above > 0 || (above == 0 && (micros & 1))) micros++;
+        if (micros == 1000000) {
+            micros = 0;
+            whole++;
+        }
+    }
+
+    char digits[24];
+    char *start = gz_format_int((int64_t)whole, digits + sizeof digits);
+    size_t length = (size_t)(digits + sizeof digits - start);
+    memcpy(p, start, length);
+    p += length;
+    *p++ = '.';
+    for (int i = 5; i >= 0; --i) {
+        p[i] = (char)('0' + micros % 10);
+        micros /= 10;
+    }
+    return (size_t)(p + 6 - out);
+}
+
+// ---------------------------------------------------------------------------
+// String builders
+
+typedef struct {
+    char *data; // NUL-terminated once anything was appended
+    size_t length;
+    size_t capacity;
+} gz_sb;
+
+static void gz_sb_reserve(gz_sb *sb, size_t extra) {
+    size_t needed = sb->length + extra + 1;
+    if (needed <= sb->capacity) return;
+    size_t capacity = sb->capacity ? sb->capacity * 2 : 64;
+    while (capacity < needed) capacity *= 2;
+    sb->data = realloc(sb->data, capacity);
+    if (!sb->data) abort();
+    sb->capacity = capacity;
+}
+
+void *gz_sb_new(void) {
+    gz_sb *sb = calloc(1, sizeof(gz_sb));
+    if (!sb) abort();
+    return sb;
+}
+
+void gz_sb_append(gz_sb *sb, const char *s) {
+    size_t length = strlen(s);
+    gz_sb_reserve(sb, length);
+    memcpy(sb->data + sb->length, s, length + 1);
+    sb->length += length;
+}
+
+// A builder holding s, for loops rewritten from s = s + x
+void *gz_sb_from(const char *s) {
+    gz_sb *sb = gz_sb_new();
+    gz_sb_append(sb, s);
+    return sb;
+}
+
+void gz_sb_append_int(gz_sb *sb, int64_t v) {
+    gz_sb_reserve(sb, 20);
+    char digits[24];
+    char *start = gz_format_int(v, digits + sizeof digits);
+    size_t length = (size_t)(digits + sizeof digits - start);
+    memcpy(sb->data + sb->length, start, length);
+    sb->length += length;
+    sb->data[sb->length] = '\0';
+}
+
+void gz_sb_append_float(gz_sb *sb, double v) {
+    gz_sb_reserve(sb, 32);
+    size_t room = sb->capacity - sb->length;
+    int length = snprintf(sb->data + sb->length, room, "%f", v);
+    if ((size_t)length >= room) {
+        // Huge magnitudes print hundreds of digits
+        gz_sb_reserve(sb, (size_t)length);
+        snprintf(sb->data + sb->length, (size_t)length + 1, "%f", v);
+    }
+    sb->length += (size_t)length;
+}
+
+// toString(b): the contents as a string; the buffer now belongs to the
+// string, and the builder starts over empty
+const char *gz_sb_finish(gz_sb *sb) {
+    if (!sb->data) return "";
+    char *s = sb->data;
+    sb->data = NULL;
+    sb->length = 0;
+    sb->capacity = 0;
+    return s;
+}
+
+// End of a rewritten loop: the string takes the buffer and the builder goes
+const char *gz_sb_done(gz_sb *sb) {
+    const char *s = gz_sb_finish(sb);
+    free(sb);
+    return s;
+}
+
+// ---------------------------------------------------------------------------
+// Maps
+
+#define GZ_CTRL_EMPTY ((int8_t)-128)  // 0x80
+#define GZ_CTRL_DELETED ((int8_t)-2)  // 0xFE; full slots hold h2 in 0..127
+
+#if defined(__SSE2__)
+#define GZ_GROUP 16
+typedef uint32_t gz_bitmask; // bit i: control byte i of the group
+
+static inline gz_bitmask gz_group_match(const int8_t *ctrl, int8_t h2) {
+    __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+    return (gz_bitmask)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(h2)));
+}
+
+static inline gz_bitmask gz_group_empty(const int8_t *ctrl) {
+    return gz_group_match(ctrl, GZ_CTRL_EMPTY);
+}
+
+// EMPTY and DELETED are the only control bytes with the sign bit set
+static inline gz_bitmask gz_group_free(const int8_t *ctrl) {
+    return (gz_bitmask)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl));
+}
+
+static inline int gz_bitmask_next(gz_bitmask *mask) {
+    int bit = __builtin_ctz(*mask);
+    *mask &= *mask - 1;
+    return bit;
+}
+#else
+#define GZ_GROUP 8
+typedef uint64_t gz_bitmask; // high bit of byte i: control byte i (little-endian)
+
+#define GZ_LSBS 0x0101010101010101ULL
+#define GZ_MSBS 0x8080808080808080ULL
+
+static inline uint64_t gz_group_load(const int8_t *ctrl) {
+    uint64_t group;
+    memcpy(&group, ctrl, sizeof group);
+    return group;
+}
+
+// May report a false match next to a true one; callers compare keys anyway
+static inline gz_bitmask gz_group_match(const int8_t *ctrl, int8_t h2) {
+    uint64_t x = gz_group_load(ctrl) ^ (GZ_LSBS * (uint8_t)h2);
+    return (x - GZ_LSBS) & ~x & GZ_MSBS;
+}
+
+// Exact: EMPTY has its low bit clear, DELETED has it set
+static inline gz_bitmask gz_group_empty(const int8_t *ctrl) {
+    uint64_t group = gz_group_load(ctrl);
+    return group & ~(group << 6) & GZ_MSBS;
+}
+
+static inline gz_bitmask gz_group_free(const int8_t *ctrl) {
+    return gz_group_load(ctrl) & GZ_MSBS;
+}
+
+static inline int gz_bitmask_next(gz_bitmask *mask) {
+    int bit = __builtin_ctzll(*mask) >> 3;
+    *mask &= *mask - 1;
+    return bit;
+}
+#endif
+
+typedef struct {
+    char *key; // owned copy
+    uint64_t hash;
+    uint64_t value;
+} gz_map_slot;
+
+typedef struct {
+    // capacity + GZ_GROUP control bytes: the first GZ_GROUP are mirrored at
+    // the end, so a group can be loaded at any slot index without wrapping
+    int8_t *ctrl;
+    gz_map_slot *slots;
+    uint64_t mask;        // capacity - 1; capacity is a power of two >= GZ_GROUP
+    int64_t count;
+    int64_t growth_left;  // EMPTY slots that may still be filled (7/8 load)
+} gz_map;
+
+// FNV-1a finished with fmix64; the compiler hashes literal keys the same way
+uint64_t gz_str_hash(const char *s) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (; *s; s++) {
+        h ^= (unsigned char)*s;
+        h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static inline uint64_t gz_h1(uint64_t hash) { return hash >> 7; }
+static inline int8_t gz_h2(uint64_t hash) { return (int8_t)(hash & 0x7f); }
+
+static inline void gz_set_ctrl(gz_map *m, uint64_t i, int8_t ctrl) {
+    m->ctrl[i] = ctrl;
+    if (i < GZ_GROUP) m->ctrl[m->mask + 1 + i] = ctrl;
+}
+
+static int64_t gz_max_load(uint64_t capacity) {
+    return (int64_t)(capacity - capacity / 8);
+}
+
+// Groups are probed at h1, h1 + G, h1 + 3G, h1 + 6G, ... (triangular steps),
+// which visits every group of a power-of-two table
+static gz_map_slot *gz_map_lookup(gz_map *m, const char *key, uint64_t hash) {
+    int8_t h2 = gz_h2(hash);
+    uint64_t pos = gz_h1(hash) & m->mask;
+    for (uint64_t step = GZ_GROUP;; step += GZ_GROUP) {
+        const int8_t *group = m->ctrl + pos;
+        gz_bitmask match = gz_group_match(group, h2);
+        while (match) {
+            gz_map_slot *slot = &m->slots[(pos + gz_bitmask_next(&match)) & m->mask];
+            if (slot->hash == hash && gz_str_eq(slot->key, key)) return slot;
+        }
+        if (gz_group_empty(group)) return NULL;
+        pos = (pos + step) & m->mask;
+    }
+}
+
+// First EMPTY or DELETED slot on the probe sequence of hash
+static uint64_t gz_find_free(gz_map *m, uint64_t hash) {
+    uint64_t pos = gz_h1(hash) & m->mask;
+    for (uint64_t step = GZ_GROUP;; step += GZ_GROUP) {
+        gz_bitmask free_slots = gz_group_free(m->ctrl + pos);
+        if (free_slots) return (pos + gz_bitmask_next(&free_slots)) & m->mask;
+        pos = (pos + step) & m->mask;
+    }
+}
+
+static void gz_map_alloc(gz_map *m, uint64_t capacity) {
+    m->ctrl = malloc(capacity + GZ_GROUP);
+    m->slots = malloc(capacity * sizeof(gz_map_slot));
+    if (!m->ctrl || !m->slots) abort();
+    memset(m->ctrl, (uint8_t)GZ_CTRL_EMPTY, capacity + GZ_GROUP);
+    m->mask = capacity - 1;
+    m->growth_left = gz_max_load(capacity) - m->count;
+}
+
+void *gz_map_new(int64_t size_hint) {
+    gz_map *m = malloc(sizeof(gz_map));
+    if (!m) abort();
+    uint64_t capacity = GZ_GROUP;
+    while (size_hint > 0 && gz_max_load(capacity) < size_hint) capacity <<= 1;
+    m->count = 0;
+    gz_map_alloc(m, capacity);
+    return m;
+}
+
+static void gz_map_resize(gz_map *m, uint64_t capacity) {
+    int8_t *old_ctrl = m->ctrl;
+    gz_map_slot *old_slots = m->slots;
+    uint64_t old_capacity = m->mask + 1;
+    gz_map_alloc(m, capacity);
+    for (uint64_t i = 0; i < old_capacity; i++) {
+        if (old_ctrl[i] < 0) continue;
+        uint64_t j = gz_find_free(m, old_slots[i].hash);
+        gz_set_ctrl(m, j, old_ctrl[i]);
+        m->slots[j] = old_slots[i];
+    }
+    free(old_ctrl);
+    free(old_slots);
+}
+
+// Reclaim tombstones without allocating: every live key is moved to the
+// first free slot of its probe sequence (or stays, if that is in the same
+// group it already occupies)
+static void gz_map_rehash_in_place(gz_map *m) {
+    uint64_t capacity = m->mask + 1;
+    // From here on DELETED marks a live slot still to be placed
+    for (uint64_t i = 0; i < capacity; i++) {
+        m->ctrl[i] = m->ctrl[i] >= 0 ? GZ_CTRL_DELETED : GZ_CTRL_EMPTY;
+    }
+    memcpy(m->ctrl + capacity, m->ctrl, GZ_GROUP);
+
+    for (uint64_t i = 0; i < capacity; i++) {
+        if (m->ctrl[i] != GZ_CTRL_DELETED) continue;
+        uint64_t hash = m->slots[i].hash;
+        uint64_t probe = gz_h1(hash) & m->mask;
+        uint64_t j = gz_find_free(m, hash);
+        if (((i - probe) & m->mask) / GZ_GROUP == ((j - probe) & m->mask) / GZ_GROUP) {
+            gz_set_ctrl(m, i, gz_h2(hash));
+            continue;
+        }
+        if (m->ctrl[j] == GZ_CTRL_EMPTY) {
+            gz_set_ctrl(m, j, gz_h2(hash));
+            m->slots[j] = m->slots[i];
+            gz_set_ctrl(m, i, GZ_CTRL_EMPTY);
+        } else {
+            // j holds another key still to be placed: swap and place that one
+            gz_map_slot tmp = m->slots[j];
+            gz_set_ctrl(m, j, gz_h2(hash));
+            m->slots[j] = m->slots[i];
+            m->slots[i] = tmp;
+            i--;
+        }
+    }
+    m->growth_left = gz_max_load(capacity) - m->count;
+}
+
+uint64_t gz_map_get(gz_map *m, const char *key, uint64_t hash) {
+    gz_map_slot *slot = gz_map_lookup(m, key, hash);
+    return slot ? slot->value : 0;
+}
+
+int gz_map_has(gz_map *m, const char *key, uint64_t hash) {
+    return gz_map_lookup(m, key, hash) != NULL;
+}
+
+void gz_map_set(gz_map *m, const char *key, uint64_t hash, uint64_t value) {
+    gz_map_slot *slot = gz_map_lookup(m, key, hash);
+    if (slot) {
+        slot->value = value;
+        return;
+    }
+
+    uint64_t i = gz_find_free(m, hash);
+    if (m->growth_left == 0 && m->ctrl[i] != GZ_CTRL_DELETED) {
+        // Mostly tombstones: clean up in place; mostly keys: double
+        uint64_t capacity = m->mask + 1;
+        if ((uint64_t)m->count * 32 <= capacity * 25) {
+            gz_map_rehash_in_place(m);
+        } else {
+            gz_map_resize(m, capacity * 2);
+        }
+        i = gz_find_free(m, hash);
+    }
+    if (m->ctrl[i] == GZ_CTRL_EMPTY) m->growth_left--;
+    gz_set_ctrl(m, i, gz_h2(hash));
+    m->slots[i].key = strdup(key);
+    if (!m->slots[i].key) abort();
+    m->slots[i].hash = hash;
+    m->slots[i].value = value;
+    m->count++;
+}
+
+int gz_map_delete(gz_map *m, const char *key, uint64_t hash) {
+    gz_map_slot *slot = gz_map_lookup(m, key, hash);
+    if (!slot) return 0;
+    // Nothing outside the map points at the key (gz_map_next hands out
+    // copies), so it goes with its slot: churn does not leak
+    free(slot->key);
+    slot->key = NULL;
+    gz_set_ctrl(m, (uint64_t)(slot - m->slots), GZ_CTRL_DELETED);
+    m->count--;
+    return 1;
+}
+
+int64_t gz_map_len(gz_map *m) {
+    return m->count;
+}
+
+// for k in m: the key of the first live slot at or after cursor, and the
+// cursor to continue from; -1 once every slot has been visited. The key is
+// a copy, like any other string a program gets, so it outlives a delete
+int64_t gz_map_next(gz_map *m, int64_t cursor, const char **key) {
+    uint64_t capacity = m->mask + 1;
+    for (uint64_t i = (uint64_t)cursor; i < capacity; i++) {
+        if (m->ctrl[i] >= 0) {
+            size_t size = strlen(m->slots[i].key) + 1;
+            char *copy = gz_str_alloc(size);
+            memcpy(copy, m->slots[i].key, size);
+            *key = copy;
+            return (int64_t)i + 1;
+        }
+    }
+    return -1;
+}
+
+// Files
+
+static void gz_file_fail(const char *format, const char *path) {
+    fprintf(stderr, format, path);
+    exit(1);
+}
+
+// Map `path` read-only or copy-on-write and return its contents followed by
+// a NUL; *size receives the file size
+static char *gz_file_map(const char *path, int prot, uint64_t *size) {
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        gz_file_fail("Error: no se puede abrir '%s'\n", path);
+    }
+    *size = (uint64_t)st.st_size;
+    if (*size == 0) {
+        close(fd);
+        static char empty[1];
+        return empty;
+    }
+    // The reservation's zero page (or the zero tail of the last file page)
+    // terminates the data
+    uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+    uint64_t reserved = (*size + 1 + page - 1) & ~(page - 1);
+    char *base = mmap(NULL, reserved, prot, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) abort();
+    if (mmap(base, *size, prot, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        gz_file_fail("Error: no se puede leer '%s'\n", path);
+    }
+    close(fd);
+    return base;
+}
+
+// readFile(path): the file as a string, straight from the page cache
+const char *gz_file_read(const char *path) {
+    uint64_t size;
+    return gz_file_map(path, PROT_READ, &size);
+}
+
+// mapInts/mapFloats(path): the file as packed elem_size-byte elements.
+// Writable copy-on-write, so assigning to an element never touches the file
+void *gz_file_array(const char *path, int64_t elem_size, int64_t *count) {
+    uint64_t size;
+    char *data = gz_file_map(path, PROT_READ | PROT_WRITE, &size);
+    if (size % (uint64_t)elem_size != 0) {
+        gz_file_fail("Error: el tamaño de '%s' no es múltiplo del tamaño del elemento\n", path);
+    }
+    if (size / (uint64_t)elem_size > INT32_MAX) {
+        gz_file_fail("Error: '%s' tiene demasiados elementos para un array\n", path);
+    }
+    *count = (int64_t)(size / (uint64_t)elem_size);
+    return data;
+}
+
+typedef struct {
+    char *next;
+    char *end;
+} gz_lines;
+
+// for line in lines(path): terminators are overwritten with NUL in the
+// private mapping as lines are reached, so each line is a string in place
+void *gz_file_lines(const char *path) {
+    uint64_t size;
+    char *data = gz_file_map(path, PROT_READ | PROT_WRITE, &size);
+    if (size > 0) madvise(data, size, MADV_SEQUENTIAL);
+    gz_lines *lines = malloc(sizeof(gz_lines));
+    if (!lines) abort();
+    lines->next = data;
+    lines->end = data + size;
+    return lines;
+}
+
+// The next line without its "\n" or "\r\n", or NULL at end of file (the
+// handle is freed then). A final line without a terminator still counts.
+const char *gz_file_next_line(gz_lines *lines) {
+    char *line = lines->next;
+    if (line >= lines->end) {
+        free(lines);
+        return NULL;
+    }
+    char *newline = memchr(line, '\n', (size_t)(lines->end - line));
+    if (!newline) {
+        lines->next = lines->end; // already NUL-terminated by the mapping
+        return line;
+    }
+    lines->next = newline + 1;
+    if (newline > line && newline[-1] == '\r') newline[-1] = '\0';
+    *newline = '\0';
+    return line;
+}
+
+// Standard input
+
+#define GZ_IN_BLOCK (1 << 20)
+#define GZ_IN_AHEAD 4096 // a token starting closer than this to the end is refilled first
+
+static struct {
+    char data[GZ_IN_BLOCK + 8];
+    size_t pos;
+    size_t len;
+    int eof;
+} gz_in;
+
+// Make at least `want` unread bytes available unless input ends first.
+// The 8 bytes past the data are NUL, which no parser accepts, so scans
+// (and 8-byte loads) stop there.
+static void gz_in_fill(size_t want) {
+    if (gz_in.len - gz_in.pos >= want || gz_in.eof) return;
+    memmove(gz_in.data, gz_in.data + gz_in.pos, gz_in.len - gz_in.pos);
+    gz_in.len -= gz_in.pos;
+    gz_in.pos = 0;
+    while (gz_in.len < want && !gz_in.eof) {
+        ssize_t n = read(0, gz_in.data + gz_in.len, GZ_IN_BLOCK - gz_in.len);
+        if (n > 0) {
+            gz_in.len += (size_t)n;
+        } else if (n == 0 || errno != EINTR) {
+            gz_in.eof = 1;
+        }
+    }
+    memset(gz_in.data + gz_in.len, 0, 8);
+}
+
+// Skip whitespace and return whether a token follows; the token is then
+// whole in the buffer
+static int gz_in_token(void) {
+    for (;;) {
+        while (gz_in.pos < gz_in.len && (unsigned char)gz_in.data[gz_in.pos] <= ' ') gz_in.pos++;
+        if (gz_in.pos < gz_in.len || gz_in.eof) break;
+        gz_in_fill(GZ_IN_AHEAD);
+    }
+    gz_in_fill(GZ_IN_AHEAD);
+    return gz_in.pos < gz_in.len;
+}
+
+static const uint64_t gz_pow10[9] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+
+// Parse the run of up to 8 ASCII digits at p: *value gets their value and
+// the count is returned. The 8 bytes at p must be readable.
+static int gz_parse_digits8(const char *p, uint64_t *value) {
+    uint64_t word;
+    memcpy(&word, p, 8);
+    // Bytes become digit values; any byte outside 0..9 gets its top bit set
+    // (borrows and carries only reach bytes after the first non-digit)
+    uint64_t digits = word - 0x3030303030303030ULL;
+    uint64_t bad = (digits | (digits + 0x7676767676767676ULL)) & 0x8080808080808080ULL;
+    int count = bad ? __builtin_ctzll(bad) >> 3 : 8;
+    if (count == 0) {
+        *value = 0;
+        return 0;
+    }
+    // Shift the digits up so the missing ones act as leading zeros, then
+    // combine pairs, quads and octets (the first digit is the low byte)
+    digits <<= 8 * (8 - count);
+    digits = (digits * 10 + (digits >> 8)) & 0x00FF00FF00FF00FFULL;
+    digits = (digits * 100 + (digits >> 16)) & 0x0000FFFF0000FFFFULL;
+    digits = (digits * 10000 + (digits >> 32)) & 0x00000000FFFFFFFFULL;
+    *value = digits;
+    return count;
+}
+
+// A run of digits of any length (wrapping past 20); *digits gets its length
+static uint64_t gz_parse_uint(const char **p, int *digits) {
+    uint64_t value = 0;
+    *digits = 0;
+    int count;
+    do {
+        uint64_t chunk;
+        count = gz_parse_digits8(*p, &chunk);
+        value = value * gz_pow10[count] + chunk;
+        *p += count;
+        *digits += count;
+    } while (count == 8);
+    return value;
+}
+
+int64_t gz_read_int(void) {
+    if (!gz_in_token()) return 0;
+    const char *p = gz_in.data + gz_in.pos;
+    int negative = *p == '-';
+    if (*p == '-' || *p == '+') p++;
+    int digits;
+    uint64_t value = gz_parse_uint(&p, &digits);
+    if (digits == 0) {
+        fprintf(stderr, "Error: readInt esperaba un entero\n");
+        exit(1);
+    }
+    gz_in.pos = (size_t)(p - gz_in.data);
+    return negative ? -(int64_t)value : (int64_t)value;
+}
+
+double gz_read_float(void) {
+    if (!gz_in_token()) return 0.0;
+    const char *start = gz_in.data + gz_in.pos;
+    const char *p = start;
+    int negative = *p == '-';
+    if (*p == '-' || *p == '+') p++;
+
+    int intDigits, fracDigits = 0;
+    uint64_t mantissa = gz_parse_uint(&p, &intDigits);
+    uint64_t fraction = 0;
+    if (*p == '.') {
+        p++;
+        fraction = gz_parse_uint(&p, &fracDigits);
+    }
+    int significant = intDigits + fracDigits;
+    int exponent = 0;
+    if (significant > 0 && (*p == 'e' || *p == 'E')) {
+        const char *e = p + 1;
+        int expNegative = *e == '-';
+        if (*e == '-' || *e == '+') e++;
+        int expDigits;
+        uint64_t expValue = gz_parse_uint(&e, &expDigits);
+        if (expDigits > 0) {
+            exponent = expDigits > 4 ? 100000 : (int)expValue;
+            if (expNegative) exponent = -exponent;
+            p = e;
+        }
+    }
+    if (significant == 0) {
+        // Not a plain decimal (inf, nan, hex): strtod decides
+        char *end;
+        double value = strtod(start, &end);
+        if (end == start) {
+            fprintf(stderr, "Error: readFloat esperaba un número\n");
+            exit(1);
+        }
+        gz_in.pos = (size_t)(end - gz_in.data);
+        return value;
+    }
+    gz_in.pos = (size_t)(p - gz_in.data);
+
+    // Up to 19 digits fit in the mantissa; below 2^53 with a power of ten up
+    // to 1e22 one rounding operation gives the exact result (Clinger's fast
+    // path). Anything else goes through strtod.
+    static const double pow10[23] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                     1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    exponent -= fracDigits;
+    if (significant <= 19) {
+        for (int i = 0; i < fracDigits; i++) mantissa *= 10;
+        mantissa += fraction;
+        if (mantissa < (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+            double value = (double)mantissa;
+            value = exponent < 0 ? value / pow10[-exponent] : value * pow10[exponent];
+            return negative ? -value : value;
+        }
+    }
+    return strtod(start, NULL);
+}
+
+// The rest of the current line without its "\n" or "\r\n", in its own
+// allocation since the buffer is reused
+const char *gz_read_line(void) {
+    char *line = NULL;
+    size_t length = 0;
+    for (;;) {
+        gz_in_fill(1);
+        if (gz_in.pos >= gz_in.len) break; // end of input
+        const char *start = gz_in.data + gz_in.pos;
+        size_t available = gz_in.len - gz_in.pos;
+        const char *newline = memchr(start, '\n', available);
+        size_t take = newline ? (size_t)(newline - start) : available;
+        line = realloc(line, length + take + 1);
+        if (!line) abort();
+        memcpy(line + length, start, take);
+        length += take;
+        gz_in.pos += take;
+        if (newline) {
+            gz_in.pos++;
+            break;
+        }
+    }
+    if (!line) return ""; // nothing left to read
+    if (length > 0 && line[length - 1] == '\r') length--;
+    line[length] = '\0';
+    return line;
+}
@@ -0,0 +1,252 @@
+#include "../include/code_generator.h"
+#include <iostream>
+#include <variant>
+
+// Bounds-check elimination for counting loops.
+//
+// A loop qualifies when its condition is `i < B` or `i <= B`, its only
+// update of `i` is a trailing `++i` / `i = i + 1` (the for post statement,
+// or the last statement of a while body), and B only reads variables that
+// the body never writes. Inside such a loop every `a[i]` on an array or
+// string that the body does not reassign stays in [i0, B], where i0 is the
+// value of `i` on entry. If that range is provably inside the array at
+// compile time the checks simply disappear; otherwise a single range check
+// on i0 and B is hoisted in front of the loop, so a bad loop now fails
+// before its first iteration instead of at the offending one.
+
+namespace {
+
+struct LoopFacts {
+    std::set<std::string> modified;      // names assigned, incremented or redeclared
+    std::set<std::string> indexedArrays; // names indexed as name[indexVar]
+};
+
+void collectExprFacts(const Expr *expr, const std::string &indexVar, LoopFacts &facts);
+
+void collectStmtFacts(const Stmt *stmt, const std::string &indexVar, LoopFacts &facts) {
+    if (!stmt) return;
+    if (auto *varDecl = dynamic_cast<const VarDeclStmt*>(stmt)) {
+        facts.modified.insert(varDecl->name);
+        collectExprFacts(varDecl->init.get(), indexVar, facts);
+    } else if (auto *inferDecl = dynamic_cast<const InferDeclStmt*>(stmt)) {
+        facts.modified.insert(inferDecl->name);
+        collectExprFacts(inferDecl->init.get(), indexVar, facts);
+    } else if (auto *assign = dynamic_cast<const AssignStmt*>(stmt)) {
+        facts.modified.insert(assign->name);
+        collectExprFacts(assign->expr.get(), indexVar, facts);
+    } else if (auto *indexAssign = dynamic_cast<const IndexAssignStmt*>(stmt)) {
+        // Element stores leave the array (and its length) in place
+        auto *indexVarExpr = dynamic_cast<const VarExpr*>(indexAssign->index.get());
+        if (indexVarExpr && indexVarExpr->name == indexVar) {
+            facts.indexedArrays.insert(indexAssign->name);
+        }
+        collectExprFacts(indexAssign->index.get(), indexVar, facts);
+        collectExprFacts(indexAssign->expr.get(), indexVar, facts);
+    } else if (auto *print = dynamic_cast<const PrintStmt*>(stmt)) {
+        collectExprFacts(print->expr.get(), indexVar, facts);
+    } else if (auto *exprStmt = dynamic_cast<const ExprStmt*>(stmt)) {
+        collectExprFacts(exprStmt->expr.get(), indexVar, facts);
+    } else if (auto *goStmt = dynamic_cast<const GoStmt*>(stmt)) {
+        collectExprFacts(goStmt->call.get(), indexVar, facts);
+    } else if (auto *send = dynamic_cast<const SendStmt*>(stmt)) {
+        collectExprFacts(send->chan.get(), indexVar, facts);
+        collectExprFacts(send->value.get(), indexVar, facts);
+    } else if (auto *closeStmt = dynamic_cast<const CloseStmt*>(stmt)) {
+        collectExprFacts(closeStmt->chan.get(), indexVar, facts);
+    } else if (auto *ret = dynamic_cast<const ReturnStmt*>(stmt)) {
+        collectExprFacts(ret->value.get(), indexVar, facts);
+    } else if (auto *ifStmt = dynamic_cast<const IfStmt*>(stmt)) {
+        collectExprFacts(ifStmt->cond.get(), indexVar, facts);
+        for (const auto &s : ifStmt->thenBranch) collectStmtFacts(s.get(), indexVar, facts);
+        for (const auto &s : ifStmt->elseBranch) collectStmtFacts(s.get(), indexVar, facts);
+    } else if (auto *whileStmt = dynamic_cast<const WhileStmt*>(stmt)) {
+        collectExprFacts(whileStmt->cond.get(), indexVar, facts);
+        for (const auto &s : whileStmt->body) collectStmtFacts(s.get(), indexVar, facts);
+    } else if (auto *forStmt = dynamic_cast<const ForStmt*>(stmt)) {
+        collectStmtFacts(forStmt->init.get(), indexVar, facts);
+        collectExprFacts(forStmt->cond.get(), indexVar, facts);
+        collectStmtFacts(forStmt->post.get(), indexVar, facts);
+        for (const auto &s : forStmt->body) collectStmtFacts(s.get(), indexVar, facts);
+    } else if (auto *forIn = dynamic_cast<const ForInStmt*>(stmt)) {
+        facts.modified.insert(forIn->var);
+        collectExprFacts(forIn->iterable.get(), indexVar, facts);
+        for (const auto &s : forIn->body) collectStmtFacts(s.get(), indexVar, facts);
+    } else if (auto *funcStmt = dynamic_cast<const FunctionStmt*>(stmt)) {
+        // Nested functions get their own scope, only their name leaks out
+        facts.modified.insert(funcStmt->name);
+    }
+}
+
+void collectExprFacts(const Expr *expr, const std::string &indexVar, LoopFacts &facts) {
+    if (!expr) return;
+    if (auto *bin = dynamic_cast<const BinaryExpr*>(expr)) {
+        collectExprFacts(bin->left.get(), indexVar, facts);
+        collectExprFacts(bin->right.get(), indexVar, facts);
+    } else if (auto *unary = dynamic_cast<const UnaryExpr*>(expr)) {
+        facts.modified.insert(unary->varName);
+    } else if (auto *array = dynamic_cast<const ArrayExpr*>(expr)) {
+        for (const auto &elem : array->elements) collectExprFacts(elem.get(), indexVar, facts);
+    } else if (auto *index = dynamic_cast<const IndexExpr*>(expr)) {
+        auto *arrayVar = dynamic_cast<const VarExpr*>(index->array.get());
+        auto *indexVarExpr = dynamic_cast<const VarExpr*>(index->index.get());
+        if (arrayVar && indexVarExpr && indexVarExpr->name == indexVar) {
+            facts.indexedArrays.insert(arrayVar->name);
+        }
+        collectExprFacts(index->array.get(), indexVar, facts);
+        collectExprFacts(index->index.get(), indexVar, facts);
+    } else if (auto *slice = dynamic_cast<const SliceExpr*>(expr)) {
+        collectExprFacts(slice->array.get(), indexVar, facts);
+        collectExprFacts(slice->lo.get(), indexVar, facts);
+        collectExprFacts(slice->hi.get(), indexVar, facts);
+    } else if (auto *call = dynamic_cast<const CallExpr*>(expr)) {
+        for (const auto &arg : call->args) collectExprFacts(arg.get(), indexVar, facts);
+    } else if (auto *chan = dynamic_cast<const ChanExpr*>(expr)) {
+        collectExprFacts(chan->capacity.get(), indexVar, facts);
+    } else if (auto *map = dynamic_cast<const MapExpr*>(expr)) {
+        collectExprFacts(map->sizeHint.get(), indexVar, facts);
+    } else if (auto *recv = dynamic_cast<const RecvExpr*>(expr)) {
+        if (!recv->target.empty()) facts.modified.insert(recv->target);
+        collectExprFacts(recv->chan.get(), indexVar, facts);
+    } else if (auto *interp = dynamic_cast<const InterpExpr*>(expr)) {
+        for (const auto &hole : interp->holes) collectExprFacts(hole.get(), indexVar, facts);
+    }
+}
+
+// Loop bounds are re-evaluated before the loop, so they must be pure and
+// must only read variables the loop never writes
+bool isLoopInvariant(const Expr *expr, const std::set<std::string> &modified) {
+    if (dynamic_cast<const LiteralExpr*>(expr)) return true;
+    if (auto *var = dynamic_cast<const VarExpr*>(expr)) return modified.count(var->name) == 0;
+    if (auto *bin = dynamic_cast<const BinaryExpr*>(expr)) {
+        if (bin->op != BinaryExpr::Op::ADD && bin->op != BinaryExpr::Op::SUB &&
+            bin->op != BinaryExpr::Op::MUL) {
+            return false;
+        }
+        return isLoopInvariant(bin->left.get(), modified) && isLoopInvariant(bin->right.get(), modified);
+    }
+    return false;
+}
+
+bool isIncrementOf(const Stmt *stmt, const std::string &name) {
+    if (auto *exprStmt = dynamic_cast<const ExprStmt*>(stmt)) {
+        auto *unary = dynamic_cast<const UnaryExpr*>(exprStmt->expr.get());
+        return unary && unary->op == UnaryExpr::Op::PRE_INC && unary->varName == name;
+    }
+    if (auto *assign = dynamic_cast<const AssignStmt*>(stmt)) {
+        auto *bin = dynamic_cast<const BinaryExpr*>(assign->expr.get());
+        if (assign->name != name || !bin || bin->op != BinaryExpr::Op::ADD) return false;
+        auto *var = dynamic_cast<const VarExpr*>(bin->left.get());
+        auto *lit = dynamic_cast<const LiteralExpr*>(bin->right.get());
+        return var && var->name == name && lit &&
+               std::holds_alternative<int>(lit->value) && std::get<int>(lit->value) == 1;
+    }
+    return false;
+}
+
+bool intLiteralValue(const Expr *expr, int &value) {
+    auto *lit = dynamic_cast<const LiteralExpr*>(expr);
+    if (!lit || !std::holds_alternative<int>(lit->value)) return false;
+    value = std::get<int>(lit->value);
+    return true;
+}
+
+} // namespace
+
+bool CodeGenerator::matchCountingLoop(const Expr *cond, const Stmt *step,
+                                      std::string &indexVar, const Expr *&bound, bool &inclusive) {
+    auto *cmp = dynamic_cast<const BinaryExpr*>(cond);
+    if (!cmp || (cmp->op != BinaryExpr::Op::LT && cmp->op != BinaryExpr::Op::LE)) return false;
+    auto *var = dynamic_cast<const VarExpr*>(cmp->left.get());
+    if (!var || !step || !isIncrementOf(step, var->name)) return false;
+    if (variableTypes.count(var->name) == 0 || variableTypes[var->name] != VarDeclStmt::INT) return false;
+    if (typeAnalyzer.inferType(cmp->right.get()) != VarDeclStmt::INT) return false;
+
+    indexVar = var->name;
+    bound = cmp->right.get();
+    inclusive = cmp->op == BinaryExpr::Op::LE;
+    return true;
+}
+
+void CodeGenerator::proveLoopIndexes(const std::string &indexVar, const Expr *lowerBound, const Expr *bound,
+                                     bool inclusive, const std::vector<StmtPtr> &body, const Stmt *step) {
+    if (boundsMode == BoundsMode::OFF) return;
+
+    LoopFacts facts;
+    for (const auto &bodyStmt : body) {
+        if (bodyStmt.get() != step) collectStmtFacts(bodyStmt.get(), indexVar, facts);
+    }
+    if (facts.modified.count(indexVar) || !isLoopInvariant(bound, facts.modified)) return;
+
+    std::vector<std::string> runtimeChecked;
+    for (const auto &arrayName : facts.indexedArrays) {
+        if (facts.modified.count(arrayName) || arrayName == indexVar) continue;
+        auto typeIt = variableTypes.find(arrayName);
+        if (typeIt == variableTypes.end() || !findVariable(arrayName)) continue;
+
+        VarDeclStmt::Kind kind = typeIt->second;
+        if (kind == VarDeclStmt::STRING) {
+            runtimeChecked.push_back(arrayName);
+            continue;
+        }
+        if (!TypeAnalyzer::isArrayType(kind)) {
+            continue;
+        }
+        auto sizeIt = arraySizes.find(arrayName);
+        if (sizeIt == arraySizes.end()) {
+            // Array parameters only know their length at run time
+            if (arrayLengths.count(arrayName)) runtimeChecked.push_back(arrayName);
+            continue;
+        }
+
+        // Fully static proof: constant start, constant bound, constant length
+        int lower, upper;
+        if (lowerBound && intLiteralValue(lowerBound, lower) && intLiteralValue(bound, upper)) {
+            long long last = inclusive ? upper : static_cast<long long>(upper) - 1;
+            if (last < lower || (lower >= 0 && last < sizeIt->second)) {
+                provenIndexes.insert({arrayName, indexVar});
+                continue;
+            }
+        }
+        runtimeChecked.push_back(arrayName);
+    }
+    if (runtimeChecked.empty()) return;
+
+    // Hoisted check: if the loop runs at all, its first and last index must
+    // both be valid for every array it indexes
+    llvm::AllocaInst *indexAlloca = findVariable(indexVar);
+    if (!indexAlloca) return;
+    llvm::Value *first = builder.CreateLoad(indexAlloca->getAllocatedType(), indexAlloca, "range_first");
+    llvm::Value *limit = generate(bound);
+    if (!limit) return;
+    limit = convertValue(limit, first->getType());
+    if (!limit) return;
+    llvm::Value *last = inclusive ? limit : builder.CreateSub(limit, llvm::ConstantInt::get(first->getType(), 1), "range_last");
+    llvm::Value *runs = inclusive ? builder.CreateICmpSLE(first, limit, "range_runs")
+                                  : builder.CreateICmpSLT(first, limit, "range_runs");
+
+    llvm::Function *function = currentFunction ? currentFunction : mainFunction;
+    llvm::BasicBlock *checkBB = llvm::BasicBlock::Create(context, "range_check", function);
+    llvm::BasicBlock *contBB = llvm::BasicBlock::Create(context, "range_ok", function);
+    builder.CreateCondBr(runs, checkBB, contBB);
+
+    builder.SetInsertPoint(checkBB);
+    for (const auto &arrayName : runtimeChecked) {
+        llvm::Value *length;
+        if (variableTypes[arrayName] == VarDeclStmt::STRING) {
+            llvm::AllocaInst *stringAlloca = findVariable(arrayName);
+            llvm::Value *stringPtr = builder.CreateLoad(stringAlloca->getAllocatedType(), stringAlloca, "string_load");
+            std::vector<llvm::Type*> strlenArgs({llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context))});
+            llvm::FunctionType *strlenType = llvm::FunctionType::get(llvm::Type::getInt64Ty(context), strlenArgs, false);
+            llvm::FunctionCallee strlenFunc = module->getOrInsertFunction("strlen", strlenType);
+            length = builder.CreateTrunc(builder.CreateCall(strlenFunc, {stringPtr}, "string_len"),
+                                         llvm::Type::getInt32Ty(context), "string_len_i32");
+        } else {
+            length = getArrayLength(arrayName);
+        }
+        createBoundsCheck(first, length, arrayName);
+        createBoundsCheck(last, length, arrayName);
+        provenIndexes.insert({arrayName, indexVar});
+    }
+    builder.CreateBr(contBB);
+    builder.SetInsertPoint(contBB);
+}
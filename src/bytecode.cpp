@@ -0,0 +1,959 @@
+#include "../include/interpreter.h"
+#include <iostream>
+#include <variant>
+#include <cstdlib>
+
+// Bytecode compiler for --interp
+//
+// Walks the AST in the same order as CodeGenerator, with the same
+// TypeAnalyzer deciding every kind (scopes, numeric promotion, the return
+// kind of each `fun` specialization), and emits register bytecode instead of
+// LLVM IR. Every variable owns a register of its function's frame, assigned
+// when it is declared; temporaries live above the variables (nextReg >=
+// localTop) and are released after each statement. Functions are compiled on
+// first call, once per argument-kind tuple, like getSpecialization.
+//
+// Channels, go, maps and the mmap'ed file arrays need the runtime's threads
+// and tables; they are rejected here and only run compiled.
+
+namespace {
+
+using Kind = VarDeclStmt::Kind;
+
+bool isIntegerKind(Kind kind) {
+    return kind == VarDeclStmt::INT || kind == VarDeclStmt::INT64 || kind == VarDeclStmt::BOOL;
+}
+
+bool isFloatKind(Kind kind) {
+    return kind == VarDeclStmt::FLOAT || kind == VarDeclStmt::DOUBLE;
+}
+
+// Does evaluating expr change a variable (++x / --x)?
+bool writesVariables(const Expr *expr) {
+    if (!expr) return false;
+    if (dynamic_cast<const UnaryExpr*>(expr)) return true;
+    if (auto *bin = dynamic_cast<const BinaryExpr*>(expr)) {
+        return writesVariables(bin->left.get()) || writesVariables(bin->right.get());
+    }
+    if (auto *index = dynamic_cast<const IndexExpr*>(expr)) {
+        return writesVariables(index->array.get()) || writesVariables(index->index.get());
+    }
+    if (auto *slice = dynamic_cast<const SliceExpr*>(expr)) {
+        return writesVariables(slice->array.get()) || writesVariables(slice->lo.get()) ||
+               writesVariables(slice->hi.get());
+    }
+    if (auto *array = dynamic_cast<const ArrayExpr*>(expr)) {
+        for (const auto &element : array->elements) {
+            if (writesVariables(element.get())) return true;
+        }
+    }
+    if (auto *interp = dynamic_cast<const InterpExpr*>(expr)) {
+        for (const auto &hole : interp->holes) {
+            if (writesVariables(hole.get())) return true;
+        }
+    }
+    if (auto *call = dynamic_cast<const CallExpr*>(expr)) {
+        for (const auto &arg : call->args) {
+            if (writesVariables(arg.get())) return true;
+        }
+    }
+    return false;
+}
+
+// Does op write its a operand? (stores, tests, appends and prints read it)
+bool writesA(Interpreter::Op op) {
+    using Op = Interpreter::Op;
+    switch (op) {
+        case Op::ARR_INIT: case Op::ARR_SET:
+        case Op::SB_APPEND_S: case Op::SB_APPEND_L: case Op::SB_APPEND_D:
+        case Op::PRINT_L: case Op::PRINT_D: case Op::PRINT_S: case Op::PRINT_C: case Op::PRINT_ARR:
+        case Op::JMP: case Op::JMPF: case Op::JMPT: case Op::RET: case Op::RETV:
+            return false;
+        default:
+            return true;
+    }
+}
+
+} // namespace
+
+Interpreter::Interpreter(TypeAnalyzer &analyzer) : typeAnalyzer(analyzer) {}
+
+void Interpreter::unsupported(const std::string &what, int line, int column) {
+    std::cerr << "Error (line " << line << ":" << column << "): --interp no admite " << what
+              << "; compile el programa sin --interp\n";
+    std::exit(1);
+}
+
+uint32_t Interpreter::emit(Op op, uint16_t a, uint16_t b, uint16_t c) {
+    Instr instr;
+    instr.op = op;
+    instr.a = a;
+    instr.b = b;
+    instr.c = c;
+    fn->code.push_back(instr);
+    return static_cast<uint32_t>(fn->code.size() - 1);
+}
+
+uint32_t Interpreter::emitJump(Op op, uint16_t reg) {
+    return emit(op, reg);
+}
+
+void Interpreter::patchJump(uint32_t at, uint32_t target) {
+    fn->code[at].b = static_cast<uint16_t>(target);
+    fn->code[at].c = static_cast<uint16_t>(target >> 16);
+    if (target == fn->code.size()) {
+        labelPc = target;
+    }
+}
+
+uint16_t Interpreter::newRegister() {
+    if (nextReg == UINT16_MAX) {
+        std::cerr << "Error: la función '" << fn->name << "' usa demasiadas variables para --interp\n";
+        std::exit(1);
+    }
+    uint16_t reg = nextReg++;
+    if (nextReg > fn->numRegisters) {
+        fn->numRegisters = nextReg;
+    }
+    return reg;
+}
+
+uint16_t Interpreter::newLocal(const std::string &name, VarDeclStmt::Kind kind) {
+    uint16_t reg = newRegister();
+    localTop = nextReg;
+    if (!name.empty()) {
+        scopes.back()[name] = {reg, kind};
+    }
+    return reg;
+}
+
+const Interpreter::Local* Interpreter::findLocal(const std::string &name) const {
+    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+        auto found = it->find(name);
+        if (found != it->end()) return &found->second;
+    }
+    return nullptr;
+}
+
+uint32_t Interpreter::constant(Slot value) {
+    fn->constants.push_back(value);
+    return static_cast<uint32_t>(fn->constants.size() - 1);
+}
+
+uint16_t Interpreter::loadConstant(Slot value, uint16_t dest) {
+    uint32_t index = constant(value);
+    emit(Op::LOADK, dest, static_cast<uint16_t>(index), static_cast<uint16_t>(index >> 16));
+    return dest;
+}
+
+// Copy src into dest. When src is a temporary the previous instruction just
+// produced, that instruction writes dest directly instead
+void Interpreter::moveTo(uint16_t src, uint16_t dest) {
+    if (src == dest) return;
+    if (!fn->code.empty() && src >= localTop && labelPc != fn->code.size()) {
+        Instr &last = fn->code.back();
+        if (last.a == src && writesA(last.op)) {
+            last.a = dest;
+            return;
+        }
+    }
+    emit(Op::MOVE, dest, src);
+}
+
+const char* Interpreter::internString(const std::string &text) {
+    return literals.insert(text).first->c_str();
+}
+
+void Interpreter::pushScope() {
+    typeAnalyzer.pushScope();
+    scopes.emplace_back();
+    scopeMarks.push_back(localTop);
+}
+
+void Interpreter::popScope() {
+    typeAnalyzer.popScope();
+    scopes.pop_back();
+    localTop = scopeMarks.back();
+    nextReg = localTop;
+    scopeMarks.pop_back();
+}
+
+void Interpreter::compile(const std::vector<StmtPtr> &program) {
+    functions.push_back(std::make_unique<Function>());
+    fn = functions[0].get();
+    fn->name = "main";
+    returnKind = VarDeclStmt::INT;
+    // main's variables live in the analyzer's global scope
+    scopes.emplace_back();
+    scopeMarks.push_back(0);
+    for (const auto &stmt : program) {
+        compileStatement(stmt.get());
+    }
+    emit(Op::RETV);
+}
+
+void Interpreter::compileBlock(const std::vector<StmtPtr> &body) {
+    for (const auto &stmt : body) {
+        compileStatement(stmt.get());
+    }
+}
+
+void Interpreter::compileStatement(const Stmt *stmt) {
+    if (auto *decl = dynamic_cast<const VarDeclStmt*>(stmt)) {
+        if (TypeAnalyzer::isChanType(decl->type)) unsupported("los canales", stmt->line, stmt->column);
+        if (TypeAnalyzer::isMapType(decl->type)) unsupported("los maps", stmt->line, stmt->column);
+        if (dynamic_cast<const SliceExpr*>(decl->init.get()) && typeAnalyzer.inferType(decl->init.get()) != decl->type) {
+            std::cerr << "Error (line " << stmt->line << ":" << stmt->column << "): el array '" << decl->name
+                      << "' se inicializa con un slice de otro tipo\n";
+            std::exit(1);
+        }
+        compileDecl(decl->name, decl->type, decl->init.get(), true);
+    } else if (auto *decl = dynamic_cast<const InferDeclStmt*>(stmt)) {
+        compileDecl(decl->name, typeAnalyzer.inferType(decl->init.get()), decl->init.get(), false);
+    } else if (auto *assign = dynamic_cast<const AssignStmt*>(stmt)) {
+        compileAssign(assign);
+    } else if (auto *assign = dynamic_cast<const IndexAssignStmt*>(stmt)) {
+        compileIndexAssign(assign);
+    } else if (auto *print = dynamic_cast<const PrintStmt*>(stmt)) {
+        compilePrint(print);
+    } else if (auto *ifStmt = dynamic_cast<const IfStmt*>(stmt)) {
+        compileIf(ifStmt);
+    } else if (auto *whileStmt = dynamic_cast<const WhileStmt*>(stmt)) {
+        compileWhile(whileStmt);
+    } else if (auto *forStmt = dynamic_cast<const ForStmt*>(stmt)) {
+        // Same restrictions as compiled; the iterations then run in order
+        if (forStmt->parallel) typeAnalyzer.validateParallelBody(forStmt);
+        compileFor(forStmt);
+    } else if (auto *forIn = dynamic_cast<const ForInStmt*>(stmt)) {
+        compileForIn(forIn);
+    } else if (auto *exprStmt = dynamic_cast<const ExprStmt*>(stmt)) {
+        compileExpr(exprStmt->expr.get());
+    } else if (auto *function = dynamic_cast<const FunctionStmt*>(stmt)) {
+        functionDecls[function->name] = function;
+    } else if (auto *ret = dynamic_cast<const ReturnStmt*>(stmt)) {
+        compileReturn(ret);
+    } else if (dynamic_cast<const GoStmt*>(stmt)) {
+        unsupported("go", stmt->line, stmt->column);
+    } else if (dynamic_cast<const SendStmt*>(stmt) || dynamic_cast<const CloseStmt*>(stmt)) {
+        unsupported("los canales", stmt->line, stmt->column);
+    }
+    nextReg = localTop;
+}
+
+void Interpreter::compileDecl(const std::string &name, VarDeclStmt::Kind kind, const Expr *init, bool typed) {
+    // Declared before its initializer is analyzed, as CodeGenerator does;
+    // the register is only bound afterwards so the initializer still sees
+    // an outer variable of the same name
+    typeAnalyzer.declareVariable(name, kind);
+    uint16_t reg = newRegister();
+    localTop = nextReg;
+    if (!init) {
+        loadConstant(Slot{0}, reg);
+    } else if (typed) {
+        compileExprTo(init, kind, reg);
+    } else {
+        moveTo(compileExpr(init), reg);
+    }
+    scopes.back()[name] = {reg, kind};
+}
+
+void Interpreter::compileAssign(const AssignStmt *stmt) {
+    if (!typeAnalyzer.hasVariable(stmt->name)) {
+        std::cerr << "Error (line " << stmt->line << ":" << stmt->column << "): intento de asignar a variable no declarada '" << stmt->name << "'\n";
+        std::exit(1);
+    }
+    VarDeclStmt::Kind kind = typeAnalyzer.getVariableType(stmt->name);
+    if ((TypeAnalyzer::isArrayType(kind) || TypeAnalyzer::isMapType(kind) || kind == VarDeclStmt::BUILDER) &&
+        typeAnalyzer.inferType(stmt->expr.get()) != kind) {
+        std::cerr << "Error (line " << stmt->line << ":" << stmt->column << "): no se puede asignar un valor de otro tipo a '"
+                  << stmt->name << "'\n";
+        std::exit(1);
+    }
+    const Local *local = findLocal(stmt->name);
+    if (!local) {
+        std::cerr << "Runtime Error (line " << stmt->line << ":" << stmt->column << "): Variable '" << stmt->name << "' is not accessible in current scope\n";
+        std::exit(1);
+    }
+    // Arrays are views, so a = a[1:] or a = b works with any length
+    compileExprTo(stmt->expr.get(), kind, local->reg);
+}
+
+void Interpreter::compileIndexAssign(const IndexAssignStmt *stmt) {
+    const Local *local = findLocal(stmt->name);
+    if (local && TypeAnalyzer::isMapType(local->kind)) unsupported("los maps", stmt->line, stmt->column);
+    if (!local || !TypeAnalyzer::isArrayType(local->kind)) {
+        std::cerr << "Error (line " << stmt->line << ":" << stmt->column << "): '" << stmt->name
+                  << "' no es un array; solo se puede asignar a elementos de arrays y maps\n";
+        std::exit(1);
+    }
+    uint16_t array = local->reg;
+    VarDeclStmt::Kind indexKind = typeAnalyzer.inferType(stmt->index.get());
+    uint16_t index = compileTyped(stmt->index.get(), isIntegerKind(indexKind) ? indexKind : VarDeclStmt::INT64);
+    uint16_t value = compileTyped(stmt->expr.get(), TypeAnalyzer::elementType(local->kind));
+    fn->checkNames[emit(Op::ARR_SET, array, index, value)] = stmt->name;
+}
+
+void Interpreter::compilePrint(const PrintStmt *stmt) {
+    const Expr *expr = stmt->expr.get();
+    VarDeclStmt::Kind kind = typeAnalyzer.inferType(expr);
+    if (TypeAnalyzer::isChanType(kind)) {
+        std::cerr << "Error (line " << stmt->line << ":" << stmt->column << "): no se puede imprimir un canal\n";
+        std::exit(1);
+    }
+    if (TypeAnalyzer::isMapType(kind)) {
+        std::cerr << "Error (line " << stmt->line << ":" << stmt->column
+                  << "): no se puede imprimir un map; recórralo con for k in m\n";
+        std::exit(1);
+    }
+    if (kind == VarDeclStmt::BUILDER) {
+        std::cerr << "Error (line " << stmt->line << ":" << stmt->column
+                  << "): no se puede imprimir un builder; use toString(b)\n";
+        std::exit(1);
+    }
+
+    bool isCharacter = false;
+    if (auto *index = dynamic_cast<const IndexExpr*>(expr)) {
+        if (auto *var = dynamic_cast<const VarExpr*>(index->array.get())) {
+            const Local *local = findLocal(var->name);
+            isCharacter = local && local->kind == VarDeclStmt::STRING;
+        }
+    }
+
+    uint16_t value = compileExpr(expr);
+    if (isCharacter) {
+        emit(Op::PRINT_C, value);
+    } else if (TypeAnalyzer::isArrayType(kind)) {
+        // b: how each element prints (0 integers, 1 floats, 2 strings)
+        VarDeclStmt::Kind elem = TypeAnalyzer::elementType(kind);
+        emit(Op::PRINT_ARR, value, elem == VarDeclStmt::STRING ? 2 : isFloatKind(elem) ? 1 : 0);
+    } else if (isIntegerKind(kind)) {
+        emit(Op::PRINT_L, value);
+    } else if (isFloatKind(kind)) {
+        emit(Op::PRINT_D, value);
+    } else if (kind == VarDeclStmt::STRING) {
+        emit(Op::PRINT_S, value);
+    }
+}
+
+void Interpreter::compileIf(const IfStmt *stmt) {
+    uint16_t cond = compileCondition(stmt->cond.get());
+    uint32_t skipThen = emitJump(Op::JMPF, cond);
+    pushScope();
+    compileBlock(stmt->thenBranch);
+    popScope();
+    if (stmt->elseBranch.empty()) {
+        patchJump(skipThen, fn->code.size());
+        return;
+    }
+    uint32_t skipElse = emitJump(Op::JMP);
+    patchJump(skipThen, fn->code.size());
+    pushScope();
+    compileBlock(stmt->elseBranch);
+    popScope();
+    patchJump(skipElse, fn->code.size());
+}
+
+void Interpreter::compileWhile(const WhileStmt *stmt) {
+    uint32_t top = fn->code.size();
+    uint16_t cond = compileCondition(stmt->cond.get());
+    uint32_t exit = emitJump(Op::JMPF, cond);
+    pushScope();
+    compileBlock(stmt->body);
+    popScope();
+    patchJump(emitJump(Op::JMP), top);
+    patchJump(exit, fn->code.size());
+}
+
+void Interpreter::compileFor(const ForStmt *stmt) {
+    pushScope();
+    if (stmt->init) compileStatement(stmt->init.get());
+    uint32_t top = fn->code.size();
+    uint32_t exit = UINT32_MAX;
+    if (stmt->cond) {
+        exit = emitJump(Op::JMPF, compileCondition(stmt->cond.get()));
+    }
+    compileBlock(stmt->body);
+    if (stmt->post) compileStatement(stmt->post.get());
+    patchJump(emitJump(Op::JMP), top);
+    if (exit != UINT32_MAX) patchJump(exit, fn->code.size());
+    popScope();
+}
+
+// The iterable and its length are evaluated once; the hidden index and the
+// array stay in registers of their own for the whole loop
+void Interpreter::compileForIn(const ForInStmt *stmt) {
+    if (typeAnalyzer.isLinesIterable(stmt->iterable.get())) unsupported("lines()", stmt->line, stmt->column);
+    VarDeclStmt::Kind iterKind = typeAnalyzer.inferType(stmt->iterable.get());
+    if (TypeAnalyzer::isChanType(iterKind)) unsupported("los canales", stmt->line, stmt->column);
+    if (TypeAnalyzer::isMapType(iterKind)) unsupported("los maps", stmt->line, stmt->column);
+    VarDeclStmt::Kind elemKind = typeAnalyzer.forInElementType(stmt);
+
+    uint16_t array = newLocal("", iterKind);
+    compileExprTo(stmt->iterable.get(), iterKind, array);
+    uint16_t length = newLocal("", VarDeclStmt::INT64);
+    emit(Op::ARR_LEN, length, array);
+    uint16_t index = newLocal("", VarDeclStmt::INT64);
+    loadConstant(Slot{0}, index);
+    uint16_t one = newLocal("", VarDeclStmt::INT64);
+    loadConstant(Slot{1}, one);
+
+    pushScope();
+    typeAnalyzer.declareVariable(stmt->var, elemKind);
+    uint16_t element = newLocal(stmt->var, elemKind);
+    uint32_t top = fn->code.size();
+    uint16_t more = newRegister();
+    emit(Op::LT_L, more, index, length);
+    uint32_t exit = emitJump(Op::JMPF, more);
+    emit(Op::ARR_GET, element, array, index);
+    compileBlock(stmt->body);
+    emit(Op::ADD_L, index, index, one);
+    patchJump(emitJump(Op::JMP), top);
+    patchJump(exit, fn->code.size());
+    popScope();
+}
+
+void Interpreter::compileReturn(const ReturnStmt *stmt) {
+    if (!stmt->value) {
+        emit(Op::RETV);
+        return;
+    }
+    if (returnKind == VarDeclStmt::VOID) {
+        std::cerr << "Error: tipo de retorno incompatible en '" << fn->name << "'\n";
+        std::cerr << "Compilación terminada debido a errores.\n";
+        std::exit(1);
+    }
+    emit(Op::RET, compileTyped(stmt->value.get(), returnKind));
+}
+
+uint16_t Interpreter::compileExpr(const Expr *expr) {
+    if (auto *lit = dynamic_cast<const LiteralExpr*>(expr)) {
+        Slot value{0};
+        if (std::holds_alternative<int>(lit->value)) {
+            value.i = std::get<int>(lit->value);
+        } else if (std::holds_alternative<long long>(lit->value)) {
+            value.i = std::get<long long>(lit->value);
+        } else if (std::holds_alternative<double>(lit->value)) {
+            value.f = static_cast<float>(std::get<double>(lit->value)); // float literal
+        } else if (std::holds_alternative<std::string>(lit->value)) {
+            value.s = internString(std::get<std::string>(lit->value));
+        } else {
+            value.i = std::get<bool>(lit->value);
+        }
+        return loadConstant(value, newRegister());
+    }
+    if (auto *var = dynamic_cast<const VarExpr*>(expr)) {
+        const Local *local = findLocal(var->name);
+        if (!local) {
+            std::cerr << "Runtime Error (line " << var->line << ":" << var->column << "): Variable '" << var->name << "' is not accessible in current scope\n";
+            std::exit(1);
+        }
+        return local->reg;
+    }
+    if (auto *bin = dynamic_cast<const BinaryExpr*>(expr)) {
+        return compileBinary(bin);
+    }
+    if (auto *unary = dynamic_cast<const UnaryExpr*>(expr)) {
+        const Local *local = findLocal(unary->varName);
+        if (!local) {
+            std::cerr << "Runtime Error (line " << expr->line << ":" << expr->column << "): Variable '" << unary->varName << "' is not accessible in current scope\n";
+            std::exit(1);
+        }
+        if (!isIntegerKind(local->kind)) unsupported("++/-- sobre valores no enteros", expr->line, expr->column);
+        uint16_t one = loadConstant(Slot{1}, newRegister());
+        bool inc = unary->op == UnaryExpr::Op::PRE_INC;
+        if (local->kind == VarDeclStmt::INT) {
+            emit(inc ? Op::ADD_I : Op::SUB_I, local->reg, local->reg, one);
+        } else {
+            emit(inc ? Op::ADD_L : Op::SUB_L, local->reg, local->reg, one);
+        }
+        return local->reg;
+    }
+    if (auto *array = dynamic_cast<const ArrayExpr*>(expr)) {
+        if (array->elements.empty()) unsupported("un array literal vacío", expr->line, expr->column);
+        return compileTyped(expr, TypeAnalyzer::arrayTypeOf(typeAnalyzer.inferType(array->elements[0].get())));
+    }
+    if (auto *index = dynamic_cast<const IndexExpr*>(expr)) {
+        return compileIndex(index);
+    }
+    if (auto *slice = dynamic_cast<const SliceExpr*>(expr)) {
+        typeAnalyzer.inferType(slice); // reports slices of non-arrays
+        uint16_t array = compileExpr(slice->array.get());
+        // lo and hi go in consecutive registers for SLICE
+        uint16_t bounds = newRegister();
+        newRegister();
+        if (slice->lo) {
+            compileExprTo(slice->lo.get(), VarDeclStmt::INT, bounds);
+        } else {
+            loadConstant(Slot{0}, bounds);
+        }
+        if (slice->hi) {
+            compileExprTo(slice->hi.get(), VarDeclStmt::INT, bounds + 1);
+        } else {
+            emit(Op::ARR_LEN, bounds + 1, array);
+        }
+        uint16_t result = newRegister();
+        auto *var = dynamic_cast<const VarExpr*>(slice->array.get());
+        fn->checkNames[emit(Op::SLICE, result, array, bounds)] = var ? var->name : "slice";
+        return result;
+    }
+    if (auto *interp = dynamic_cast<const InterpExpr*>(expr)) {
+        typeAnalyzer.inferType(interp); // reports holes that are not numbers or strings
+        uint16_t builder = newRegister();
+        emit(Op::SB_NEW, builder);
+        compileAppend(builder, interp);
+        uint16_t result = newRegister();
+        emit(Op::SB_FINISH, result, builder);
+        return result;
+    }
+    if (auto *call = dynamic_cast<const CallExpr*>(expr)) {
+        return compileCall(call);
+    }
+    if (dynamic_cast<const MapExpr*>(expr)) unsupported("los maps", expr->line, expr->column);
+    unsupported("los canales", expr->line, expr->column);
+}
+
+// Numeric literals become constants of the expected kind (a float literal
+// read as a double keeps its double precision), array literals take its
+// element kind and anything else is converted, as in generateTyped
+uint16_t Interpreter::compileTyped(const Expr *expr, VarDeclStmt::Kind kind) {
+    if (auto *lit = dynamic_cast<const LiteralExpr*>(expr)) {
+        bool isInt = kind == VarDeclStmt::INT || kind == VarDeclStmt::INT64;
+        if (isInt || isFloatKind(kind)) {
+            Slot value{0};
+            bool folded = true;
+            double number = 0;
+            if (std::holds_alternative<int>(lit->value)) {
+                number = std::get<int>(lit->value);
+            } else if (std::holds_alternative<long long>(lit->value)) {
+                number = static_cast<double>(std::get<long long>(lit->value));
+                if (isInt) {
+                    long long v = std::get<long long>(lit->value);
+                    value.i = kind == VarDeclStmt::INT ? static_cast<int32_t>(v) : v;
+                }
+            } else if (std::holds_alternative<double>(lit->value) && !isInt) {
+                number = std::get<double>(lit->value);
+            } else {
+                folded = false;
+            }
+            if (folded) {
+                if (kind == VarDeclStmt::FLOAT) {
+                    value.f = static_cast<float>(number);
+                } else if (kind == VarDeclStmt::DOUBLE) {
+                    value.f = number;
+                } else if (!std::holds_alternative<long long>(lit->value)) {
+                    value.i = static_cast<long long>(number);
+                }
+                return loadConstant(value, newRegister());
+            }
+        }
+    }
+    if (auto *array = dynamic_cast<const ArrayExpr*>(expr)) {
+        if (TypeAnalyzer::isArrayType(kind) && !array->elements.empty()) {
+            if (array->elements.size() > UINT16_MAX) unsupported("un array literal tan largo", expr->line, expr->column);
+            // Built in a temporary so a = [a[1], a[0]] still reads the old a
+            VarDeclStmt::Kind elemKind = TypeAnalyzer::elementType(kind);
+            uint16_t result = newRegister();
+            uint32_t count = array->elements.size();
+            emit(Op::ARR_NEW, result, static_cast<uint16_t>(count), static_cast<uint16_t>(count >> 16));
+            for (size_t i = 0; i < array->elements.size(); ++i) {
+                uint16_t value = compileTyped(array->elements[i].get(), elemKind);
+                emit(Op::ARR_INIT, result, static_cast<uint16_t>(i), value);
+            }
+            return result;
+        }
+    }
+
+    VarDeclStmt::Kind from = typeAnalyzer.inferType(expr);
+    uint16_t value = compileExpr(expr);
+    if (from == kind || (TypeAnalyzer::isArrayType(from) && TypeAnalyzer::isArrayType(kind))) {
+        return value;
+    }
+    uint16_t result = newRegister();
+    convert(value, from, kind, result, expr);
+    return result;
+}
+
+void Interpreter::compileExprTo(const Expr *expr, VarDeclStmt::Kind kind, uint16_t dest) {
+    moveTo(compileTyped(expr, kind), dest);
+}
+
+void Interpreter::convert(uint16_t src, VarDeclStmt::Kind from, VarDeclStmt::Kind to, uint16_t dest, const Expr *where) {
+    if (from == to) {
+        moveTo(src, dest);
+        return;
+    }
+    bool fromInt = isIntegerKind(from);
+    bool fromFloat = isFloatKind(from);
+    if (to == VarDeclStmt::BOOL) {
+        emit(fromFloat ? Op::TRUTH_D : Op::TRUTH_L, dest, src);
+        return;
+    }
+    if (fromInt || fromFloat) {
+        switch (to) {
+            case VarDeclStmt::INT:
+                emit(fromFloat ? Op::D2I : from == VarDeclStmt::INT64 ? Op::TO_I32 : Op::MOVE, dest, src);
+                return;
+            case VarDeclStmt::INT64:
+                emit(fromFloat ? Op::D2L : Op::MOVE, dest, src);
+                return;
+            case VarDeclStmt::FLOAT:
+                emit(fromFloat ? Op::D2F : Op::I2F, dest, src);
+                return;
+            case VarDeclStmt::DOUBLE:
+                emit(fromFloat ? Op::MOVE : Op::I2D, dest, src);
+                return;
+            default:
+                break;
+        }
+    }
+    std::cerr << "Error (line " << where->line << ":" << where->column
+              << "): no se puede convertir el valor al tipo esperado\n";
+    std::exit(1);
+}
+
+uint16_t Interpreter::compileCondition(const Expr *expr) {
+    VarDeclStmt::Kind kind = typeAnalyzer.inferType(expr);
+    uint16_t value = compileExpr(expr);
+    if (kind == VarDeclStmt::BOOL) return value;
+    uint16_t result = newRegister();
+    // Strings and arrays are true when non-null, like their pointers
+    emit(isFloatKind(kind) ? Op::TRUTH_D : Op::TRUTH_L, result, value);
+    return result;
+}
+
+uint16_t Interpreter::compileBinary(const BinaryExpr *bin) {
+    VarDeclStmt::Kind leftType = typeAnalyzer.inferType(bin->left.get());
+    VarDeclStmt::Kind rightType = typeAnalyzer.inferType(bin->right.get());
+    bool leftNumericArray = TypeAnalyzer::isArrayType(leftType) && leftType != VarDeclStmt::STRING_ARRAY;
+    bool rightNumericArray = TypeAnalyzer::isArrayType(rightType) && rightType != VarDeclStmt::STRING_ARRAY;
+
+    if (leftNumericArray && rightNumericArray &&
+        (bin->op == BinaryExpr::Op::ADD || bin->op == BinaryExpr::Op::MUL)) {
+        return compileArrayOperation(bin);
+    }
+    if (leftNumericArray && TypeAnalyzer::isNumericType(rightType) && rightType != VarDeclStmt::BOOL &&
+        bin->op == BinaryExpr::Op::MUL) {
+        return compileArrayOperation(bin);
+    }
+
+    if (bin->op == BinaryExpr::Op::ADD &&
+        (leftType == VarDeclStmt::STRING || rightType == VarDeclStmt::STRING)) {
+        uint16_t left = compileAsString(bin->left.get());
+        uint16_t right = compileAsString(bin->right.get());
+        uint16_t result = newRegister();
+        emit(Op::CONCAT, result, left, right);
+        return result;
+    }
+
+    bool comparison = bin->op == BinaryExpr::Op::EQ || bin->op == BinaryExpr::Op::NEQ ||
+                      bin->op == BinaryExpr::Op::LT || bin->op == BinaryExpr::Op::LE ||
+                      bin->op == BinaryExpr::Op::GT || bin->op == BinaryExpr::Op::GE;
+    if (comparison && (leftType == VarDeclStmt::STRING || rightType == VarDeclStmt::STRING)) {
+        if (leftType != VarDeclStmt::STRING || rightType != VarDeclStmt::STRING) {
+            std::cerr << "Error (line " << bin->line << ":" << bin->column
+                      << "): no se puede comparar un string con un valor de otro tipo\n";
+            std::exit(1);
+        }
+        uint16_t left = compileExpr(bin->left.get());
+        uint16_t right = compileExpr(bin->right.get());
+        uint16_t result = newRegister();
+        static const Op stringOps[] = {Op::EQ_S, Op::NE_S, Op::LT_S, Op::LE_S, Op::GT_S, Op::GE_S};
+        emit(stringOps[static_cast<int>(bin->op) - static_cast<int>(BinaryExpr::Op::EQ)], result, left, right);
+        return result;
+    }
+
+    // Short-circuit && and ||: the right side only runs when needed
+    if (bin->op == BinaryExpr::Op::AND || bin->op == BinaryExpr::Op::OR) {
+        uint16_t result = newRegister();
+        moveTo(compileCondition(bin->left.get()), result);
+        uint32_t done = emitJump(bin->op == BinaryExpr::Op::AND ? Op::JMPF : Op::JMPT, result);
+        moveTo(compileCondition(bin->right.get()), result);
+        patchJump(done, fn->code.size());
+        return result;
+    }
+
+    if (!TypeAnalyzer::isNumericType(leftType) || !TypeAnalyzer::isNumericType(rightType)) {
+        unsupported("esta operación entre valores no numéricos", bin->line, bin->column);
+    }
+    bool boolEquality = leftType == VarDeclStmt::BOOL && rightType == VarDeclStmt::BOOL &&
+                        (bin->op == BinaryExpr::Op::EQ || bin->op == BinaryExpr::Op::NEQ);
+    VarDeclStmt::Kind operandType = boolEquality ? VarDeclStmt::BOOL
+                                                 : TypeAnalyzer::promoteNumeric(leftType, rightType);
+    uint16_t left = compileTyped(bin->left.get(), operandType);
+    // x + ++x: the left operand is read before the right one runs
+    if (left < localTop && writesVariables(bin->right.get())) {
+        uint16_t copy = newRegister();
+        emit(Op::MOVE, copy, left);
+        left = copy;
+    }
+    uint16_t right = compileTyped(bin->right.get(), operandType);
+    uint16_t result = newRegister();
+
+    if (comparison) {
+        static const Op intOps[] = {Op::EQ_L, Op::NE_L, Op::LT_L, Op::LE_L, Op::GT_L, Op::GE_L};
+        static const Op floatOps[] = {Op::EQ_D, Op::NE_D, Op::LT_D, Op::LE_D, Op::GT_D, Op::GE_D};
+        int which = static_cast<int>(bin->op) - static_cast<int>(BinaryExpr::Op::EQ);
+        emit(isFloatKind(operandType) ? floatOps[which] : intOps[which], result, left, right);
+        return result;
+    }
+    int which = static_cast<int>(bin->op) - static_cast<int>(BinaryExpr::Op::ADD);
+    static const Op intOps[] = {Op::ADD_I, Op::SUB_I, Op::MUL_I, Op::DIV_I};
+    static const Op longOps[] = {Op::ADD_L, Op::SUB_L, Op::MUL_L, Op::DIV_L};
+    static const Op floatOps[] = {Op::ADD_F, Op::SUB_F, Op::MUL_F, Op::DIV_F};
+    static const Op doubleOps[] = {Op::ADD_D, Op::SUB_D, Op::MUL_D, Op::DIV_D};
+    switch (operandType) {
+        case VarDeclStmt::INT: emit(intOps[which], result, left, right); break;
+        case VarDeclStmt::FLOAT: emit(floatOps[which], result, left, right); break;
+        case VarDeclStmt::DOUBLE: emit(doubleOps[which], result, left, right); break;
+        default: emit(longOps[which], result, left, right); break;
+    }
+    return result;
+}
+
+// a + b and a * b element by element, a * s scaling by a scalar; the result
+// is a new array as long as a (b must be at least as long)
+uint16_t Interpreter::compileArrayOperation(const BinaryExpr *bin) {
+    VarDeclStmt::Kind leftType = typeAnalyzer.inferType(bin->left.get());
+    VarDeclStmt::Kind rightType = typeAnalyzer.inferType(bin->right.get());
+    bool scalar = !TypeAnalyzer::isArrayType(rightType);
+    VarDeclStmt::Kind leftElem = TypeAnalyzer::elementType(leftType);
+    VarDeclStmt::Kind rightElem = scalar ? rightType : TypeAnalyzer::elementType(rightType);
+    VarDeclStmt::Kind resultElem = TypeAnalyzer::promoteNumeric(leftElem, rightElem);
+    bool add = bin->op == BinaryExpr::Op::ADD;
+
+    uint16_t left = compileExpr(bin->left.get());
+    uint16_t right = scalar ? compileTyped(bin->right.get(), resultElem) : compileExpr(bin->right.get());
+    uint16_t length = newRegister();
+    emit(Op::ARR_LEN, length, left);
+    uint16_t result = newRegister();
+    emit(Op::ARR_ALLOC, result, length);
+    uint16_t index = loadConstant(Slot{0}, newRegister());
+    uint16_t one = loadConstant(Slot{1}, newRegister());
+
+    uint32_t top = fn->code.size();
+    uint16_t more = newRegister();
+    emit(Op::LT_L, more, index, length);
+    uint32_t exit = emitJump(Op::JMPF, more);
+    uint16_t x = newRegister();
+    emit(Op::ARR_GET, x, left, index);
+    if (leftElem != resultElem) convert(x, leftElem, resultElem, x, bin);
+    uint16_t y = right;
+    if (!scalar) {
+        y = newRegister();
+        fn->checkNames[emit(Op::ARR_GET, y, right, index)] = "array_op";
+        if (rightElem != resultElem) convert(y, rightElem, resultElem, y, bin);
+    }
+    uint16_t z = newRegister();
+    switch (resultElem) {
+        case VarDeclStmt::INT: emit(add ? Op::ADD_I : Op::MUL_I, z, x, y); break;
+        case VarDeclStmt::FLOAT: emit(add ? Op::ADD_F : Op::MUL_F, z, x, y); break;
+        case VarDeclStmt::DOUBLE: emit(add ? Op::ADD_D : Op::MUL_D, z, x, y); break;
+        default: emit(add ? Op::ADD_L : Op::MUL_L, z, x, y); break;
+    }
+    emit(Op::ARR_SET, result, index, z);
+    emit(Op::ADD_L, index, index, one);
+    patchJump(emitJump(Op::JMP), top);
+    patchJump(exit, fn->code.size());
+    return result;
+}
+
+uint16_t Interpreter::compileAsString(const Expr *expr) {
+    VarDeclStmt::Kind kind = typeAnalyzer.inferType(expr);
+    if (kind == VarDeclStmt::STRING) return compileExpr(expr);
+    if (!TypeAnalyzer::isNumericType(kind)) {
+        std::cerr << "Error (line " << expr->line << ":" << expr->column
+                  << "): solo se pueden concatenar números o strings a un string\n";
+        std::exit(1);
+    }
+    uint16_t value = compileExpr(expr);
+    uint16_t result = newRegister();
+    emit(isFloatKind(kind) ? Op::STR_D : Op::STR_L, result, value);
+    return result;
+}
+
+uint16_t Interpreter::compileIndex(const IndexExpr *index) {
+    auto *var = dynamic_cast<const VarExpr*>(index->array.get());
+    if (!var) unsupported("indexar algo que no es una variable", index->line, index->column);
+    const Local *local = findLocal(var->name);
+    if (local && TypeAnalyzer::isMapType(local->kind)) unsupported("los maps", index->line, index->column);
+
+    VarDeclStmt::Kind indexKind = typeAnalyzer.inferType(index->index.get());
+    uint16_t position = compileTyped(index->index.get(), isIntegerKind(indexKind) ? indexKind : VarDeclStmt::INT64);
+    if (!local || (local->kind != VarDeclStmt::STRING && !TypeAnalyzer::isArrayType(local->kind))) {
+        std::cerr << "Error: variable array no encontrada '" << var->name << "'\n";
+        std::cerr << "Compilación terminada debido a errores.\n";
+        std::exit(1);
+    }
+    uint16_t result = newRegister();
+    Op op = local->kind == VarDeclStmt::STRING ? Op::STR_CHAR : Op::ARR_GET;
+    fn->checkNames[emit(op, result, local->reg, position)] = var->name;
+    return result;
+}
+
+void Interpreter::compileAppend(uint16_t builder, const Expr *value) {
+    if (auto *interp = dynamic_cast<const InterpExpr*>(value)) {
+        for (size_t i = 0; i < interp->segments.size(); ++i) {
+            if (!interp->segments[i].empty()) {
+                Slot text;
+                text.s = internString(interp->segments[i]);
+                emit(Op::SB_APPEND_S, builder, loadConstant(text, newRegister()));
+            }
+            if (i < interp->holes.size()) compileAppend(builder, interp->holes[i].get());
+        }
+        return;
+    }
+    VarDeclStmt::Kind kind = typeAnalyzer.inferType(value);
+    if (kind != VarDeclStmt::STRING && !TypeAnalyzer::isNumericType(kind)) {
+        std::cerr << "Error (line " << value->line << ":" << value->column
+                  << "): solo se pueden añadir números o strings a un string\n";
+        std::exit(1);
+    }
+    uint16_t reg = compileExpr(value);
+    Op op = kind == VarDeclStmt::STRING ? Op::SB_APPEND_S : isFloatKind(kind) ? Op::SB_APPEND_D : Op::SB_APPEND_L;
+    emit(op, builder, reg);
+}
+
+uint16_t Interpreter::compileCall(const CallExpr *call) {
+    if (typeAnalyzer.isMapBuiltin(call)) unsupported("los maps", call->line, call->column);
+    if (typeAnalyzer.isFileBuiltin(call)) {
+        if (call->callee != "readFile") unsupported(call->callee + "()", call->line, call->column);
+        uint16_t path = compileExpr(call->args[0].get());
+        uint16_t result = newRegister();
+        emit(Op::READ_FILE, result, path);
+        return result;
+    }
+    if (typeAnalyzer.isReadBuiltin(call)) {
+        uint16_t result = newRegister();
+        emit(call->callee == "readInt" ? Op::READ_INT : call->callee == "readFloat" ? Op::READ_FLOAT : Op::READ_LINE, result);
+        return result;
+    }
+    if (typeAnalyzer.isBuilderBuiltin(call)) {
+        typeAnalyzer.inferType(call); // argument checks
+        if (call->callee == "builder") {
+            uint16_t result = newRegister();
+            emit(Op::SB_NEW, result);
+            return result;
+        }
+        uint16_t builder = compileExpr(call->args[0].get());
+        if (call->callee == "append") {
+            compileAppend(builder, call->args[1].get());
+            return builder;
+        }
+        uint16_t result = newRegister();
+        emit(Op::SB_FINISH, result, builder);
+        return result;
+    }
+    if (typeAnalyzer.isLenBuiltin(call)) {
+        if (TypeAnalyzer::isMapType(typeAnalyzer.inferType(call->args[0].get()))) {
+            unsupported("los maps", call->line, call->column);
+        }
+        uint16_t array = compileExpr(call->args[0].get());
+        uint16_t result = newRegister();
+        emit(Op::ARR_LEN, result, array);
+        return result;
+    }
+
+    auto declIt = functionDecls.find(call->callee);
+    if (declIt == functionDecls.end()) {
+        std::cerr << "Error fatal: función no declarada '" << call->callee << "'\n";
+        std::cerr << "Compilación terminada debido a errores.\n";
+        std::exit(1);
+    }
+    std::vector<VarDeclStmt::Kind> argKinds = typeAnalyzer.analyzeCallExpr(call);
+    uint16_t callee = specialize(declIt->second, argKinds);
+
+    // Arguments go in consecutive registers; CALL copies them into the
+    // callee's first registers
+    uint16_t args = nextReg;
+    for (size_t i = 0; i < call->args.size(); ++i) {
+        newRegister();
+    }
+    for (size_t i = 0; i < call->args.size(); ++i) {
+        compileExprTo(call->args[i].get(), argKinds[i], args + i);
+    }
+    uint16_t result = newRegister();
+    emit(Op::CALL, result, callee, args);
+    return result;
+}
+
+uint16_t Interpreter::specialize(const FunctionStmt *decl, const std::vector<VarDeclStmt::Kind> &argKinds) {
+    if (argKinds.size() != decl->params.size()) {
+        std::cerr << "Error: la función '" << decl->name << "' espera " << decl->params.size()
+                  << " argumentos pero recibió " << argKinds.size() << "\n";
+        std::cerr << "Compilación terminada debido a errores.\n";
+        std::exit(1);
+    }
+    std::string mangledName = decl->name;
+    for (size_t i = 0; i < argKinds.size(); ++i) {
+        if (i < decl->paramIsArray.size() && decl->paramIsArray[i] && !TypeAnalyzer::isArrayType(argKinds[i])) {
+            std::cerr << "Error: el parámetro '" << decl->params[i] << "' de '" << decl->name
+                      << "' espera un array\n";
+            std::cerr << "Compilación terminada debido a errores.\n";
+            std::exit(1);
+        }
+        if (argKinds[i] == VarDeclStmt::VOID) {
+            std::cerr << "Error: argumento sin valor en la llamada a '" << decl->name << "'\n";
+            std::cerr << "Compilación terminada debido a errores.\n";
+            std::exit(1);
+        }
+        if (TypeAnalyzer::isChanType(argKinds[i])) unsupported("los canales", decl->line, decl->column);
+        if (TypeAnalyzer::isMapType(argKinds[i])) unsupported("los maps", decl->line, decl->column);
+        mangledName += "." + std::to_string(argKinds[i]);
+    }
+    auto cached = specializations.find(mangledName);
+    if (cached != specializations.end()) {
+        return cached->second;
+    }
+    if (functions.size() > UINT16_MAX) {
+        std::cerr << "Error: demasiadas funciones para --interp\n";
+        std::exit(1);
+    }
+
+    uint16_t index = static_cast<uint16_t>(functions.size());
+    specializations[mangledName] = index;
+    VarDeclStmt::Kind kind = typeAnalyzer.inferReturnType(decl->name, argKinds);
+    functions.push_back(std::make_unique<Function>());
+    functions[index]->decl = decl;
+    functions[index]->paramKinds = argKinds;
+    functions[index]->returnKind = kind;
+
+    // Compile the body now, in a fresh frame, then resume the caller
+    Function *savedFn = fn;
+    VarDeclStmt::Kind savedReturnKind = returnKind;
+    auto savedScopes = std::move(scopes);
+    auto savedMarks = std::move(scopeMarks);
+    uint16_t savedNextReg = nextReg;
+    uint16_t savedLocalTop = localTop;
+    uint32_t savedLabel = labelPc;
+
+    fn = functions[index].get();
+    fn->name = decl->name;
+    fn->numParams = static_cast<uint16_t>(argKinds.size());
+    returnKind = kind;
+    scopes.clear();
+    scopeMarks.clear();
+    nextReg = localTop = 0;
+    labelPc = UINT32_MAX;
+
+    pushScope();
+    for (size_t i = 0; i < decl->params.size(); ++i) {
+        typeAnalyzer.declareVariable(decl->params[i], argKinds[i]);
+        newLocal(decl->params[i], argKinds[i]);
+    }
+    compileBlock(decl->body);
+    if (kind == VarDeclStmt::VOID) {
+        emit(Op::RETV);
+    } else {
+        emit(Op::RET, loadConstant(Slot{0}, newRegister()));
+    }
+    popScope();
+
+    fn = savedFn;
+    returnKind = savedReturnKind;
+    scopes = std::move(savedScopes);
+    scopeMarks = std::move(savedMarks);
+    nextReg = savedNextReg;
+    localTop = savedLocalTop;
+    labelPc = savedLabel;
+    return index;
+}
@@ -4,41 +4,55 @@
 #include <cstdlib>
 
 void CodeGenerator::generateVarDecl(const VarDeclStmt *stmt) {
+    // Channel and map handles do not convert between element kinds
+    if (TypeAnalyzer::isChanType(stmt->type) && typeAnalyzer.inferType(stmt->init.get()) != stmt->type) {
+        std::cerr << "Error (line " << stmt->line << ":" << stmt->column << "): el canal '" << stmt->name
+                  << "' se inicializa con un valor de otro tipo\n";
+        std::exit(1);
+    }
+    if (TypeAnalyzer::isMapType(stmt->type) && typeAnalyzer.inferType(stmt->init.get()) != stmt->type) {
+        std::cerr << "Error (line " << stmt->line << ":" << stmt->column << "): el map '" << stmt->name
+                  << "' se inicializa con un valor de otro tipo\n";
+        std::exit(1);
+    }
+    // A slice keeps the element kind of the array it views
+    if (dynamic_cast<const SliceExpr*>(stmt->init.get()) && typeAnalyzer.inferType(stmt->init.get()) != stmt->type) {
+        std::cerr << "Error (line " << stmt->line << ":" << stmt->column << "): el array '" << stmt->name
+                  << "' se inicializa con un slice de otro tipo\n";
+        std::exit(1);
+    }
+
     // First declare the variable in type analyzer
     typeAnalyzer.declareVariable(stmt->name, stmt->type);
 
-    // Check if the init expression is an array to store its size
-    if (auto *arrayExpr = dynamic_cast<const ArrayExpr*>(stmt->init.get())) {
-        arraySizes[stmt->name] = arrayExpr->elements.size();
-    }
-
-    llvm::Value *initVal = generate(stmt->init.get());
+    llvm::Value *initVal = generateTyped(stmt->init.get(), stmt->type);
     if (!initVal) return;
 
     llvm::Type *varType = getLLVMType(stmt->type);
     
     // For arrays, we need to handle them differently
-    if (stmt->type == VarDeclStmt::INT_ARRAY || 
-        stmt->type == VarDeclStmt::FLOAT_ARRAY || 
-        stmt->type == VarDeclStmt::STRING_ARRAY) {
+    if (TypeAnalyzer::isArrayType(stmt->type)) {
         
         // For array types, store the pointer to the array
         llvm::AllocaInst *alloca = createEntryBlockAlloca(stmt->name, varType);
         builder.CreateStore(initVal, alloca);
         declareVariable(stmt->name, alloca);
         variableTypes[stmt->name] = stmt->type;
+        declareDebugVariable(stmt->name, alloca, stmt->type, stmt->line, stmt->column);
+        recordArrayLength(stmt->name, stmt->init.get());
     } else {
         // Regular variables
         llvm::AllocaInst *alloca = createEntryBlockAlloca(stmt->name, varType);
 
         // Type conversion if needed
-        if (stmt->type == VarDeclStmt::FLOAT && initVal->getType()->isIntegerTy()) {
-            initVal = builder.CreateSIToFP(initVal, llvm::Type::getFloatTy(context), "int_to_float");
+        if (llvm::Value *converted = convertValue(initVal, varType)) {
+            initVal = converted;
         }
 
         builder.CreateStore(initVal, alloca);
         declareVariable(stmt->name, alloca);
         variableTypes[stmt->name] = stmt->type;
+        declareDebugVariable(stmt->name, alloca, stmt->type, stmt->line, stmt->column);
     }
 }
 
@@ -47,39 +61,19 @@ void CodeGenerator::generateInferDecl(const InferDeclStmt *stmt) {
     VarDeclStmt::Kind inferredType = typeAnalyzer.inferType(stmt->init.get());
     typeAnalyzer.declareVariable(stmt->name, inferredType);
 
-    // Check if the init expression is an array to store its size
-    if (auto *arrayExpr = dynamic_cast<const ArrayExpr*>(stmt->init.get())) {
-        arraySizes[stmt->name] = arrayExpr->elements.size();
-    }
-    // Handle array operations result size
-    else if (auto *binExpr = dynamic_cast<const BinaryExpr*>(stmt->init.get())) {
-        if (inferredType == VarDeclStmt::INT_ARRAY || inferredType == VarDeclStmt::FLOAT_ARRAY) {
-            // For array operations, get size from one of the operands
-            if (auto *leftVar = dynamic_cast<const VarExpr*>(binExpr->left.get())) {
-                if (arraySizes.find(leftVar->name) != arraySizes.end()) {
-                    arraySizes[stmt->name] = arraySizes[leftVar->name];
-                }
-            } else if (auto *rightVar = dynamic_cast<const VarExpr*>(binExpr->right.get())) {
-                if (arraySizes.find(rightVar->name) != arraySizes.end()) {
-                    arraySizes[stmt->name] = arraySizes[rightVar->name];
-                }
-            }
-        }
-    }
-
     llvm::Value *initVal = generate(stmt->init.get());
     if (!initVal) return;
 
     // For inferred array types, we need special handling
-    if (inferredType == VarDeclStmt::INT_ARRAY || 
-        inferredType == VarDeclStmt::FLOAT_ARRAY || 
-        inferredType == VarDeclStmt::STRING_ARRAY) {
+    if (TypeAnalyzer::isArrayType(inferredType)) {
         
         llvm::Type *varType = getLLVMType(inferredType);
         llvm::AllocaInst *alloca = createEntryBlockAlloca(stmt->name, varType);
         builder.CreateStore(initVal, alloca);
         declareVariable(stmt->name, alloca);
         variableTypes[stmt->name] = inferredType;
+        declareDebugVariable(stmt->name, alloca, inferredType, stmt->line, stmt->column);
+        recordArrayLength(stmt->name, stmt->init.get());
     } else {
         // Regular inferred variables
         llvm::Type *varType = getLLVMType(inferredType);
@@ -89,6 +83,7 @@ void CodeGenerator::generateInferDecl(const InferDeclStmt *stmt) {
         builder.CreateStore(initVal, alloca);
         declareVariable(stmt->name, alloca);
         variableTypes[stmt->name] = inferredType;
+        declareDebugVariable(stmt->name, alloca, inferredType, stmt->line, stmt->column);
     }
 }
 
@@ -99,32 +94,114 @@ void CodeGenerator::generateAssign(const AssignStmt *stmt) {
         std::exit(1);
     }
 
-    llvm::Value *val = generate(stmt->expr.get());
+    // s = s + ... inside a loop that builds s (see beginLoopBuilders)
+    if (loopBuilders.count(stmt->name)) {
+        generateLoopAppend(stmt);
+        return;
+    }
+
+    VarDeclStmt::Kind kind = typeAnalyzer.getVariableType(stmt->name);
+    bool isArray = TypeAnalyzer::isArrayType(kind);
+    if ((isArray || TypeAnalyzer::isMapType(kind) || kind == VarDeclStmt::BUILDER) &&
+        typeAnalyzer.inferType(stmt->expr.get()) != kind) {
+        std::cerr << "Error (line " << stmt->line << ":" << stmt->column << "): no se puede asignar un valor de otro tipo a '"
+                  << stmt->name << "'\n";
+        std::exit(1);
+    }
+
+    llvm::Value *val = generateTyped(stmt->expr.get(), kind);
     if (!val) return;
 
     llvm::AllocaInst *alloca = findVariable(stmt->name);
     if (alloca) {
         // Type conversion if needed
-        VarDeclStmt::Kind varType = variableTypes[stmt->name];
-        if (varType == VarDeclStmt::FLOAT && val->getType()->isIntegerTy()) {
-            val = builder.CreateSIToFP(val, llvm::Type::getFloatTy(context), "int_to_float");
+        if (llvm::Value *converted = convertValue(val, alloca->getAllocatedType())) {
+            val = converted;
         }
         builder.CreateStore(val, alloca);
+
+        // The array variable now views other storage (s = s[1:]), so its
+        // length follows; fixed-size arrays only accept the same size
+        if (isArray) {
+            llvm::Value *length = getArrayLength(stmt->expr.get());
+            auto lenIt = arrayLengths.find(stmt->name);
+            auto sizeIt = arraySizes.find(stmt->name);
+            auto *constLength = llvm::dyn_cast_or_null<llvm::ConstantInt>(length);
+            if (lenIt != arrayLengths.end() && length) {
+                builder.CreateStore(builder.CreateSExt(length, llvm::Type::getInt64Ty(context)), lenIt->second);
+            } else if (sizeIt == arraySizes.end() || !constLength || constLength->getSExtValue() != sizeIt->second) {
+                std::cerr << "Error (line " << stmt->line << ":" << stmt->column << "): el array '" << stmt->name
+                          << "' tiene tamaño fijo; declare un slice (s := " << stmt->name
+                          << "[:]) para reasignarlo con otra longitud\n";
+                std::exit(1);
+            }
+        }
     } else {
         std::cerr << "Runtime Error (line " << stmt->line << ":" << stmt->column << "): Variable '" << stmt->name << "' is not accessible in current scope\n";
         std::exit(1);
     }
 }
 
+void CodeGenerator::generateIndexAssign(const IndexAssignStmt *stmt) {
+    llvm::AllocaInst *arrayAlloca = findVariable(stmt->name);
+    auto typeIt = variableTypes.find(stmt->name);
+    if (arrayAlloca && typeIt != variableTypes.end() && TypeAnalyzer::isMapType(typeIt->second)) {
+        generateMapSet(stmt, typeIt->second);
+        return;
+    }
+    if (!arrayAlloca || typeIt == variableTypes.end() || !TypeAnalyzer::isArrayType(typeIt->second)) {
+        std::cerr << "Error (line " << stmt->line << ":" << stmt->column << "): '" << stmt->name
+                  << "' no es un array; solo se puede asignar a elementos de arrays y maps\n";
+        std::exit(1);
+    }
+
+    llvm::Value *indexVal = generate(stmt->index.get());
+    llvm::Value *val = generateTyped(stmt->expr.get(), TypeAnalyzer::elementType(typeIt->second));
+    if (!indexVal || !val) return;
+
+    llvm::Value *arrayPtr = builder.CreateLoad(arrayAlloca->getAllocatedType(), arrayAlloca, "array_load");
+
+    // Same checks as a read of name[index]
+    bool proven = false;
+    if (auto *indexVar = dynamic_cast<const VarExpr*>(stmt->index.get())) {
+        proven = provenIndexes.count({stmt->name, indexVar->name}) > 0;
+    }
+    if (!proven) {
+        if (llvm::Value *arraySize = getArrayLength(stmt->name)) {
+            createBoundsCheck(indexVal, arraySize, stmt->name);
+        }
+    }
+
+    llvm::Type *elemType = getLLVMType(TypeAnalyzer::elementType(typeIt->second));
+    llvm::Value *elemPtr = builder.CreateInBoundsGEP(elemType, arrayPtr, indexVal, "elem_ptr");
+    builder.CreateStore(val, elemPtr);
+}
+
+// Each node's own instructions carry its line: the location is set on entry
+// and put back once the node is done, so the instructions its parent emits
+// after generating it (the add, the call, the PHI of && and ||) get the
+// parent's line rather than that of its last operand
 llvm::Value* CodeGenerator::generate(const Expr *expr) {
+    llvm::DebugLoc parentLocation = builder.getCurrentDebugLocation();
+    emitDebugLocation(expr->line, expr->column);
+    llvm::Value *value = generateNode(expr);
+    builder.SetCurrentDebugLocation(parentLocation);
+    return value;
+}
+
+llvm::Value* CodeGenerator::generateNode(const Expr *expr) {
     if (auto *lit = dynamic_cast<const LiteralExpr*>(expr)) {
         if (std::holds_alternative<int>(lit->value))
             return llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), std::get<int>(lit->value));
-        if (std::holds_alternative<float>(lit->value))
-            return llvm::ConstantFP::get(llvm::Type::getFloatTy(context), std::get<float>(lit->value));
+        if (std::holds_alternative<long long>(lit->value))
+            return llvm::ConstantInt::get(llvm::Type::getInt64Ty(context), std::get<long long>(lit->value));
+        if (std::holds_alternative<double>(lit->value))
+            return llvm::ConstantFP::get(llvm::Type::getFloatTy(context), std::get<double>(lit->value));
         if (std::holds_alternative<std::string>(lit->value)) {
             return createStringConstant(std::get<std::string>(lit->value));
         }
+        if (std::holds_alternative<bool>(lit->value))
+            return builder.getInt1(std::get<bool>(lit->value));
     }
     else if (auto *var = dynamic_cast<const VarExpr*>(expr)) {
         llvm::AllocaInst *alloca = findVariable(var->name);
@@ -140,17 +217,18 @@ llvm::Value* CodeGenerator::generate(const Expr *expr) {
         VarDeclStmt::Kind leftType = typeAnalyzer.inferType(bin->left.get());
         VarDeclStmt::Kind rightType = typeAnalyzer.inferType(bin->right.get());
         
+        bool leftNumericArray = TypeAnalyzer::isArrayType(leftType) && leftType != VarDeclStmt::STRING_ARRAY;
+        bool rightNumericArray = TypeAnalyzer::isArrayType(rightType) && rightType != VarDeclStmt::STRING_ARRAY;
+
         // Array + Array operations (element-wise)
-        if ((leftType == VarDeclStmt::INT_ARRAY || leftType == VarDeclStmt::FLOAT_ARRAY) &&
-            (rightType == VarDeclStmt::INT_ARRAY || rightType == VarDeclStmt::FLOAT_ARRAY) &&
+        if (leftNumericArray && rightNumericArray &&
             (bin->op == BinaryExpr::Op::ADD || bin->op == BinaryExpr::Op::MUL)) {
             
             return generateArrayOperation(bin->left.get(), bin->right.get(), bin->op);
         }
         
         // Array * Scalar operations
-        if ((leftType == VarDeclStmt::INT_ARRAY || leftType == VarDeclStmt::FLOAT_ARRAY) &&
-            (rightType == VarDeclStmt::INT || rightType == VarDeclStmt::FLOAT) &&
+        if (leftNumericArray && TypeAnalyzer::isNumericType(rightType) && rightType != VarDeclStmt::BOOL &&
             bin->op == BinaryExpr::Op::MUL) {
             
             return generateArrayScalarOperation(bin->left.get(), bin->right.get(), bin->op);
@@ -163,18 +241,61 @@ llvm::Value* CodeGenerator::generate(const Expr *expr) {
             }
         }
 
-        llvm::Value *left = generate(bin->left.get());
-        llvm::Value *right = generate(bin->right.get());
-        if (!left || !right) return nullptr;
+        // String comparisons look at the contents, not the pointers
+        bool comparison = bin->op == BinaryExpr::Op::EQ || bin->op == BinaryExpr::Op::NEQ ||
+                          bin->op == BinaryExpr::Op::LT || bin->op == BinaryExpr::Op::LE ||
+                          bin->op == BinaryExpr::Op::GT || bin->op == BinaryExpr::Op::GE;
+        if (comparison && (leftType == VarDeclStmt::STRING || rightType == VarDeclStmt::STRING)) {
+            return generateStringCompare(bin);
+        }
 
-        // Type promotion for arithmetic operations
-        if (left->getType()->isIntegerTy() && right->getType()->isFloatTy()) {
-            left = builder.CreateSIToFP(left, llvm::Type::getFloatTy(context), "int_to_float");
-        } else if (left->getType()->isFloatTy() && right->getType()->isIntegerTy()) {
-            right = builder.CreateSIToFP(right, llvm::Type::getFloatTy(context), "int_to_float");
+        // Short-circuit && and ||: the right side only runs when needed
+        if (bin->op == BinaryExpr::Op::AND || bin->op == BinaryExpr::Op::OR) {
+            bool isAnd = bin->op == BinaryExpr::Op::AND;
+            llvm::Value *lhs = generateCondition(bin->left.get());
+            if (!lhs) return nullptr;
+
+            llvm::Function *function = currentFunction ? currentFunction : mainFunction;
+            llvm::BasicBlock *lhsBB = builder.GetInsertBlock();
+            llvm::BasicBlock *rhsBB = llvm::BasicBlock::Create(context, isAnd ? "and_rhs" : "or_rhs", function);
+            llvm::BasicBlock *endBB = llvm::BasicBlock::Create(context, isAnd ? "and_end" : "or_end", function);
+            if (isAnd) {
+                builder.CreateCondBr(lhs, rhsBB, endBB);
+            } else {
+                builder.CreateCondBr(lhs, endBB, rhsBB);
+            }
+
+            builder.SetInsertPoint(rhsBB);
+            llvm::Value *rhs = generateCondition(bin->right.get());
+            if (!rhs) return nullptr;
+            llvm::BasicBlock *rhsEndBB = builder.GetInsertBlock();
+            builder.CreateBr(endBB);
+
+            builder.SetInsertPoint(endBB);
+            llvm::PHINode *result = builder.CreatePHI(llvm::Type::getInt1Ty(context), 2, isAnd ? "andtmp" : "ortmp");
+            result->addIncoming(builder.getInt1(!isAnd), lhsBB);
+            result->addIncoming(rhs, rhsEndBB);
+            return result;
         }
 
-        bool isFloat = left->getType()->isFloatTy();
+        // Numeric operands are evaluated directly in their common kind
+        // (bools widen to int except when compared with each other)
+        llvm::Value *left;
+        llvm::Value *right;
+        if (TypeAnalyzer::isNumericType(leftType) && TypeAnalyzer::isNumericType(rightType)) {
+            bool boolEquality = leftType == VarDeclStmt::BOOL && rightType == VarDeclStmt::BOOL &&
+                                (bin->op == BinaryExpr::Op::EQ || bin->op == BinaryExpr::Op::NEQ);
+            VarDeclStmt::Kind operandType = boolEquality ? VarDeclStmt::BOOL
+                                                         : TypeAnalyzer::promoteNumeric(leftType, rightType);
+            left = generateTyped(bin->left.get(), operandType);
+            right = generateTyped(bin->right.get(), operandType);
+        } else {
+            left = generate(bin->left.get());
+            right = generate(bin->right.get());
+        }
+        if (!left || !right) return nullptr;
+
+        bool isFloat = left->getType()->isFloatingPointTy();
         
         switch (bin->op) {
             case BinaryExpr::Op::ADD:
@@ -191,56 +312,43 @@ llvm::Value* CodeGenerator::generate(const Expr *expr) {
                                : builder.CreateSDiv(left, right, "divtmp");
             case BinaryExpr::Op::LT:
                 if (isFloat) {
-                    llvm::Value *cmp = builder.CreateFCmpOLT(left, right, "lttmp");
-                    return builder.CreateZExt(cmp, llvm::Type::getInt32Ty(context), "booltmp");
+                    return builder.CreateFCmpOLT(left, right, "lttmp");
                 } else {
-                    llvm::Value *cmp = builder.CreateICmpSLT(left, right, "lttmp");
-                    return builder.CreateZExt(cmp, llvm::Type::getInt32Ty(context), "booltmp");
+                    return builder.CreateICmpSLT(left, right, "lttmp");
                 }
             case BinaryExpr::Op::LE:
                 if (isFloat) {
-                    llvm::Value *cmp = builder.CreateFCmpOLE(left, right, "letmp");
-                    return builder.CreateZExt(cmp, llvm::Type::getInt32Ty(context), "booltmp");
+                    return builder.CreateFCmpOLE(left, right, "letmp");
                 } else {
-                    llvm::Value *cmp = builder.CreateICmpSLE(left, right, "letmp");
-                    return builder.CreateZExt(cmp, llvm::Type::getInt32Ty(context), "booltmp");
+                    return builder.CreateICmpSLE(left, right, "letmp");
                 }
             case BinaryExpr::Op::GT:
                 if (isFloat) {
-                    llvm::Value *cmp = builder.CreateFCmpOGT(left, right, "gttmp");
-                    return builder.CreateZExt(cmp, llvm::Type::getInt32Ty(context), "booltmp");
+                    return builder.CreateFCmpOGT(left, right, "gttmp");
                 } else {
-                    llvm::Value *cmp = builder.CreateICmpSGT(left, right, "gttmp");
-                    return builder.CreateZExt(cmp, llvm::Type::getInt32Ty(context), "booltmp");
+                    return builder.CreateICmpSGT(left, right, "gttmp");
                 }
             case BinaryExpr::Op::GE:
                 if (isFloat) {
-                    llvm::Value *cmp = builder.CreateFCmpOGE(left, right, "getmp");
-                    return builder.CreateZExt(cmp, llvm::Type::getInt32Ty(context), "booltmp");
+                    return builder.CreateFCmpOGE(left, right, "getmp");
                 } else {
-                    llvm::Value *cmp = builder.CreateICmpSGE(left, right, "getmp");
-                    return builder.CreateZExt(cmp, llvm::Type::getInt32Ty(context), "booltmp");
+                    return builder.CreateICmpSGE(left, right, "getmp");
                 }
             case BinaryExpr::Op::EQ:
                 if (isFloat) {
-                    llvm::Value *cmp = builder.CreateFCmpOEQ(left, right, "eqtmp");
-                    return builder.CreateZExt(cmp, llvm::Type::getInt32Ty(context), "booltmp");
+                    return builder.CreateFCmpOEQ(left, right, "eqtmp");
                 } else {
-                    llvm::Value *cmp = builder.CreateICmpEQ(left, right, "eqtmp");
-                    return builder.CreateZExt(cmp, llvm::Type::getInt32Ty(context), "booltmp");
+                    return builder.CreateICmpEQ(left, right, "eqtmp");
                 }
             case BinaryExpr::Op::NEQ:
                 if (isFloat) {
-                    llvm::Value *cmp = builder.CreateFCmpONE(left, right, "neqtmp");
-                    return builder.CreateZExt(cmp, llvm::Type::getInt32Ty(context), "booltmp");
+                    return builder.CreateFCmpONE(left, right, "neqtmp");
                 } else {
-                    llvm::Value *cmp = builder.CreateICmpNE(left, right, "neqtmp");
-                    return builder.CreateZExt(cmp, llvm::Type::getInt32Ty(context), "booltmp");
+                    return builder.CreateICmpNE(left, right, "neqtmp");
                 }
             case BinaryExpr::Op::AND:
-                return builder.CreateAnd(left, right, "andtmp");
             case BinaryExpr::Op::OR:
-                return builder.CreateOr(left, right, "ortmp");
+                break; // handled above
         }
     }
     else if (auto *unary = dynamic_cast<const UnaryExpr*>(expr)) {
@@ -248,7 +356,7 @@ llvm::Value* CodeGenerator::generate(const Expr *expr) {
         if (!alloca) return nullptr;
 
         llvm::Value *current = builder.CreateLoad(alloca->getAllocatedType(), alloca, "current_val");
-        llvm::Value *one = llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), 1);
+        llvm::Value *one = llvm::ConstantInt::get(current->getType(), 1);
         
         llvm::Value *newVal;
         if (unary->op == UnaryExpr::Op::PRE_INC) {
@@ -264,38 +372,17 @@ llvm::Value* CodeGenerator::generate(const Expr *expr) {
         if (array->elements.empty()) return nullptr;
 
         // Determine array type from first element
-        VarDeclStmt::Kind elemType = typeAnalyzer.inferType(array->elements[0].get());
-        llvm::Type *llvmElemType = getLLVMType(elemType);
-        
-        // Create array type
-        llvm::ArrayType *arrayType = llvm::ArrayType::get(llvmElemType, array->elements.size());
-        
-        // Allocate temporary array on stack
-        llvm::AllocaInst *arrayAlloca = createEntryBlockAlloca("array_tmp", arrayType);
-        
-        // Initialize elements
-        for (size_t i = 0; i < array->elements.size(); ++i) {
-            llvm::Value *elemVal = generate(array->elements[i].get());
-            if (!elemVal) continue;
-            
-            llvm::Value *elemPtr = builder.CreateInBoundsGEP(
-                arrayType, arrayAlloca, 
-                {llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), 0),
-                 llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), i)}, 
-                "elem_ptr");
-            builder.CreateStore(elemVal, elemPtr);
-        }
-        
-        // Return pointer to first element
-        llvm::Value *arrayPtr = builder.CreateInBoundsGEP(
-            arrayType, arrayAlloca,
-            {llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), 0),
-             llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), 0)}, 
-            "array_ptr");
-        
-        return arrayPtr;
+        return generateArrayLiteral(array, typeAnalyzer.inferType(array->elements[0].get()));
     }
     else if (auto *index = dynamic_cast<const IndexExpr*>(expr)) {
+        if (auto *mapVar = dynamic_cast<const VarExpr*>(index->array.get())) {
+            auto typeIt = variableTypes.find(mapVar->name);
+            if (typeIt != variableTypes.end() && TypeAnalyzer::isMapType(typeIt->second)) {
+                typeAnalyzer.mapKeyCheck(index->index.get(), index->line, index->column);
+                return generateMapGet(index, typeIt->second);
+            }
+        }
+
         llvm::Value *indexVal = generate(index->index.get());
         if (!indexVal) return nullptr;
 
@@ -303,6 +390,12 @@ llvm::Value* CodeGenerator::generate(const Expr *expr) {
         if (auto *varExpr = dynamic_cast<const VarExpr*>(index->array.get())) {
             std::string varName = varExpr->name;
             
+            // Loops may already have proven this access in range
+            bool proven = false;
+            if (auto *indexVar = dynamic_cast<const VarExpr*>(index->index.get())) {
+                proven = provenIndexes.count({varName, indexVar->name}) > 0;
+            }
+
             // Check if it's a string (character access)
             VarDeclStmt::Kind varType = variableTypes[varName];
             if (varType == VarDeclStmt::STRING) {
@@ -311,43 +404,38 @@ llvm::Value* CodeGenerator::generate(const Expr *expr) {
                 
                 llvm::Value *stringPtr = builder.CreateLoad(stringAlloca->getAllocatedType(), stringAlloca, "string_load");
                 
-                // Get string length for bounds checking
-                std::vector<llvm::Type*> strlenArgs({llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context))});
-                llvm::FunctionType *strlenType = llvm::FunctionType::get(llvm::Type::getInt64Ty(context), strlenArgs, false);
-                llvm::FunctionCallee strlenFunc = module->getOrInsertFunction("strlen", strlenType);
-                
-                llvm::Value *stringLen = builder.CreateCall(strlenFunc, {stringPtr}, "string_len");
-                llvm::Value *stringLenInt = builder.CreateTrunc(stringLen, llvm::Type::getInt32Ty(context), "string_len_i32");
-                
-                // Bounds check
-                createBoundsCheck(indexVal, stringLenInt, varName);
+                if (!proven) {
+                    // Get string length for bounds checking
+                    std::vector<llvm::Type*> strlenArgs({llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context))});
+                    llvm::FunctionType *strlenType = llvm::FunctionType::get(llvm::Type::getInt64Ty(context), strlenArgs, false);
+                    llvm::FunctionCallee strlenFunc = module->getOrInsertFunction("strlen", strlenType);
+                    
+                    llvm::Value *stringLen = builder.CreateCall(strlenFunc, {stringPtr}, "string_len");
+                    llvm::Value *stringLenInt = builder.CreateTrunc(stringLen, llvm::Type::getInt32Ty(context), "string_len_i32");
+                    
+                    // Bounds check
+                    createBoundsCheck(indexVal, stringLenInt, varName);
+                }
                 
                 // Get character
                 llvm::Value *charPtr = builder.CreateInBoundsGEP(llvm::Type::getInt8Ty(context), stringPtr, indexVal, "char_ptr");
                 return builder.CreateLoad(llvm::Type::getInt8Ty(context), charPtr, "char_val");
             }
             // Array access
-            else if (varType == VarDeclStmt::INT_ARRAY || varType == VarDeclStmt::FLOAT_ARRAY || varType == VarDeclStmt::STRING_ARRAY) {
+            else if (TypeAnalyzer::isArrayType(varType)) {
                 llvm::AllocaInst *arrayAlloca = findVariable(varName);
                 if (!arrayAlloca) return nullptr;
                 
                 llvm::Value *arrayPtr = builder.CreateLoad(arrayAlloca->getAllocatedType(), arrayAlloca, "array_load");
                 
-                // Get array size for bounds checking
-                auto sizeIt = arraySizes.find(varName);
-                if (sizeIt != arraySizes.end()) {
-                    llvm::Value *arraySize = llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), sizeIt->second);
-                    createBoundsCheck(indexVal, arraySize, varName);
+                // Get array size (static or the parameter's runtime length) for bounds checking
+                if (!proven) {
+                    if (llvm::Value *arraySize = getArrayLength(varName)) {
+                        createBoundsCheck(indexVal, arraySize, varName);
+                    }
                 }
                 
-                llvm::Type *elemType;
-                if (varType == VarDeclStmt::INT_ARRAY) {
-                    elemType = llvm::Type::getInt32Ty(context);
-                } else if (varType == VarDeclStmt::FLOAT_ARRAY) {
-                    elemType = llvm::Type::getFloatTy(context);
-                } else {
-                    elemType = llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context));
-                }
+                llvm::Type *elemType = getLLVMType(TypeAnalyzer::elementType(varType));
                 
                 llvm::Value *elemPtr = builder.CreateInBoundsGEP(elemType, arrayPtr, indexVal, "elem_ptr");
                 return builder.CreateLoad(elemType, elemPtr, "array_elem");
@@ -360,21 +448,67 @@ llvm::Value* CodeGenerator::generate(const Expr *expr) {
         
         return nullptr;
     }
+    else if (auto *slice = dynamic_cast<const SliceExpr*>(expr)) {
+        return generateSlice(slice);
+    }
+    else if (auto *chan = dynamic_cast<const ChanExpr*>(expr)) {
+        return generateChan(chan);
+    }
+    else if (auto *map = dynamic_cast<const MapExpr*>(expr)) {
+        return generateMap(map);
+    }
+    else if (auto *recv = dynamic_cast<const RecvExpr*>(expr)) {
+        return generateRecv(recv);
+    }
+    else if (auto *interp = dynamic_cast<const InterpExpr*>(expr)) {
+        return generateInterpolation(interp);
+    }
     else if (auto *call = dynamic_cast<const CallExpr*>(expr)) {
+        if (typeAnalyzer.isMapBuiltin(call)) {
+            return generateMapBuiltin(call);
+        }
+        if (typeAnalyzer.isFileBuiltin(call)) {
+            return generateFileBuiltin(call);
+        }
+        if (typeAnalyzer.isReadBuiltin(call)) {
+            return generateReadBuiltin(call);
+        }
+        if (typeAnalyzer.isBuilderBuiltin(call)) {
+            return generateBuilderBuiltin(call);
+        }
+        if (typeAnalyzer.isLenBuiltin(call)) {
+            if (TypeAnalyzer::isMapType(typeAnalyzer.inferType(call->args[0].get()))) {
+                return generateMapBuiltin(call);
+            }
+            // Slices and element-wise results only know their length once generated
+            const Expr *arg = call->args[0].get();
+            if (!dynamic_cast<const VarExpr*>(arg) && !generate(arg)) return nullptr;
+            llvm::Value *length = getArrayLength(arg);
+            if (!length) {
+                std::cerr << "Error (line " << call->line << ":" << call->column
+                          << "): no se puede determinar el tamaño del array pasado a len\n";
+                std::exit(1);
+            }
+            return length;
+        }
+
         // Look up the function
-        auto funcIt = functions.find(call->callee);
-        if (funcIt == functions.end()) {
+        auto declIt = functionDecls.find(call->callee);
+        if (declIt == functionDecls.end()) {
             std::cerr << "Error fatal: función no declarada '" << call->callee << "'\n";
             std::cerr << "Compilación terminada debido a errores.\n";
             std::exit(1);
         }
         
-        llvm::Function *func = funcIt->second;
+        // Pick (or generate) the specialization for these argument types
+        llvm::Function *func = getSpecialization(declIt->second, typeAnalyzer.analyzeCallExpr(call));
         
-        // Generate arguments
+        // Generate arguments (arrays travel as {ptr, len} views)
         std::vector<llvm::Value*> args;
+        auto paramIt = func->arg_begin();
         for (const auto &arg : call->args) {
-            llvm::Value *argVal = generate(arg.get());
+            bool isArrayParam = (paramIt++)->getType()->isStructTy();
+            llvm::Value *argVal = isArrayParam ? generateArrayView(arg.get()) : generate(arg.get());
             if (!argVal) return nullptr;
             args.push_back(argVal);
         }
@@ -390,59 +524,142 @@ llvm::Value* CodeGenerator::generate(const Expr *expr) {
     return nullptr;
 }
 
+// Generate an expression directly in the kind its context expects: numeric
+// literals become constants of that type (a float literal used as a double
+// keeps its double precision), array literals get that element type, and
+// anything else is generated normally and converted
+llvm::Value* CodeGenerator::generateTyped(const Expr *expr, VarDeclStmt::Kind kind) {
+    llvm::Type *targetType = getLLVMType(kind);
+    if (auto *lit = dynamic_cast<const LiteralExpr*>(expr)) {
+        if (targetType->isFloatingPointTy() || (targetType->isIntegerTy() && !targetType->isIntegerTy(1))) {
+            double value;
+            if (std::holds_alternative<int>(lit->value)) {
+                value = std::get<int>(lit->value);
+            } else if (std::holds_alternative<long long>(lit->value)) {
+                if (targetType->isIntegerTy()) {
+                    return llvm::ConstantInt::get(targetType, std::get<long long>(lit->value), true);
+                }
+                value = static_cast<double>(std::get<long long>(lit->value));
+            } else if (std::holds_alternative<double>(lit->value) && targetType->isFloatingPointTy()) {
+                value = std::get<double>(lit->value);
+            } else {
+                return generate(expr);
+            }
+            emitDebugLocation(expr->line, expr->column);
+            if (targetType->isFloatingPointTy()) {
+                return llvm::ConstantFP::get(targetType, value);
+            }
+            return llvm::ConstantInt::get(targetType, static_cast<long long>(value), true);
+        }
+    }
+    if (auto *array = dynamic_cast<const ArrayExpr*>(expr)) {
+        if (TypeAnalyzer::isArrayType(kind) && !array->elements.empty()) {
+            emitDebugLocation(expr->line, expr->column);
+            return generateArrayLiteral(array, TypeAnalyzer::elementType(kind));
+        }
+    }
+
+    llvm::Value *value = generate(expr);
+    if (!value) return nullptr;
+    llvm::Value *converted = convertValue(value, targetType);
+    return converted ? converted : value;
+}
+
+llvm::Value* CodeGenerator::generateArrayLiteral(const ArrayExpr *array, VarDeclStmt::Kind elemKind) {
+    llvm::Type *llvmElemType = getLLVMType(elemKind);
+    
+    // Create array type
+    llvm::ArrayType *arrayType = llvm::ArrayType::get(llvmElemType, array->elements.size());
+    
+    // Allocate temporary array on stack
+    llvm::AllocaInst *arrayAlloca = createEntryBlockAlloca("array_tmp", arrayType);
+    
+    // Initialize elements
+    for (size_t i = 0; i < array->elements.size(); ++i) {
+        llvm::Value *elemVal = generateTyped(array->elements[i].get(), elemKind);
+        if (!elemVal) continue;
+        
+        llvm::Value *elemPtr = builder.CreateInBoundsGEP(
+            arrayType, arrayAlloca, 
+            {llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), 0),
+             llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), i)}, 
+            "elem_ptr");
+        builder.CreateStore(elemVal, elemPtr);
+    }
+    
+    // Return pointer to first element
+    llvm::Value *arrayPtr = builder.CreateInBoundsGEP(
+        arrayType, arrayAlloca,
+        {llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), 0),
+         llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), 0)}, 
+        "array_ptr");
+    
+    return arrayPtr;
+}
+
 // Generate element-wise array operations (v + w, v * w)
 llvm::Value* CodeGenerator::generateArrayOperation(const Expr *left, const Expr *right, BinaryExpr::Op op) {
+    if (op != BinaryExpr::Op::ADD && op != BinaryExpr::Op::MUL) return nullptr;
+
     llvm::Value *leftArray = generate(left);
     llvm::Value *rightArray = generate(right);
     if (!leftArray || !rightArray) return nullptr;
     
-    // Get array sizes (assuming both arrays have same size for now)
-    std::string leftName, rightName;
-    if (auto *varExpr = dynamic_cast<const VarExpr*>(left)) {
-        leftName = varExpr->name;
-    }
-    if (auto *varExpr = dynamic_cast<const VarExpr*>(right)) {
-        rightName = varExpr->name;
+    // The result takes the left operand's length; the right one must cover it,
+    // which only needs a run-time check when a length is not a constant
+    llvm::Value *length = getArrayLength(left);
+    llvm::Value *rightLength = getArrayLength(right);
+    if (length && rightLength) {
+        auto *constLeft = llvm::dyn_cast<llvm::ConstantInt>(length);
+        auto *constRight = llvm::dyn_cast<llvm::ConstantInt>(rightLength);
+        if (!constLeft || !constRight) {
+            createBoundsCheck(length, builder.CreateAdd(rightLength, builder.getInt32(1), "op_cap"), "array_op");
+        }
     }
-    
     int arraySize = 3; // Default size for [1,2,3] style arrays
-    if (!leftName.empty() && arraySizes.find(leftName) != arraySizes.end()) {
-        arraySize = arraySizes[leftName];
+    if (auto *constLength = llvm::dyn_cast_or_null<llvm::ConstantInt>(length)) {
+        arraySize = constLength->getSExtValue();
     }
     
-    // Determine result type
-    VarDeclStmt::Kind leftType = typeAnalyzer.inferType(left);
-    VarDeclStmt::Kind rightType = typeAnalyzer.inferType(right);
-    bool isFloatResult = (leftType == VarDeclStmt::FLOAT_ARRAY || rightType == VarDeclStmt::FLOAT_ARRAY);
+    // Determine result type; each side is loaded with its own element type
+    VarDeclStmt::Kind leftElemKind = TypeAnalyzer::elementType(typeAnalyzer.inferType(left));
+    VarDeclStmt::Kind rightElemKind = TypeAnalyzer::elementType(typeAnalyzer.inferType(right));
+    llvm::Type *leftElemType = getLLVMType(leftElemKind);
+    llvm::Type *rightElemType = getLLVMType(rightElemKind);
+    llvm::Type *elementType = getLLVMType(TypeAnalyzer::promoteNumeric(leftElemKind, rightElemKind));
+    bool isFloatResult = elementType->isFloatingPointTy();
+    
+    // Element i of the result
+    auto combine = [&](llvm::Value *index) -> llvm::Value* {
+        llvm::Value *leftElemPtr = builder.CreateGEP(leftElemType, leftArray, index, "left_elem_ptr");
+        llvm::Value *leftElem = convertValue(builder.CreateLoad(leftElemType, leftElemPtr, "left_elem"), elementType);
+        llvm::Value *rightElemPtr = builder.CreateGEP(rightElemType, rightArray, index, "right_elem_ptr");
+        llvm::Value *rightElem = convertValue(builder.CreateLoad(rightElemType, rightElemPtr, "right_elem"), elementType);
+        if (op == BinaryExpr::Op::ADD) {
+            return isFloatResult ? builder.CreateFAdd(leftElem, rightElem, "add_result")
+                                 : builder.CreateAdd(leftElem, rightElem, "add_result");
+        }
+        return isFloatResult ? builder.CreateFMul(leftElem, rightElem, "mul_result")
+                             : builder.CreateMul(leftElem, rightElem, "mul_result");
+    };
+    
+    // Runtime length (array parameters): a single loop the vectorizer can widen
+    if (length && !llvm::isa<llvm::ConstantInt>(length)) {
+        llvm::Value *resultArray = createHeapArray(elementType, length, "array_result_tmp");
+        emitCountedLoop(length, "array_op", [&](llvm::Value *index) {
+            llvm::Value *resultElemPtr = builder.CreateGEP(elementType, resultArray, index, "result_elem_ptr");
+            builder.CreateStore(combine(index), resultElemPtr);
+        });
+        return resultArray;
+    }
     
     // Create result array
-    llvm::Type *elementType = isFloatResult ? llvm::Type::getFloatTy(context) : llvm::Type::getInt32Ty(context);
     llvm::ArrayType *arrayType = llvm::ArrayType::get(elementType, arraySize);
     llvm::AllocaInst *resultArray = createEntryBlockAlloca("array_result_tmp", arrayType);
     
     // Generate loop to perform element-wise operation
     for (int i = 0; i < arraySize; i++) {
-        // Get left element
-        llvm::Value *leftElemPtr = builder.CreateGEP(elementType, leftArray, 
-            builder.getInt32(i), "left_elem_ptr");
-        llvm::Value *leftElem = builder.CreateLoad(elementType, leftElemPtr, "left_elem");
-        
-        // Get right element
-        llvm::Value *rightElemPtr = builder.CreateGEP(elementType, rightArray, 
-            builder.getInt32(i), "right_elem_ptr");
-        llvm::Value *rightElem = builder.CreateLoad(elementType, rightElemPtr, "right_elem");
-        
-        // Perform operation
-        llvm::Value *result;
-        if (op == BinaryExpr::Op::ADD) {
-            result = isFloatResult ? builder.CreateFAdd(leftElem, rightElem, "add_result")
-                                   : builder.CreateAdd(leftElem, rightElem, "add_result");
-        } else if (op == BinaryExpr::Op::MUL) {
-            result = isFloatResult ? builder.CreateFMul(leftElem, rightElem, "mul_result")
-                                   : builder.CreateMul(leftElem, rightElem, "mul_result");
-        } else {
-            return nullptr;
-        }
+        llvm::Value *result = combine(builder.getInt32(i));
         
         // Store result
         llvm::Value *resultElemPtr = builder.CreateGEP(arrayType, resultArray, 
@@ -457,51 +674,52 @@ llvm::Value* CodeGenerator::generateArrayOperation(const Expr *left, const Expr
 
 // Generate array * scalar operations (v * n)
 llvm::Value* CodeGenerator::generateArrayScalarOperation(const Expr *array, const Expr *scalar, BinaryExpr::Op op) {
+    if (op != BinaryExpr::Op::MUL) return nullptr;
+
+    VarDeclStmt::Kind arrayElemKind = TypeAnalyzer::elementType(typeAnalyzer.inferType(array));
+    VarDeclStmt::Kind resultElemKind = TypeAnalyzer::promoteNumeric(arrayElemKind, typeAnalyzer.inferType(scalar));
+
     llvm::Value *arrayVal = generate(array);
-    llvm::Value *scalarVal = generate(scalar);
+    llvm::Value *scalarVal = generateTyped(scalar, resultElemKind);
     if (!arrayVal || !scalarVal) return nullptr;
     
     // Get array size
-    std::string arrayName;
-    if (auto *varExpr = dynamic_cast<const VarExpr*>(array)) {
-        arrayName = varExpr->name;
-    }
-    
+    llvm::Value *length = getArrayLength(array);
     int arraySize = 3; // Default size
-    if (!arrayName.empty() && arraySizes.find(arrayName) != arraySizes.end()) {
-        arraySize = arraySizes[arrayName];
+    if (auto *constLength = llvm::dyn_cast_or_null<llvm::ConstantInt>(length)) {
+        arraySize = constLength->getSExtValue();
     }
     
     // Determine types
-    VarDeclStmt::Kind arrayType = typeAnalyzer.inferType(array);
-    VarDeclStmt::Kind scalarType = typeAnalyzer.inferType(scalar);
-    bool isFloatResult = (arrayType == VarDeclStmt::FLOAT_ARRAY || scalarType == VarDeclStmt::FLOAT);
+    llvm::Type *arrayElemType = getLLVMType(arrayElemKind);
+    llvm::Type *elementType = getLLVMType(resultElemKind);
+    bool isFloatResult = elementType->isFloatingPointTy();
+    
+    // Element i of the result
+    auto scale = [&](llvm::Value *index) -> llvm::Value* {
+        llvm::Value *elemPtr = builder.CreateGEP(arrayElemType, arrayVal, index, "elem_ptr");
+        llvm::Value *elem = convertValue(builder.CreateLoad(arrayElemType, elemPtr, "elem"), elementType);
+        return isFloatResult ? builder.CreateFMul(elem, scalarVal, "scalar_mul_result")
+                             : builder.CreateMul(elem, scalarVal, "scalar_mul_result");
+    };
+    
+    // Runtime length (array parameters): a single loop the vectorizer can widen
+    if (length && !llvm::isa<llvm::ConstantInt>(length)) {
+        llvm::Value *resultArray = createHeapArray(elementType, length, "scalar_result_tmp");
+        emitCountedLoop(length, "scalar_op", [&](llvm::Value *index) {
+            llvm::Value *resultElemPtr = builder.CreateGEP(elementType, resultArray, index, "result_elem_ptr");
+            builder.CreateStore(scale(index), resultElemPtr);
+        });
+        return resultArray;
+    }
     
     // Create result array
-    llvm::Type *elementType = isFloatResult ? llvm::Type::getFloatTy(context) : llvm::Type::getInt32Ty(context);
     llvm::ArrayType *resultArrayType = llvm::ArrayType::get(elementType, arraySize);
     llvm::AllocaInst *resultArray = createEntryBlockAlloca("scalar_result_tmp", resultArrayType);
     
-    // Convert scalar if needed
-    if (isFloatResult && scalarVal->getType()->isIntegerTy()) {
-        scalarVal = builder.CreateSIToFP(scalarVal, llvm::Type::getFloatTy(context), "scalar_to_float");
-    }
-    
     // Generate loop to multiply each element by scalar
     for (int i = 0; i < arraySize; i++) {
-        // Get array element
-        llvm::Value *elemPtr = builder.CreateGEP(elementType, arrayVal, 
-            builder.getInt32(i), "elem_ptr");
-        llvm::Value *elem = builder.CreateLoad(elementType, elemPtr, "elem");
-        
-        // Multiply by scalar
-        llvm::Value *result;
-        if (op == BinaryExpr::Op::MUL) {
-            result = isFloatResult ? builder.CreateFMul(elem, scalarVal, "scalar_mul_result")
-                                   : builder.CreateMul(elem, scalarVal, "scalar_mul_result");
-        } else {
-            return nullptr;
-        }
+        llvm::Value *result = scale(builder.getInt32(i));
         
         // Store result
         llvm::Value *resultElemPtr = builder.CreateGEP(resultArrayType, resultArray, 
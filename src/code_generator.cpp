@@ -4,12 +4,21 @@
 #include <llvm/Support/TargetSelect.h>
 #include <llvm/Support/Casting.h>
 #include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Process.h>
 #include <llvm/TargetParser/Host.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/MC/TargetRegistry.h>
 #include <llvm/Target/TargetMachine.h>
 #include <llvm/Target/TargetOptions.h>
 #include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/Intrinsics.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/PGOOptions.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <optional>
 #include <iostream>
 #include <variant>
 #include <cstdlib>
@@ -30,6 +39,19 @@ builder(context), typeAnalyzer(ta), currentFunction(nullptr) {
     pushScope();
 }
 
+void CodeGenerator::setOptimizationLevel(int level) {
+    optLevel = level;
+}
+
+void CodeGenerator::setProfileGenerate(const std::string &dir) {
+    profileGenerate = true;
+    profileGenerateDir = dir;
+}
+
+void CodeGenerator::setProfileUse(const std::string &profdataFile) {
+    profileUseFile = profdataFile;
+}
+
 void CodeGenerator::pushScope() {
     namedValuesStack.emplace_back();
 }
@@ -50,60 +72,91 @@ llvm::AllocaInst* CodeGenerator::findVariable(const std::string &name) {
     return nullptr;
 }
 
+void CodeGenerator::setBoundsMode(BoundsMode mode) {
+    boundsMode = mode;
+}
+
+llvm::Function* CodeGenerator::getBoundsFailHandler() {
+    if (boundsFailHandler) return boundsFailHandler;
+
+    // One cold, out-of-line reporter for the whole module keeps the printf
+    // and exit calls out of hot functions
+    llvm::Type *charPtrType = llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context));
+    llvm::FunctionType *handlerType = llvm::FunctionType::get(llvm::Type::getVoidTy(context), {charPtrType}, false);
+    boundsFailHandler = llvm::Function::Create(handlerType, llvm::Function::InternalLinkage,
+                                               "__gozero_bounds_fail", module.get());
+    boundsFailHandler->addFnAttr(llvm::Attribute::Cold);
+    boundsFailHandler->addFnAttr(llvm::Attribute::NoInline);
+    boundsFailHandler->addFnAttr(llvm::Attribute::NoReturn);
+    boundsFailHandler->getArg(0)->setName("var_name");
+
+    llvm::IRBuilder<> handlerBuilder(llvm::BasicBlock::Create(context, "entry", boundsFailHandler));
+    llvm::FunctionCallee printfFunc = module->getOrInsertFunction("printf",
+        llvm::FunctionType::get(llvm::Type::getInt32Ty(context), {charPtrType}, true));
+    llvm::FunctionCallee exitFunc = module->getOrInsertFunction("exit",
+        llvm::FunctionType::get(llvm::Type::getVoidTy(context), {llvm::Type::getInt32Ty(context)}, false));
+
+    llvm::Value *errorFmt = handlerBuilder.CreateGlobalString(
+        "Runtime Error: Index out of bounds for variable '%s'\n", "error_msg");
+    handlerBuilder.CreateCall(printfFunc, {errorFmt, boundsFailHandler->getArg(0)});
+    handlerBuilder.CreateCall(exitFunc, {handlerBuilder.getInt32(1)});
+    handlerBuilder.CreateUnreachable();
+    return boundsFailHandler;
+}
+
+std::pair<llvm::BasicBlock*, llvm::PHINode*> CodeGenerator::getBoundsFailBlock(llvm::Function *function) {
+    auto it = boundsFailBlocks.find(function);
+    if (it != boundsFailBlocks.end()) return it->second;
+
+    llvm::BasicBlock *failBB = llvm::BasicBlock::Create(context, "bounds_fail", function);
+    llvm::IRBuilder<> failBuilder(failBB);
+    llvm::PHINode *varName = nullptr;
+    if (boundsMode == BoundsMode::TRAP) {
+        llvm::Function *trap = llvm::Intrinsic::getDeclaration(module.get(), llvm::Intrinsic::trap);
+        failBuilder.CreateCall(trap, {});
+    } else {
+        // Every check in the function jumps here with its variable name
+        varName = failBuilder.CreatePHI(llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context)), 4, "bounds_var");
+        failBuilder.CreateCall(getBoundsFailHandler(), {varName});
+    }
+    failBuilder.CreateUnreachable();
+
+    boundsFailBlocks[function] = {failBB, varName};
+    return boundsFailBlocks[function];
+}
+
 void CodeGenerator::createBoundsCheck(llvm::Value *index, llvm::Value *size, const std::string &varName) {
-    // Convert index to i32 if needed
+    if (boundsMode == BoundsMode::OFF) return;
+
+    // Compare at the wider of the two widths so an int64 index is never truncated
     llvm::Value *indexInt = index;
-    if (index->getType() != llvm::Type::getInt32Ty(context)) {
-        indexInt = builder.CreateSExtOrTrunc(index, llvm::Type::getInt32Ty(context), "index_i32");
+    unsigned indexBits = index->getType()->getIntegerBitWidth();
+    unsigned sizeBits = size->getType()->getIntegerBitWidth();
+    if (indexBits < sizeBits) {
+        indexInt = builder.CreateSExt(index, size->getType(), "index_wide");
+    } else if (sizeBits < indexBits) {
+        size = builder.CreateZExt(size, index->getType(), "size_wide");
     }
     
-    // Create bounds check: index >= 0 && index < size
-    llvm::Value *negativeCheck = builder.CreateICmpSGE(indexInt, 
-        llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), 0), "negative_check");
+    // index >= 0 && index < size folds into one unsigned compare, since a
+    // negative index wraps around to a huge unsigned value
+    llvm::Value *boundsOk = builder.CreateICmpULT(indexInt, size, "bounds_ok");
+    llvm::Function *expect = llvm::Intrinsic::getDeclaration(module.get(), llvm::Intrinsic::expect,
+                                                            {builder.getInt1Ty()});
+    llvm::Value *likelyOk = builder.CreateCall(expect, {boundsOk, builder.getTrue()}, "bounds_expect");
     
-    llvm::Value *upperBoundCheck = builder.CreateICmpSLT(indexInt, size, "upper_bound_check");
-    llvm::Value *boundsOk = builder.CreateAnd(negativeCheck, upperBoundCheck, "bounds_ok");
-    
-    // Create basic blocks
     llvm::Function *func = currentFunction ? currentFunction : mainFunction;
     llvm::BasicBlock *boundsOkBB = llvm::BasicBlock::Create(context, "bounds_ok", func);
-    llvm::BasicBlock *boundsFailBB = llvm::BasicBlock::Create(context, "bounds_fail", func);
-    
-    // Branch based on bounds check
-    builder.CreateCondBr(boundsOk, boundsOkBB, boundsFailBB);
-    
-    // Bounds fail block - print error and exit
-    builder.SetInsertPoint(boundsFailBB);
-    
-    // Create error message
-    std::string errorMsg = "Runtime Error: Index out of bounds for variable '" + varName + "'\n";
-    llvm::Value *errorStr = builder.CreateGlobalString(errorMsg, "error_msg");
+    auto [boundsFailBB, failVarName] = getBoundsFailBlock(func);
     
-    // Call printf to print error
-    llvm::Function *printfFunc = module->getFunction("printf");
-    if (!printfFunc) {
-        std::vector<llvm::Type*> printfArgs;
-        printfArgs.push_back(llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context)));
-        llvm::FunctionType *printfType = llvm::FunctionType::get(
-            llvm::Type::getInt32Ty(context), printfArgs, true);
-        printfFunc = llvm::Function::Create(printfType, llvm::Function::ExternalLinkage, 
-            "printf", module.get());
-    }
-    
-    builder.CreateCall(printfFunc, {errorStr});
-    
-    // Exit with error code
-    llvm::Function *exitFunc = module->getFunction("exit");
-    if (!exitFunc) {
-        llvm::FunctionType *exitType = llvm::FunctionType::get(
-            llvm::Type::getVoidTy(context), 
-            {llvm::Type::getInt32Ty(context)}, false);
-        exitFunc = llvm::Function::Create(exitType, llvm::Function::ExternalLinkage, 
-            "exit", module.get());
+    if (failVarName) {
+        auto nameIt = boundsVarNames.find(varName);
+        if (nameIt == boundsVarNames.end()) {
+            nameIt = boundsVarNames.emplace(varName, builder.CreateGlobalString(varName, "bounds_var_name")).first;
+        }
+        failVarName->addIncoming(nameIt->second, builder.GetInsertBlock());
     }
-    
-    builder.CreateCall(exitFunc, {llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), 1)});
-    builder.CreateUnreachable();
+    builder.CreateCondBr(likelyOk, boundsOkBB, boundsFailBB);
     
     // Continue with bounds ok block
     builder.SetInsertPoint(boundsOkBB);
@@ -121,6 +174,21 @@ llvm::AllocaInst* CodeGenerator::createEntryBlockAlloca(const std::string &varNa
     return tmpBuilder.CreateAlloca(type, nullptr, varName);
 }
 
+// Storage for an array whose length is only known at run time. It cannot be
+// a dynamic alloca: inside a loop that grows the stack on every iteration,
+// and the array may outlive the statement through a variable. Like string
+// results it is never freed
+llvm::Value* CodeGenerator::createHeapArray(llvm::Type *elementType, llvm::Value *length, const std::string &name) {
+    llvm::Type *i64 = llvm::Type::getInt64Ty(context);
+    llvm::Type *i8Ptr = llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context));
+    llvm::FunctionCallee mallocFunc = module->getOrInsertFunction(
+        "malloc", llvm::FunctionType::get(i8Ptr, {i64}, false));
+    llvm::Value *count = builder.CreateIntCast(length, i64, false, name + "_count");
+    llvm::Value *size = builder.CreateMul(count, llvm::ConstantExpr::getSizeOf(elementType), name + "_size");
+    llvm::Value *storage = builder.CreateCall(mallocFunc, {size}, name);
+    return builder.CreatePointerCast(storage, llvm::PointerType::getUnqual(elementType), name + "_ptr");
+}
+
 llvm::Type* CodeGenerator::getLLVMType(VarDeclStmt::Kind kind) {
     switch (kind) {
         case VarDeclStmt::INT: return llvm::Type::getInt32Ty(context);
@@ -129,76 +197,387 @@ llvm::Type* CodeGenerator::getLLVMType(VarDeclStmt::Kind kind) {
         case VarDeclStmt::INT_ARRAY: return llvm::PointerType::getUnqual(llvm::Type::getInt32Ty(context));
         case VarDeclStmt::FLOAT_ARRAY: return llvm::PointerType::getUnqual(llvm::Type::getFloatTy(context));
         case VarDeclStmt::STRING_ARRAY: return llvm::PointerType::getUnqual(llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context)));
+        case VarDeclStmt::BOOL: return llvm::Type::getInt1Ty(context);
+        case VarDeclStmt::INT64: return llvm::Type::getInt64Ty(context);
+        case VarDeclStmt::DOUBLE: return llvm::Type::getDoubleTy(context);
+        case VarDeclStmt::INT64_ARRAY: return llvm::PointerType::getUnqual(llvm::Type::getInt64Ty(context));
+        case VarDeclStmt::DOUBLE_ARRAY: return llvm::PointerType::getUnqual(llvm::Type::getDoubleTy(context));
+        case VarDeclStmt::CHAN_INT:
+        case VarDeclStmt::CHAN_FLOAT:
+        case VarDeclStmt::CHAN_STRING: return llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context)); // gz_chan*
+        case VarDeclStmt::MAP_INT:
+        case VarDeclStmt::MAP_FLOAT:
+        case VarDeclStmt::MAP_STRING: return llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context)); // gz_map*
+        case VarDeclStmt::BUILDER: return llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context)); // gz_sb*
         case VarDeclStmt::VOID: return llvm::Type::getVoidTy(context);
     }
     return llvm::Type::getInt32Ty(context);
 }
 
+llvm::Value* CodeGenerator::createTruthTest(llvm::Value *value) {
+    // Conditions are i1; other values are true when non-zero / non-null
+    llvm::Type *type = value->getType();
+    if (type->isIntegerTy(1)) {
+        return value;
+    }
+    if (type->isFloatingPointTy()) {
+        return builder.CreateFCmpUNE(value, llvm::ConstantFP::get(type, 0.0), "tobool");
+    }
+    if (type->isPointerTy()) {
+        return builder.CreateIsNotNull(value, "tobool");
+    }
+    return builder.CreateICmpNE(value, llvm::ConstantInt::get(type, 0), "tobool");
+}
+
+llvm::Value* CodeGenerator::generateCondition(const Expr *expr) {
+    llvm::Value *value = generate(expr);
+    if (!value) return nullptr;
+    return createTruthTest(value);
+}
+
+llvm::Value* CodeGenerator::convertValue(llvm::Value *value, llvm::Type *targetType) {
+    llvm::Type *sourceType = value->getType();
+    if (sourceType == targetType) {
+        return value;
+    }
+    if (targetType->isIntegerTy(1)) {
+        return createTruthTest(value);
+    }
+    if (sourceType->isIntegerTy(1)) {
+        if (targetType->isIntegerTy()) return builder.CreateZExt(value, targetType, "bool_to_int");
+        if (targetType->isFloatingPointTy()) return builder.CreateUIToFP(value, targetType, "bool_to_float");
+    }
+    if (sourceType->isIntegerTy() && targetType->isFloatingPointTy()) {
+        return builder.CreateSIToFP(value, targetType, "int_to_float");
+    }
+    if (sourceType->isFloatingPointTy() && targetType->isIntegerTy()) {
+        return builder.CreateFPToSI(value, targetType, "float_to_int");
+    }
+    if (sourceType->isIntegerTy() && targetType->isIntegerTy()) {
+        return builder.CreateSExtOrTrunc(value, targetType, "int_resize");
+    }
+    if (sourceType->isFloatingPointTy() && targetType->isFloatingPointTy()) {
+        return builder.CreateFPCast(value, targetType, "float_resize");
+    }
+    return nullptr; // no implicit conversion
+}
+
+// Channel elements and map values travel through the runtime as 64-bit
+// slots: ints are sign-extended, floats keep their bit pattern and strings
+// are the pointer itself. A zero slot decodes as the zero value of the kind
+llvm::Value* CodeGenerator::toSlot(llvm::Value *value, VarDeclStmt::Kind kind) {
+    llvm::Type *i64 = builder.getInt64Ty();
+    switch (kind) {
+        case VarDeclStmt::FLOAT:
+            return builder.CreateZExt(builder.CreateBitCast(value, builder.getInt32Ty()), i64, "slot");
+        case VarDeclStmt::STRING:
+            return builder.CreatePtrToInt(value, i64, "slot");
+        default:
+            return builder.CreateSExt(value, i64, "slot");
+    }
+}
+
+llvm::Value* CodeGenerator::fromSlot(llvm::Value *slot, VarDeclStmt::Kind kind) {
+    llvm::Type *type = getLLVMType(kind);
+    switch (kind) {
+        case VarDeclStmt::FLOAT:
+            return builder.CreateBitCast(builder.CreateTrunc(slot, builder.getInt32Ty()), type, "slot_float");
+        case VarDeclStmt::STRING:
+            // The zero value of a string is "", not a null pointer
+            return builder.CreateSelect(builder.CreateICmpEQ(slot, builder.getInt64(0)), createStringConstant(""),
+                                        builder.CreateIntToPtr(slot, type), "slot_str");
+        default:
+            return builder.CreateTrunc(slot, type, "slot_int");
+    }
+}
+
+llvm::StructType* CodeGenerator::getArrayViewType(VarDeclStmt::Kind kind) {
+    // Arrays cross function boundaries as {element pointer, i64 length}
+    return llvm::StructType::get(context, {getLLVMType(kind), llvm::Type::getInt64Ty(context)});
+}
+
+llvm::Value* CodeGenerator::getArrayLength(const std::string &name) {
+    // Compile-time size when known, otherwise the runtime length of a parameter
+    auto sizeIt = arraySizes.find(name);
+    if (sizeIt != arraySizes.end()) {
+        return builder.getInt32(sizeIt->second);
+    }
+    auto lenIt = arrayLengths.find(name);
+    if (lenIt != arrayLengths.end()) {
+        llvm::Value *length = builder.CreateLoad(lenIt->second->getAllocatedType(), lenIt->second, name + "_len");
+        return builder.CreateTrunc(length, llvm::Type::getInt32Ty(context), name + "_len_i32");
+    }
+    return nullptr;
+}
+
+llvm::Value* CodeGenerator::getArrayLength(const Expr *arrayExpr) {
+    if (auto *var = dynamic_cast<const VarExpr*>(arrayExpr)) {
+        return getArrayLength(var->name);
+    }
+    if (auto *array = dynamic_cast<const ArrayExpr*>(arrayExpr)) {
+        return builder.getInt32(array->elements.size());
+    }
+    if (dynamic_cast<const SliceExpr*>(arrayExpr) || dynamic_cast<const CallExpr*>(arrayExpr)) {
+        // Slices and mapped files: computed when generated, which callers do first
+        auto lenIt = viewLengths.find(arrayExpr);
+        return lenIt != viewLengths.end() ? lenIt->second : nullptr;
+    }
+    if (auto *bin = dynamic_cast<const BinaryExpr*>(arrayExpr)) {
+        // Element-wise results take the length of their (left) array operand
+        VarDeclStmt::Kind leftType = typeAnalyzer.inferType(bin->left.get());
+        if (TypeAnalyzer::isArrayType(leftType)) {
+            return getArrayLength(bin->left.get());
+        }
+        return getArrayLength(bin->right.get());
+    }
+    return nullptr;
+}
+
+llvm::Value* CodeGenerator::generateArrayView(const Expr *arrayExpr) {
+    VarDeclStmt::Kind kind = typeAnalyzer.inferType(arrayExpr);
+    llvm::Value *arrayPtr = generate(arrayExpr);
+    llvm::Value *length = getArrayLength(arrayExpr);
+    if (!arrayPtr) return nullptr;
+    if (!length) {
+        std::cerr << "Error (line " << arrayExpr->line << ":" << arrayExpr->column
+                  << "): no se puede determinar el tamaño del array pasado como argumento\n";
+        std::exit(1);
+    }
+
+    llvm::Value *view = llvm::UndefValue::get(getArrayViewType(kind));
+    view = builder.CreateInsertValue(view, arrayPtr, 0, "view_ptr");
+    return builder.CreateInsertValue(view, builder.CreateSExt(length, llvm::Type::getInt64Ty(context)), 1, "view");
+}
+
+// a[lo:hi] points into a's storage, so writes through the slice are seen by
+// a. Both bounds are checked once here (0 <= lo <= hi <= len(a)); indexing
+// the slice afterwards is checked against its own length hi - lo
+llvm::Value* CodeGenerator::generateSlice(const SliceExpr *slice) {
+    VarDeclStmt::Kind kind = typeAnalyzer.inferType(slice);
+    llvm::Value *arrayPtr = generate(slice->array.get());
+    llvm::Value *length = getArrayLength(slice->array.get());
+    if (!arrayPtr) return nullptr;
+    if (!length) {
+        std::cerr << "Error (line " << slice->line << ":" << slice->column
+                  << "): no se puede determinar el tamaño del array del slice\n";
+        std::exit(1);
+    }
+
+    llvm::Value *lo = slice->lo ? generateTyped(slice->lo.get(), VarDeclStmt::INT) : builder.getInt32(0);
+    llvm::Value *hi = slice->hi ? generateTyped(slice->hi.get(), VarDeclStmt::INT) : length;
+    if (!lo || !hi) return nullptr;
+
+    std::string arrayName = "slice";
+    if (auto *var = dynamic_cast<const VarExpr*>(slice->array.get())) {
+        arrayName = var->name;
+    }
+    emitDebugLocation(slice->line, slice->column);
+    createBoundsCheck(hi, builder.CreateAdd(length, builder.getInt32(1), "slice_cap"), arrayName);
+    if (slice->lo) {
+        createBoundsCheck(lo, builder.CreateAdd(hi, builder.getInt32(1), "slice_hi_cap"), arrayName);
+    }
+
+    viewLengths[slice] = builder.CreateSub(hi, lo, "slice_len");
+    llvm::Type *elemType = getLLVMType(TypeAnalyzer::elementType(kind));
+    return builder.CreateInBoundsGEP(elemType, arrayPtr, lo, "slice_ptr");
+}
+
+// Copies of arrays, operations on arrays and slices inherit their length,
+// which is only known at run time when it comes from an array parameter or
+// a slice. Slices always keep a runtime length so they can be re-sliced
+void CodeGenerator::recordArrayLength(const std::string &name, const Expr *init) {
+    arraySizes.erase(name);
+    arrayLengths.erase(name);
+
+    llvm::Value *length = getArrayLength(init);
+    auto *constLength = llvm::dyn_cast_or_null<llvm::ConstantInt>(length);
+    if (constLength && !dynamic_cast<const SliceExpr*>(init)) {
+        arraySizes[name] = constLength->getSExtValue();
+    } else if (length) {
+        llvm::Type *i64 = llvm::Type::getInt64Ty(context);
+        llvm::AllocaInst *lenAlloca = createEntryBlockAlloca(name + ".len", i64);
+        builder.CreateStore(builder.CreateSExt(length, i64), lenAlloca);
+        arrayLengths[name] = lenAlloca;
+    }
+}
+
+void CodeGenerator::emitCountedLoop(llvm::Value *length, const std::string &name,
+                                    const std::function<void(llvm::Value *index)> &body) {
+    // for (i = 0; i < length; ++i) body(i), as a rotated loop with a PHI index
+    llvm::Function *func = currentFunction ? currentFunction : mainFunction;
+    llvm::BasicBlock *preheaderBB = builder.GetInsertBlock();
+    llvm::BasicBlock *loopBB = llvm::BasicBlock::Create(context, name + "_loop", func);
+    llvm::BasicBlock *doneBB = llvm::BasicBlock::Create(context, name + "_done", func);
+    builder.CreateCondBr(builder.CreateICmpSGT(length, builder.getInt32(0), name + "_any"), loopBB, doneBB);
+
+    builder.SetInsertPoint(loopBB);
+    llvm::PHINode *index = builder.CreatePHI(llvm::Type::getInt32Ty(context), 2, name + "_i");
+    index->addIncoming(builder.getInt32(0), preheaderBB);
+    body(index);
+    llvm::Value *next = builder.CreateNSWAdd(index, builder.getInt32(1), name + "_next");
+    index->addIncoming(next, builder.GetInsertBlock());
+    builder.CreateCondBr(builder.CreateICmpSLT(next, length, name + "_more"), loopBB, doneBB);
+
+    builder.SetInsertPoint(doneBB);
+}
+
 llvm::Value* CodeGenerator::createStringConstant(const std::string &str) {
-    llvm::Constant *strConst = llvm::ConstantDataArray::getString(context, str);
-    llvm::GlobalVariable *strVar = new llvm::GlobalVariable(
-        *module, strConst->getType(), true, llvm::GlobalValue::PrivateLinkage, strConst, ".str");
+    llvm::GlobalVariable *&strVar = stringConstants[str];
+    if (!strVar) {
+        llvm::Constant *strConst = llvm::ConstantDataArray::getString(context, str);
+        strVar = new llvm::GlobalVariable(
+            *module, strConst->getType(), true, llvm::GlobalValue::PrivateLinkage, strConst, ".str");
+    }
 
     llvm::Value *zero = llvm::Constant::getNullValue(llvm::Type::getInt32Ty(context));
     std::vector<llvm::Value*> indices({zero, zero});
     return builder.CreateInBoundsGEP(strVar->getValueType(), strVar, indices, "string_ptr");
 }
 
+// Strings stay plain NUL-terminated i8* (printf, maps and channel slots all
+// rely on that); gz_str_concat in the runtime builds the result with one
+// copy per side, and results short enough come from a per-thread bump arena
+// instead of malloc
 llvm::Value* CodeGenerator::generateStringConcat(const Expr *left, const Expr *right) {
-    // Get string values
-    llvm::Value *leftStr = generate(left);
-    llvm::Value *rightStr = generate(right);
+    // Two literals: joined here
+    auto *leftLit = dynamic_cast<const LiteralExpr*>(left);
+    auto *rightLit = dynamic_cast<const LiteralExpr*>(right);
+    if (leftLit && rightLit && std::holds_alternative<std::string>(leftLit->value) &&
+        std::holds_alternative<std::string>(rightLit->value)) {
+        return createStringConstant(std::get<std::string>(leftLit->value) + std::get<std::string>(rightLit->value));
+    }
+
+    // Get string values (numbers are formatted first)
+    llvm::Value *leftStr = generateAsString(left);
+    llvm::Value *rightStr = generateAsString(right);
 
     if (!leftStr || !rightStr) return nullptr;
 
-    // Declare strcat function
     llvm::Type *charPtrType = llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context));
-    std::vector<llvm::Type*> strcatArgs({charPtrType, charPtrType});
-    llvm::FunctionType *strcatType = llvm::FunctionType::get(charPtrType, strcatArgs, false);
-    llvm::FunctionCallee strcatFunc = module->getOrInsertFunction("strcat", strcatType);
+    llvm::FunctionCallee concatFunc = module->getOrInsertFunction(
+        "gz_str_concat", llvm::FunctionType::get(charPtrType, {charPtrType, charPtrType}, false));
+    usesRuntime = true;
+    return builder.CreateCall(concatFunc, {leftStr, rightStr}, "result_str");
+}
 
-    // Declare strlen function
-    std::vector<llvm::Type*> strlenArgs({charPtrType});
-    llvm::FunctionType *strlenType = llvm::FunctionType::get(llvm::Type::getInt64Ty(context), strlenArgs, false);
-    llvm::FunctionCallee strlenFunc = module->getOrInsertFunction("strlen", strlenType);
+// ==, !=, <, <=, > and >= on strings compare contents (bytewise, like
+// strcmp) through gz_str_eq / gz_str_cmp in the runtime
+llvm::Value* CodeGenerator::generateStringCompare(const BinaryExpr *bin) {
+    if (typeAnalyzer.inferType(bin->left.get()) != VarDeclStmt::STRING ||
+        typeAnalyzer.inferType(bin->right.get()) != VarDeclStmt::STRING) {
+        std::cerr << "Error (line " << bin->line << ":" << bin->column
+                  << "): no se puede comparar un string con un valor de otro tipo\n";
+        std::exit(1);
+    }
+    bool equality = bin->op == BinaryExpr::Op::EQ || bin->op == BinaryExpr::Op::NEQ;
+
+    // Two literals: decided here
+    auto *leftLit = dynamic_cast<const LiteralExpr*>(bin->left.get());
+    auto *rightLit = dynamic_cast<const LiteralExpr*>(bin->right.get());
+    if (leftLit && rightLit) {
+        int order = std::get<std::string>(leftLit->value).compare(std::get<std::string>(rightLit->value));
+        switch (bin->op) {
+            case BinaryExpr::Op::EQ: return builder.getInt1(order == 0);
+            case BinaryExpr::Op::NEQ: return builder.getInt1(order != 0);
+            case BinaryExpr::Op::LT: return builder.getInt1(order < 0);
+            case BinaryExpr::Op::LE: return builder.getInt1(order <= 0);
+            case BinaryExpr::Op::GT: return builder.getInt1(order > 0);
+            default: return builder.getInt1(order >= 0);
+        }
+    }
 
-    // Declare malloc function
-    std::vector<llvm::Type*> mallocArgs({llvm::Type::getInt64Ty(context)});
-    llvm::FunctionType *mallocType = llvm::FunctionType::get(charPtrType, mallocArgs, false);
-    llvm::FunctionCallee mallocFunc = module->getOrInsertFunction("malloc", mallocType);
+    llvm::Value *left = generate(bin->left.get());
+    llvm::Value *right = generate(bin->right.get());
+    if (!left || !right) return nullptr;
+    emitDebugLocation(bin->line, bin->column);
+
+    // Both only read their arguments, so calls on unchanged strings can be
+    // hoisted out of loops or merged
+    llvm::FunctionCallee compareFunc = module->getOrInsertFunction(
+        equality ? "gz_str_eq" : "gz_str_cmp",
+        llvm::FunctionType::get(llvm::Type::getInt32Ty(context), {left->getType(), right->getType()}, false));
+    if (auto *function = llvm::dyn_cast<llvm::Function>(compareFunc.getCallee())) {
+        function->setOnlyReadsMemory();
+        function->setOnlyAccessesArgMemory();
+        function->setDoesNotThrow();
+    }
+    usesRuntime = true;
+    llvm::Value *result = builder.CreateCall(compareFunc, {left, right}, equality ? "str_eq" : "str_cmp");
+    llvm::Value *zero = builder.getInt32(0);
+    switch (bin->op) {
+        case BinaryExpr::Op::EQ: return builder.CreateICmpNE(result, zero, "str_eqtmp");
+        case BinaryExpr::Op::NEQ: return builder.CreateICmpEQ(result, zero, "str_neqtmp");
+        case BinaryExpr::Op::LT: return builder.CreateICmpSLT(result, zero, "str_lttmp");
+        case BinaryExpr::Op::LE: return builder.CreateICmpSLE(result, zero, "str_letmp");
+        case BinaryExpr::Op::GT: return builder.CreateICmpSGT(result, zero, "str_gttmp");
+        default: return builder.CreateICmpSGE(result, zero, "str_getmp");
+    }
+}
 
-    // Declare strcpy function
-    std::vector<llvm::Type*> strcpyArgs({charPtrType, charPtrType});
-    llvm::FunctionType *strcpyType = llvm::FunctionType::get(charPtrType, strcpyArgs, false);
-    llvm::FunctionCallee strcpyFunc = module->getOrInsertFunction("strcpy", strcpyType);
+void CodeGenerator::finalize() {
+    if (usesTasks) {
+        // Tasks may still be running: main waits for all of them
+        builder.CreateCall(module->getOrInsertFunction(
+            "gz_join_all", llvm::FunctionType::get(llvm::Type::getVoidTy(context), false)));
+    }
+    emitProfileExit();
+    builder.CreateRetVoid();
+    emitProfileReport();
+    if (diBuilder) {
+        diBuilder->finalize();
+    }
+}
 
-    // Get lengths of both strings
-    llvm::Value *leftLen = builder.CreateCall(strlenFunc, {leftStr}, "left_len");
-    llvm::Value *rightLen = builder.CreateCall(strlenFunc, {rightStr}, "right_len");
+void CodeGenerator::printIR() {
+    module->print(llvm::outs(), nullptr);
+}
 
-    // Calculate total length + 1 for null terminator
-    llvm::Value *totalLen = builder.CreateAdd(leftLen, rightLen, "total_len");
-    llvm::Value *mallocSize = builder.CreateAdd(totalLen,
-                                                llvm::ConstantInt::get(llvm::Type::getInt64Ty(context), 1), "malloc_size");
+void CodeGenerator::optimizeModule(llvm::TargetMachine *targetMachine) {
+    // PGO only makes sense together with the optimizer, so it implies -O2
+    int level = optLevel;
+    if ((profileGenerate || !profileUseFile.empty()) && level == 0) {
+        level = 2;
+    }
+    if (level == 0) return;
 
-    // Allocate memory for result
-    llvm::Value *result = builder.CreateCall(mallocFunc, {mallocSize}, "result_str");
+    if (llvm::verifyModule(*module, &llvm::errs())) {
+        std::cerr << "Error: el modulo LLVM generado no es valido\n";
+        std::exit(1);
+    }
 
-    // Copy left string to result
-    builder.CreateCall(strcpyFunc, {result, leftStr});
+    // Profile-guided optimization: instrument on --profile-generate, consume
+    // the merged .profdata on --profile-use
+    std::optional<llvm::PGOOptions> pgo;
+    if (profileGenerate) {
+        std::string rawFile = "default_%m.profraw";
+        if (!profileGenerateDir.empty()) {
+            rawFile = profileGenerateDir + "/" + rawFile;
+        }
+        pgo = llvm::PGOOptions(rawFile, "", "", "", llvm::vfs::getRealFileSystem(),
+                               llvm::PGOOptions::IRInstr);
+    } else if (!profileUseFile.empty()) {
+        pgo = llvm::PGOOptions(profileUseFile, "", "", "", llvm::vfs::getRealFileSystem(),
+                               llvm::PGOOptions::IRUse);
+    }
 
-    // Concatenate right string
-    builder.CreateCall(strcatFunc, {result, rightStr});
+    llvm::LoopAnalysisManager lam;
+    llvm::FunctionAnalysisManager fam;
+    llvm::CGSCCAnalysisManager cgam;
+    llvm::ModuleAnalysisManager mam;
 
-    return result;
-}
+    llvm::PassBuilder passBuilder(targetMachine, llvm::PipelineTuningOptions(), pgo);
+    passBuilder.registerModuleAnalyses(mam);
+    passBuilder.registerCGSCCAnalyses(cgam);
+    passBuilder.registerFunctionAnalyses(fam);
+    passBuilder.registerLoopAnalyses(lam);
+    passBuilder.crossRegisterProxies(lam, fam, cgam, mam);
 
-void CodeGenerator::finalize() {
-    builder.CreateRetVoid();
-}
+    llvm::OptimizationLevel optimizationLevel = llvm::OptimizationLevel::O2;
+    if (level == 1) optimizationLevel = llvm::OptimizationLevel::O1;
+    else if (level >= 3) optimizationLevel = llvm::OptimizationLevel::O3;
 
-void CodeGenerator::printIR() {
-    module->print(llvm::outs(), nullptr);
+    llvm::ModulePassManager mpm = passBuilder.buildPerModuleDefaultPipeline(optimizationLevel);
+    mpm.run(*module, mam);
 }
 
 void CodeGenerator::generateToObjectFile(const std::string &filename) {
@@ -228,6 +607,8 @@ void CodeGenerator::generateToObjectFile(const std::string &filename) {
 
     module->setDataLayout(targetMachine->createDataLayout());
 
+    optimizeModule(targetMachine);
+
     std::error_code EC;
     llvm::raw_fd_ostream dest(filename, EC, llvm::sys::fs::OF_None);
 
@@ -250,12 +631,106 @@ void CodeGenerator::generateToObjectFile(const std::string &filename) {
     std::cout << "Archivo objeto generado: " << filename << "\n";
 }
 
+std::string CodeGenerator::cacheDirectory() {
+    if (const char *xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        return std::string(xdg) + "/gozero";
+    }
+    if (const char *home = std::getenv("HOME"); home && *home) {
+        return std::string(home) + "/.cache/gozero";
+    }
+    return "";
+}
+
+// runtime/gozero_runtime.c: where the build says (-DGOZERO_RUNTIME_DIR=...),
+// else next to the gozero executable (or its parent, for build/), else next
+// to this source file when that path is absolute. Never relative to the
+// current directory, so gozero works from anywhere
+static std::string runtimeSourcePath() {
+#ifdef GOZERO_RUNTIME_DIR
+    return std::string(GOZERO_RUNTIME_DIR) + "/gozero_runtime.c";
+#else
+    std::vector<std::string> candidates;
+    static int anchor;
+    std::string executable = llvm::sys::fs::getMainExecutable(nullptr, &anchor);
+    if (!executable.empty()) {
+        llvm::StringRef binDir = llvm::sys::path::parent_path(executable);
+        candidates.push_back((binDir + "/runtime/gozero_runtime.c").str());
+        candidates.push_back((llvm::sys::path::parent_path(binDir) + "/runtime/gozero_runtime.c").str());
+    }
+    llvm::StringRef here = __FILE__;
+    if (llvm::sys::path::is_absolute(here)) {
+        llvm::StringRef root = llvm::sys::path::parent_path(llvm::sys::path::parent_path(here));
+        candidates.push_back((root + "/runtime/gozero_runtime.c").str());
+    }
+    for (const std::string &candidate : candidates) {
+        if (llvm::sys::fs::exists(candidate)) return candidate;
+    }
+    return "";
+#endif
+}
+
+// The runtime compiled once per version of its source: an object in the
+// cache directory named after the hash of the file, built on first use and
+// linked as-is afterwards. Falls back to the source itself when there is
+// nowhere to keep the object
+static std::string runtimeObjectPath(const std::string &source) {
+    auto contents = llvm::MemoryBuffer::getFile(source);
+    std::string directory = CodeGenerator::cacheDirectory();
+    if (!contents || directory.empty()) return "";
+    directory += "/runtime";
+    if (llvm::sys::fs::create_directories(directory)) return "";
+
+    llvm::MD5 hash;
+    hash.update((*contents)->getBuffer());
+    llvm::MD5::MD5Result result;
+    hash.final(result);
+    std::string object = directory + "/gozero_runtime-" + result.digest().str().str() + ".o";
+    if (llvm::sys::fs::exists(object)) return object;
+
+    // Build under a unique name and rename, so concurrent runs never link
+    // half an object
+    int fd;
+    llvm::SmallString<128> temporary;
+    if (llvm::sys::fs::createUniqueFile(directory + "/%%%%%%%%.o", fd, temporary)) return "";
+    llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+    for (const char *compiler : {"clang", "gcc", "cc"}) {
+        std::string command = std::string(compiler) + " -O2 -pthread -c " + source + " -o " + temporary.str().str()
+                              + " 2>/dev/null";
+        if (std::system(command.c_str()) == 0 && !llvm::sys::fs::rename(temporary, object)) {
+            return object;
+        }
+    }
+    llvm::sys::fs::remove(temporary);
+    return "";
+}
+
 void CodeGenerator::linkToExecutable(const std::string &objectFile, const std::string &executableName) {
-    std::vector<std::string> commands = {
-        "clang -no-pie " + objectFile + " -o " + executableName,
-        "gcc -no-pie " + objectFile + " -o " + executableName,
-        "clang -static " + objectFile + " -o " + executableName
-    };
+    // The runtime is linked in only when used
+    std::string inputs = objectFile;
+    if (usesRuntime) {
+        std::string source = runtimeSourcePath();
+        if (source.empty()) {
+            std::cerr << "Error: no se encontro runtime/gozero_runtime.c junto al ejecutable gozero "
+                         "(compila gozero con -DGOZERO_RUNTIME_DIR=<ruta>)\n";
+            std::exit(1);
+        }
+        std::string object = runtimeObjectPath(source);
+        inputs += (object.empty() ? " -O2 " + source : " " + object) + " -pthread";
+    }
+
+    std::vector<std::string> commands;
+    if (profileGenerate) {
+        // Only clang knows where the profile runtime (libclang_rt.profile) lives
+        commands = {
+            "clang -no-pie -fprofile-generate " + inputs + " -o " + executableName
+        };
+    } else {
+        commands = {
+            "clang -no-pie " + inputs + " -o " + executableName,
+            "gcc -no-pie " + inputs + " -o " + executableName,
+            "clang -static " + inputs + " -o " + executableName
+        };
+    }
 
     for (const auto& command : commands) {
         std::cout << "Intentando: " << command << "\n";
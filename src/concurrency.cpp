@@ -0,0 +1,211 @@
+#include "../include/code_generator.h"
+#include <iostream>
+#include <cstdlib>
+
+// go f(args)
+//
+// The arguments are evaluated by the caller and copied into a malloc'ed
+// struct; a per-specialization thunk `void go.<name>(i8* args)` unpacks it,
+// calls the function, drops the result and frees the struct. gz_go (see
+// runtime/gozero_runtime.c) runs the thunk as a green thread, and finalize()
+// makes main wait for every task before it returns.
+//
+// An array argument is passed as a view of main's storage only when that
+// storage outlives the statement: a variable of main's top-level scope or a
+// slice of one. Anything else (a literal, an element-wise result, a variable
+// declared inside a block, whose alloca is reused by every iteration of an
+// enclosing loop) is copied to a malloc'ed buffer. The struct ends with one
+// i8* per array parameter holding that buffer or null, and the thunk frees it.
+
+void CodeGenerator::generateGo(const GoStmt *stmt) {
+    auto *call = static_cast<const CallExpr*>(stmt->call.get());
+    auto declIt = functionDecls.find(call->callee);
+    if (declIt == functionDecls.end()) {
+        std::cerr << "Error fatal: función no declarada '" << call->callee << "'\n";
+        std::cerr << "Compilación terminada debido a errores.\n";
+        std::exit(1);
+    }
+    llvm::Function *func = getSpecialization(declIt->second, typeAnalyzer.analyzeCallExpr(call));
+
+    llvm::Type *i8Ptr = llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context));
+    llvm::Type *i64 = llvm::Type::getInt64Ty(context);
+
+    // Arguments, exactly as for a plain call; array copies go to owned
+    std::vector<llvm::Value*> args;
+    std::vector<llvm::Value*> owned;
+    auto paramIt = func->arg_begin();
+    for (const auto &arg : call->args) {
+        bool isArrayParam = (paramIt++)->getType()->isStructTy();
+        if (isArrayParam && currentFunction) {
+            // Only main's arrays are guaranteed to outlive the task
+            std::cerr << "Error (line " << stmt->line << ":" << stmt->column
+                      << "): 'go' dentro de una función no puede recibir arrays como argumento\n";
+            std::exit(1);
+        }
+        llvm::Value *argVal = isArrayParam ? generateArrayView(arg.get()) : generate(arg.get());
+        if (!argVal) return;
+        if (isArrayParam) {
+            const Expr *base = arg.get();
+            if (auto *slice = dynamic_cast<const SliceExpr*>(base)) base = slice->array.get();
+            auto *var = dynamic_cast<const VarExpr*>(base);
+            auto topLevel = var ? namedValuesStack.front().find(var->name) : namedValuesStack.front().end();
+            bool shared = topLevel != namedValuesStack.front().end() && findVariable(var->name) == topLevel->second;
+            if (shared) {
+                owned.push_back(llvm::ConstantPointerNull::get(llvm::cast<llvm::PointerType>(i8Ptr)));
+            } else {
+                llvm::Type *elemType = getLLVMType(TypeAnalyzer::elementType(typeAnalyzer.inferType(arg.get())));
+                llvm::Value *length = builder.CreateExtractValue(argVal, 1, "go_copy_len");
+                llvm::Value *copy = createHeapArray(elemType, length, "go_copy");
+                llvm::Value *bytes = builder.CreateMul(length, llvm::ConstantExpr::getSizeOf(elemType), "go_copy_bytes");
+                builder.CreateMemCpy(copy, llvm::MaybeAlign(), builder.CreateExtractValue(argVal, 0),
+                                     llvm::MaybeAlign(), bytes);
+                argVal = builder.CreateInsertValue(argVal, copy, 0, "go_copy_view");
+                owned.push_back(builder.CreatePointerCast(copy, i8Ptr));
+            }
+        }
+        args.push_back(argVal);
+    }
+
+    llvm::FunctionType *funcType = func->getFunctionType();
+    std::vector<llvm::Type*> fields(funcType->param_begin(), funcType->param_end());
+    size_t numParams = fields.size();
+    for (llvm::Type *param : funcType->params()) {
+        if (param->isStructTy()) fields.push_back(i8Ptr);
+    }
+    llvm::StructType *argsType = llvm::StructType::get(context, fields);
+    llvm::FunctionType *thunkType = llvm::FunctionType::get(llvm::Type::getVoidTy(context), {i8Ptr}, false);
+    llvm::FunctionCallee freeFunc = module->getOrInsertFunction(
+        "free", llvm::FunctionType::get(llvm::Type::getVoidTy(context), {i8Ptr}, false));
+
+    llvm::Function *&thunk = goThunks[func];
+    if (!thunk) {
+        thunk = llvm::Function::Create(thunkType, llvm::Function::InternalLinkage,
+                                       "go." + func->getName().str(), module.get());
+        llvm::IRBuilder<> thunkBuilder(llvm::BasicBlock::Create(context, "entry", thunk));
+        llvm::Value *packed = thunkBuilder.CreatePointerCast(thunk->getArg(0),
+                                                             llvm::PointerType::getUnqual(argsType), "args");
+        std::vector<llvm::Value*> unpacked;
+        for (unsigned i = 0; i < numParams; ++i) {
+            unpacked.push_back(thunkBuilder.CreateLoad(argsType->getElementType(i),
+                                                       thunkBuilder.CreateStructGEP(argsType, packed, i)));
+        }
+        thunkBuilder.CreateCall(func, unpacked);
+        for (unsigned i = numParams; i < argsType->getNumElements(); ++i) {
+            thunkBuilder.CreateCall(freeFunc, {thunkBuilder.CreateLoad(i8Ptr, thunkBuilder.CreateStructGEP(argsType, packed, i))});
+        }
+        thunkBuilder.CreateCall(freeFunc, {thunk->getArg(0)});
+        thunkBuilder.CreateRetVoid();
+    }
+
+    llvm::FunctionCallee mallocFunc = module->getOrInsertFunction(
+        "malloc", llvm::FunctionType::get(i8Ptr, {i64}, false));
+    llvm::Value *size = llvm::ConstantExpr::getSizeOf(argsType);
+    llvm::Value *packed = builder.CreateCall(mallocFunc, {size}, "go_args");
+    llvm::Value *typed = builder.CreatePointerCast(packed, llvm::PointerType::getUnqual(argsType), "go_args_struct");
+    for (unsigned i = 0; i < args.size(); ++i) {
+        builder.CreateStore(args[i], builder.CreateStructGEP(argsType, typed, i));
+    }
+    for (unsigned i = 0; i < owned.size(); ++i) {
+        builder.CreateStore(owned[i], builder.CreateStructGEP(argsType, typed, numParams + i));
+    }
+
+    llvm::FunctionCallee goFunc = module->getOrInsertFunction(
+        "gz_go", llvm::FunctionType::get(llvm::Type::getVoidTy(context),
+                                         {llvm::PointerType::getUnqual(thunkType), i8Ptr}, false));
+    builder.CreateCall(goFunc, {thunk, packed});
+    usesRuntime = true;
+    usesTasks = true;
+}
+
+// Channels
+//
+// A channel is an opaque gz_chan* from the runtime. Elements travel as
+// 64-bit slots (toSlot/fromSlot). send blocks while the ring is full and
+// recv while it is empty; recv on a closed, drained channel yields the zero
+// value (or false for recv(c, x)).
+
+llvm::Value* CodeGenerator::generateChan(const ChanExpr *expr) {
+    llvm::Value *capacity = generateTyped(expr->capacity.get(), VarDeclStmt::INT64);
+    if (!capacity) return nullptr;
+    llvm::Type *chanType = getLLVMType(VarDeclStmt::CHAN_INT);
+    llvm::FunctionCallee newFunc = module->getOrInsertFunction(
+        "gz_chan_new", llvm::FunctionType::get(chanType, {llvm::Type::getInt64Ty(context)}, false));
+    usesRuntime = true;
+    return builder.CreateCall(newFunc, {capacity}, "chan");
+}
+
+void CodeGenerator::generateSend(const SendStmt *stmt) {
+    VarDeclStmt::Kind elemKind = typeAnalyzer.analyzeSend(stmt);
+    llvm::Value *chan = generate(stmt->chan.get());
+    llvm::Value *value = generateTyped(stmt->value.get(), elemKind);
+    if (!chan || !value) return;
+
+    emitDebugLocation(stmt->line, stmt->column);
+    llvm::FunctionCallee sendFunc = module->getOrInsertFunction(
+        "gz_chan_send", llvm::FunctionType::get(llvm::Type::getVoidTy(context),
+                                                {chan->getType(), llvm::Type::getInt64Ty(context)}, false));
+    builder.CreateCall(sendFunc, {chan, toSlot(value, elemKind)});
+    usesRuntime = true;
+}
+
+void CodeGenerator::generateClose(const CloseStmt *stmt) {
+    typeAnalyzer.channelElementType(stmt->chan.get(), stmt->line, stmt->column);
+    llvm::Value *chan = generate(stmt->chan.get());
+    if (!chan) return;
+
+    emitDebugLocation(stmt->line, stmt->column);
+    llvm::FunctionCallee closeFunc = module->getOrInsertFunction(
+        "gz_chan_close", llvm::FunctionType::get(llvm::Type::getVoidTy(context), {chan->getType()}, false));
+    builder.CreateCall(closeFunc, {chan});
+    usesRuntime = true;
+}
+
+llvm::Value* CodeGenerator::generateRecv(const RecvExpr *expr) {
+    VarDeclStmt::Kind elemKind = typeAnalyzer.channelElementType(expr->chan.get(), expr->line, expr->column);
+    llvm::AllocaInst *target = nullptr;
+    if (!expr->target.empty()) {
+        target = findVariable(expr->target);
+        if (!target) {
+            std::cerr << "Error (line " << expr->line << ":" << expr->column << "): variable no declarada '"
+                      << expr->target << "'\n";
+            std::exit(1);
+        }
+        VarDeclStmt::Kind targetKind = typeAnalyzer.getVariableType(expr->target);
+        bool compatible = (elemKind == VarDeclStmt::STRING) ? targetKind == VarDeclStmt::STRING
+                                                            : TypeAnalyzer::isNumericType(targetKind);
+        if (!compatible) {
+            std::cerr << "Error (line " << expr->line << ":" << expr->column << "): la variable '"
+                      << expr->target << "' no puede recibir elementos de este canal\n";
+            std::exit(1);
+        }
+    }
+
+    llvm::Value *chan = generate(expr->chan.get());
+    if (!chan) return nullptr;
+    emitDebugLocation(expr->line, expr->column);
+
+    llvm::Value *more = nullptr;
+    llvm::Value *elem = emitChanRecv(chan, elemKind, more);
+    if (!target) return elem;
+
+    if (llvm::Value *converted = convertValue(elem, target->getAllocatedType())) {
+        elem = converted;
+    }
+    builder.CreateStore(elem, target);
+    return more;
+}
+
+// Receive one element; `more` is false once the channel is closed and drained
+llvm::Value* CodeGenerator::emitChanRecv(llvm::Value *chan, VarDeclStmt::Kind elemKind, llvm::Value *&more) {
+    llvm::Type *i64 = llvm::Type::getInt64Ty(context);
+    llvm::AllocaInst *slot = createEntryBlockAlloca("recv.slot", i64);
+    llvm::FunctionCallee recvFunc = module->getOrInsertFunction(
+        "gz_chan_recv", llvm::FunctionType::get(llvm::Type::getInt32Ty(context),
+                                                {chan->getType(), llvm::PointerType::getUnqual(i64)}, false));
+    llvm::Value *ok = builder.CreateCall(recvFunc, {chan, slot}, "recv_ok");
+    more = builder.CreateICmpNE(ok, builder.getInt32(0), "recv_more");
+    usesRuntime = true;
+
+    llvm::Value *slotVal = builder.CreateLoad(i64, slot, "slot");
+    return fromSlot(slotVal, elemKind);
+}
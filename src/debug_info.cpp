@@ -0,0 +1,142 @@
+#include "../include/code_generator.h"
+#include <llvm/BinaryFormat/Dwarf.h>
+#include <llvm/IR/DebugInfoMetadata.h>
+#include <iostream>
+
+// DWARF debug info (-g). Every function gets a DISubprogram and keeps its
+// frame pointer, every statement and expression sets the builder's debug
+// location, and named variables and parameters get dbg.declare records, so
+// perf, gdb and flamegraphs can map samples back to .goz lines.
+
+void CodeGenerator::setDebugInfo(const std::string &sourceFile) {
+    if (diBuilder) return;
+
+    std::string directory = ".";
+    std::string fileName = sourceFile;
+    size_t slash = sourceFile.find_last_of('/');
+    if (slash != std::string::npos) {
+        directory = sourceFile.substr(0, slash);
+        fileName = sourceFile.substr(slash + 1);
+    }
+
+    module->addModuleFlag(llvm::Module::Warning, "Debug Info Version", llvm::DEBUG_METADATA_VERSION);
+    module->addModuleFlag(llvm::Module::Warning, "Dwarf Version", 4);
+
+    diBuilder = std::make_unique<llvm::DIBuilder>(*module);
+    diFile = diBuilder->createFile(fileName, directory);
+    diCompileUnit = diBuilder->createCompileUnit(llvm::dwarf::DW_LANG_C, diFile, "GoZero", optLevel > 0, "", 0);
+
+    createDebugFunction(mainFunction, "main", 1, VarDeclStmt::VOID, {});
+}
+
+llvm::DIType* CodeGenerator::getDebugType(VarDeclStmt::Kind kind) {
+    auto it = diTypes.find(kind);
+    if (it != diTypes.end()) return it->second;
+
+    llvm::DIType *type = nullptr;
+    switch (kind) {
+        case VarDeclStmt::INT:
+            type = diBuilder->createBasicType("int", 32, llvm::dwarf::DW_ATE_signed);
+            break;
+        case VarDeclStmt::FLOAT:
+            type = diBuilder->createBasicType("float", 32, llvm::dwarf::DW_ATE_float);
+            break;
+        case VarDeclStmt::STRING:
+            type = diBuilder->createPointerType(
+                diBuilder->createBasicType("char", 8, llvm::dwarf::DW_ATE_signed_char), 64, 0, std::nullopt, "string");
+            break;
+        case VarDeclStmt::INT_ARRAY:
+            type = diBuilder->createPointerType(getDebugType(VarDeclStmt::INT), 64);
+            break;
+        case VarDeclStmt::FLOAT_ARRAY:
+            type = diBuilder->createPointerType(getDebugType(VarDeclStmt::FLOAT), 64);
+            break;
+        case VarDeclStmt::STRING_ARRAY:
+            type = diBuilder->createPointerType(getDebugType(VarDeclStmt::STRING), 64);
+            break;
+        case VarDeclStmt::BOOL:
+            type = diBuilder->createBasicType("bool", 8, llvm::dwarf::DW_ATE_boolean);
+            break;
+        case VarDeclStmt::INT64:
+            type = diBuilder->createBasicType("int64", 64, llvm::dwarf::DW_ATE_signed);
+            break;
+        case VarDeclStmt::DOUBLE:
+            type = diBuilder->createBasicType("double", 64, llvm::dwarf::DW_ATE_float);
+            break;
+        case VarDeclStmt::INT64_ARRAY:
+            type = diBuilder->createPointerType(getDebugType(VarDeclStmt::INT64), 64);
+            break;
+        case VarDeclStmt::DOUBLE_ARRAY:
+            type = diBuilder->createPointerType(getDebugType(VarDeclStmt::DOUBLE), 64);
+            break;
+        case VarDeclStmt::CHAN_INT:
+        case VarDeclStmt::CHAN_FLOAT:
+        case VarDeclStmt::CHAN_STRING:
+            type = diBuilder->createPointerType(nullptr, 64, 0, std::nullopt, "chan");
+            break;
+        case VarDeclStmt::MAP_INT:
+        case VarDeclStmt::MAP_FLOAT:
+        case VarDeclStmt::MAP_STRING:
+            type = diBuilder->createPointerType(nullptr, 64, 0, std::nullopt, "map");
+            break;
+        case VarDeclStmt::BUILDER:
+            type = diBuilder->createPointerType(nullptr, 64, 0, std::nullopt, "builder");
+            break;
+        case VarDeclStmt::VOID:
+            break;
+    }
+    diTypes[kind] = type;
+    return type;
+}
+
+llvm::DISubprogram* CodeGenerator::createDebugFunction(llvm::Function *function, const std::string &name, int line,
+                                                       VarDeclStmt::Kind returnKind,
+                                                       const std::vector<VarDeclStmt::Kind> &paramKinds) {
+    if (!diBuilder) return nullptr;
+
+    // Keep frame pointers so stack walkers work without unwinding tables
+    function->addFnAttr("frame-pointer", "all");
+
+    std::vector<llvm::Metadata*> signature;
+    signature.push_back(getDebugType(returnKind));
+    for (VarDeclStmt::Kind paramKind : paramKinds) {
+        signature.push_back(getDebugType(paramKind));
+    }
+    llvm::DISubroutineType *functionType =
+        diBuilder->createSubroutineType(diBuilder->getOrCreateTypeArray(signature));
+
+    llvm::DISubprogram *subprogram = diBuilder->createFunction(
+        diFile, name, function->getName(), diFile, line, functionType, line,
+        llvm::DINode::FlagPrototyped, llvm::DISubprogram::SPFlagDefinition);
+    function->setSubprogram(subprogram);
+    diSubprograms[function] = subprogram;
+
+    builder.SetCurrentDebugLocation(llvm::DILocation::get(context, line, 0, subprogram));
+    return subprogram;
+}
+
+void CodeGenerator::emitDebugLocation(int line, int column) {
+    if (!diBuilder || !builder.GetInsertBlock()) return;
+
+    auto it = diSubprograms.find(builder.GetInsertBlock()->getParent());
+    if (it == diSubprograms.end()) return;
+    builder.SetCurrentDebugLocation(llvm::DILocation::get(context, line, column, it->second));
+}
+
+void CodeGenerator::declareDebugVariable(const std::string &name, llvm::AllocaInst *alloca, VarDeclStmt::Kind kind,
+                                         int line, int column, unsigned argNo) {
+    if (!diBuilder) return;
+
+    auto it = diSubprograms.find(builder.GetInsertBlock()->getParent());
+    if (it == diSubprograms.end()) return;
+    llvm::DISubprogram *scope = it->second;
+
+    llvm::DILocalVariable *variable;
+    if (argNo > 0) {
+        variable = diBuilder->createParameterVariable(scope, name, argNo, diFile, line, getDebugType(kind), true);
+    } else {
+        variable = diBuilder->createAutoVariable(scope, name, diFile, line, getDebugType(kind), true);
+    }
+    diBuilder->insertDeclare(alloca, variable, diBuilder->createExpression(),
+                             llvm::DILocation::get(context, line, column, scope), builder.GetInsertBlock());
+}
@@ -0,0 +1,84 @@
+#include "../include/code_generator.h"
+#include <iostream>
+#include <cstdlib>
+
+// Input builtins
+//
+// readFile, mapInts and mapFloats map the whole file with mmap (see
+// gz_file_* in runtime/gozero_runtime.c) and hand the mapping to the
+// program as it is: readFile's string and the arrays of mapInts/mapFloats
+// point straight into the page cache, nothing is copied or parsed. The
+// arrays are views like a slice: their length comes from the file size and
+// is recorded in viewLengths. lines(path) is only an iterable; generateForIn
+// opens it with emitLinesOpen and pulls one line per iteration.
+//
+// readInt, readFloat and readLine parse standard input in the runtime
+// (gz_read_*) out of one large buffer instead of going through scanf.
+
+llvm::Value* CodeGenerator::generateFileBuiltin(const CallExpr *call) {
+    if (call->callee == "lines") {
+        typeAnalyzer.inferType(call); // reports lines used outside a for-in
+        return nullptr;
+    }
+    llvm::Value *path = generate(call->args[0].get());
+    if (!path) return nullptr;
+    emitDebugLocation(call->line, call->column);
+    llvm::Type *i8Ptr = llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context));
+    llvm::Type *i64 = llvm::Type::getInt64Ty(context);
+    usesRuntime = true;
+
+    if (call->callee == "readFile") {
+        llvm::FunctionCallee readFunc = module->getOrInsertFunction(
+            "gz_file_read", llvm::FunctionType::get(i8Ptr, {path->getType()}, false));
+        return builder.CreateCall(readFunc, {path}, "file");
+    }
+
+    // mapInts / mapFloats: the file is a packed array of 32-bit elements
+    VarDeclStmt::Kind elemKind = call->callee == "mapInts" ? VarDeclStmt::INT : VarDeclStmt::FLOAT;
+    llvm::Type *elemType = getLLVMType(elemKind);
+    llvm::AllocaInst *count = createEntryBlockAlloca("file.count", i64);
+    llvm::FunctionCallee arrayFunc = module->getOrInsertFunction(
+        "gz_file_array", llvm::FunctionType::get(i8Ptr, {path->getType(), i64, llvm::PointerType::getUnqual(i64)}, false));
+    llvm::Value *data = builder.CreateCall(
+        arrayFunc, {path, builder.getInt64(module->getDataLayout().getTypeAllocSize(elemType)), count}, "file_array");
+    viewLengths[call] = builder.CreateTrunc(builder.CreateLoad(i64, count, "file_count"),
+                                            llvm::Type::getInt32Ty(context), "file_len");
+    return builder.CreatePointerCast(data, llvm::PointerType::getUnqual(elemType), "file_elems");
+}
+
+llvm::Value* CodeGenerator::emitLinesOpen(const CallExpr *call) {
+    llvm::Value *path = generate(call->args[0].get());
+    if (!path) return nullptr;
+    emitDebugLocation(call->line, call->column);
+    llvm::Type *i8Ptr = llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context));
+    llvm::FunctionCallee openFunc = module->getOrInsertFunction(
+        "gz_file_lines", llvm::FunctionType::get(i8Ptr, {path->getType()}, false));
+    usesRuntime = true;
+    return builder.CreateCall(openFunc, {path}, "lines");
+}
+
+// The next line without its terminator, or NULL at end of file
+llvm::Value* CodeGenerator::emitNextLine(llvm::Value *lines) {
+    llvm::Type *i8Ptr = llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context));
+    llvm::FunctionCallee nextFunc = module->getOrInsertFunction(
+        "gz_file_next_line", llvm::FunctionType::get(i8Ptr, {lines->getType()}, false));
+    return builder.CreateCall(nextFunc, {lines}, "line");
+}
+
+llvm::Value* CodeGenerator::generateReadBuiltin(const CallExpr *call) {
+    emitDebugLocation(call->line, call->column);
+    usesRuntime = true;
+    if (call->callee == "readInt") {
+        llvm::FunctionCallee readFunc = module->getOrInsertFunction(
+            "gz_read_int", llvm::FunctionType::get(llvm::Type::getInt64Ty(context), false));
+        return builder.CreateTrunc(builder.CreateCall(readFunc, {}, "read_int"), getLLVMType(VarDeclStmt::INT), "read_int32");
+    }
+    if (call->callee == "readFloat") {
+        llvm::FunctionCallee readFunc = module->getOrInsertFunction(
+            "gz_read_float", llvm::FunctionType::get(llvm::Type::getDoubleTy(context), false));
+        return builder.CreateFPTrunc(builder.CreateCall(readFunc, {}, "read_double"), getLLVMType(VarDeclStmt::FLOAT), "read_float");
+    }
+    llvm::FunctionCallee readFunc = module->getOrInsertFunction(
+        "gz_read_line", llvm::FunctionType::get(getLLVMType(VarDeclStmt::STRING), false));
+    return builder.CreateCall(readFunc, {}, "read_line");
+}
@@ -0,0 +1,171 @@
+#include "../include/code_generator.h"
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/Intrinsics.h>
+#include <iostream>
+
+// Lightweight hot-spot profiler (--instrument). Every function gets call,
+// inclusive-cycle and exclusive-cycle counters; every loop gets entry and
+// back-edge (trip) counters. Cycles come from llvm.readcyclecounter (rdtsc
+// on x86). Exclusive time is tracked with an accumulator of the cycles
+// spent in callees: each frame saves it on entry, and on exit adds its own
+// inclusive time to the saved value. The accumulator comes from the runtime
+// (gz_prof_child): a go task has its own, since it can park in a channel
+// operation and resume on another worker, and other code uses its thread's.
+// Each frame looks it up once on entry.
+//
+// parallel for bodies and go tasks run instrumented code on several threads
+// at once, so counters are bumped with a relaxed (monotonic) atomicrmw add
+// and no update is lost.
+
+void CodeGenerator::setInstrument(bool enabled) {
+    if (!enabled || instrument) return;
+    instrument = true;
+
+    usesRuntime = true; // gz_prof_child
+
+    // The report is registered with atexit so it also runs when a bounds
+    // check aborts the program; its body is emitted in finalize()
+    llvm::FunctionType *reportType = llvm::FunctionType::get(llvm::Type::getVoidTy(context), false);
+    profileReportFunction = llvm::Function::Create(reportType, llvm::Function::InternalLinkage,
+                                                   "__gozero_profile_report", module.get());
+
+    llvm::Type *voidFnPtr = llvm::PointerType::getUnqual(reportType);
+    llvm::FunctionType *atexitType = llvm::FunctionType::get(
+        llvm::Type::getInt32Ty(context), {voidFnPtr}, false);
+    llvm::FunctionCallee atexitFunc = module->getOrInsertFunction("atexit", atexitType);
+    builder.CreateCall(atexitFunc, {profileReportFunction});
+
+    emitProfileEntry(mainFunction, "main", 1, 1);
+}
+
+llvm::GlobalVariable* CodeGenerator::createProfileCounter(const std::string &name) {
+    llvm::Type *i64 = llvm::Type::getInt64Ty(context);
+    return new llvm::GlobalVariable(*module, i64, false, llvm::GlobalValue::InternalLinkage,
+                                    llvm::ConstantInt::get(i64, 0), name);
+}
+
+void CodeGenerator::incrementProfileCounter(llvm::GlobalVariable *counter, llvm::Value *amount) {
+    llvm::Type *i64 = llvm::Type::getInt64Ty(context);
+    if (!amount) amount = llvm::ConstantInt::get(i64, 1);
+    builder.CreateAtomicRMW(llvm::AtomicRMWInst::Add, counter, amount, llvm::MaybeAlign(8),
+                            llvm::AtomicOrdering::Monotonic);
+}
+
+void CodeGenerator::emitProfileEntry(llvm::Function *function, const std::string &label, int line, int column) {
+    if (!instrument) return;
+
+    ProfileSite site;
+    site.isLoop = false;
+    site.label = label;
+    site.line = line;
+    site.column = column;
+    site.counters[0] = createProfileCounter("__gozero_prof_calls." + label);
+    site.counters[1] = createProfileCounter("__gozero_prof_incl." + label);
+    site.counters[2] = createProfileCounter("__gozero_prof_excl." + label);
+    profileSites.push_back(site);
+
+    llvm::Type *i64 = llvm::Type::getInt64Ty(context);
+    incrementProfileCounter(site.counters[0]);
+
+    llvm::FunctionCallee childFunc = module->getOrInsertFunction(
+        "gz_prof_child", llvm::FunctionType::get(llvm::PointerType::getUnqual(i64), false));
+
+    ProfileFrame frame;
+    frame.site = profileSites.size() - 1;
+    frame.childSlot = builder.CreateCall(childFunc, {}, "prof_child_slot");
+    frame.savedChild = builder.CreateLoad(i64, frame.childSlot, "prof_saved_child");
+    builder.CreateStore(llvm::ConstantInt::get(i64, 0), frame.childSlot);
+    llvm::Function *rdtsc = llvm::Intrinsic::getDeclaration(module.get(), llvm::Intrinsic::readcyclecounter);
+    frame.start = builder.CreateCall(rdtsc, {}, "prof_start");
+    profileFrames[function] = frame;
+}
+
+void CodeGenerator::emitProfileExit() {
+    if (!instrument) return;
+
+    auto frameIt = profileFrames.find(builder.GetInsertBlock()->getParent());
+    if (frameIt == profileFrames.end()) return;
+    const ProfileFrame &frame = frameIt->second;
+    const ProfileSite &site = profileSites[frame.site];
+
+    llvm::Type *i64 = llvm::Type::getInt64Ty(context);
+    llvm::Function *rdtsc = llvm::Intrinsic::getDeclaration(module.get(), llvm::Intrinsic::readcyclecounter);
+    llvm::Value *end = builder.CreateCall(rdtsc, {}, "prof_end");
+    llvm::Value *elapsed = builder.CreateSub(end, frame.start, "prof_elapsed");
+    llvm::Value *childCycles = builder.CreateLoad(i64, frame.childSlot, "prof_child");
+
+    incrementProfileCounter(site.counters[1], elapsed);
+    incrementProfileCounter(site.counters[2], builder.CreateSub(elapsed, childCycles, "prof_self"));
+    builder.CreateStore(builder.CreateAdd(frame.savedChild, elapsed, "prof_parent_child"), frame.childSlot);
+}
+
+size_t CodeGenerator::createLoopProfileSite(const std::string &label, int line, int column) {
+    ProfileSite site;
+    site.isLoop = true;
+    site.label = label;
+    site.line = line;
+    site.column = column;
+    std::string suffix = label + "." + std::to_string(line) + "." + std::to_string(column);
+    site.counters[0] = createProfileCounter("__gozero_prof_entries." + suffix);
+    site.counters[1] = createProfileCounter("__gozero_prof_trips." + suffix);
+    site.counters[2] = nullptr;
+    profileSites.push_back(site);
+    return profileSites.size() - 1;
+}
+
+void CodeGenerator::emitProfileReport() {
+    if (!instrument) return;
+
+    llvm::Type *charPtrType = llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context));
+    llvm::Type *i64 = llvm::Type::getInt64Ty(context);
+    llvm::FunctionCallee fopenFunc = module->getOrInsertFunction("fopen",
+        llvm::FunctionType::get(charPtrType, {charPtrType, charPtrType}, false));
+    llvm::FunctionCallee fprintfFunc = module->getOrInsertFunction("fprintf",
+        llvm::FunctionType::get(llvm::Type::getInt32Ty(context), {charPtrType, charPtrType}, true));
+    llvm::FunctionCallee fcloseFunc = module->getOrInsertFunction("fclose",
+        llvm::FunctionType::get(llvm::Type::getInt32Ty(context), {charPtrType}, false));
+
+    llvm::IRBuilder<> reportBuilder(llvm::BasicBlock::Create(context, "entry", profileReportFunction));
+    llvm::BasicBlock *writeBB = llvm::BasicBlock::Create(context, "write", profileReportFunction);
+    llvm::BasicBlock *doneBB = llvm::BasicBlock::Create(context, "done", profileReportFunction);
+
+    llvm::Value *file = reportBuilder.CreateCall(fopenFunc,
+        {reportBuilder.CreateGlobalString("gozero.prof", "prof_path"),
+         reportBuilder.CreateGlobalString("w", "prof_mode")}, "prof_file");
+    reportBuilder.CreateCondBr(reportBuilder.CreateIsNull(file), doneBB, writeBB);
+
+    reportBuilder.SetInsertPoint(writeBB);
+    reportBuilder.CreateCall(fprintfFunc, {file,
+        reportBuilder.CreateGlobalString("%-6s %-24s %10s %14s %20s %20s\n", "prof_header_fmt"),
+        reportBuilder.CreateGlobalString("kind", "prof_h_kind"),
+        reportBuilder.CreateGlobalString("name", "prof_h_name"),
+        reportBuilder.CreateGlobalString("line:col", "prof_h_pos"),
+        reportBuilder.CreateGlobalString("calls/entries", "prof_h_calls"),
+        reportBuilder.CreateGlobalString("incl_cycles/trips", "prof_h_incl"),
+        reportBuilder.CreateGlobalString("excl_cycles", "prof_h_excl")});
+
+    llvm::Value *functionFmt = reportBuilder.CreateGlobalString("%-6s %-24s %5d:%-4d %14llu %20llu %20llu\n", "prof_fn_fmt");
+    llvm::Value *loopFmt = reportBuilder.CreateGlobalString("%-6s %-24s %5d:%-4d %14llu %20llu %20s\n", "prof_loop_fmt");
+    llvm::Value *funcKind = reportBuilder.CreateGlobalString("func", "prof_kind_func");
+    llvm::Value *loopKind = reportBuilder.CreateGlobalString("loop", "prof_kind_loop");
+    llvm::Value *empty = reportBuilder.CreateGlobalString("-", "prof_empty");
+
+    for (const auto &site : profileSites) {
+        llvm::Value *label = reportBuilder.CreateGlobalString(site.label, "prof_label");
+        llvm::Value *line = reportBuilder.getInt32(site.line);
+        llvm::Value *column = reportBuilder.getInt32(site.column);
+        llvm::Value *first = reportBuilder.CreateLoad(i64, site.counters[0]);
+        llvm::Value *second = reportBuilder.CreateLoad(i64, site.counters[1]);
+        if (site.isLoop) {
+            reportBuilder.CreateCall(fprintfFunc, {file, loopFmt, loopKind, label, line, column, first, second, empty});
+        } else {
+            llvm::Value *third = reportBuilder.CreateLoad(i64, site.counters[2]);
+            reportBuilder.CreateCall(fprintfFunc, {file, functionFmt, funcKind, label, line, column, first, second, third});
+        }
+    }
+    reportBuilder.CreateCall(fcloseFunc, {file});
+    reportBuilder.CreateBr(doneBB);
+
+    reportBuilder.SetInsertPoint(doneBB);
+    reportBuilder.CreateRetVoid();
+}
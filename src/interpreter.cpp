@@ -0,0 +1,439 @@
+#include "../include/interpreter.h"
+#ifndef GOZERO_NO_JIT
+#include "../include/jit.h"
+#endif
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+
+// Virtual machine for --interp
+//
+// All frames share one stack of Slots: a call puts the callee's registers
+// right above the caller's, copies the arguments into its first registers
+// and remembers where to resume and which register receives the result.
+// Dispatch jumps straight from one instruction's handler to the next
+// through a table of label addresses (GCC/Clang computed goto); other
+// compilers get the same handlers as a switch in a loop. Values print with
+// the compiled program's printf formats, and out-of-bounds accesses fail
+// with its message, so both give the same output.
+//
+// Calls and loop back-edges add to their function's heat; with --jit a
+// function that reaches JIT_THRESHOLD is sent to the JitCompiler, and CALL
+// switches to its native entry as soon as that is published. Built with
+// -DGOZERO_NO_JIT (gozero-interp, see interp_main.cpp) this file needs no
+// LLVM and functions only heat up.
+
+namespace {
+
+constexpr size_t STACK_SLOTS = size_t(1) << 22; // 32 MiB of registers
+constexpr size_t MAX_CALL_DEPTH = 1000000;
+constexpr uint32_t JIT_THRESHOLD = 1000; // heat at which --jit compiles a function
+#ifndef GOZERO_NO_JIT
+static_assert(std::is_same_v<Interpreter::NativeEntry, JitCompiler::Entry>, "the JIT publishes NativeEntry");
+#endif
+
+[[noreturn]] void divisionByZero() {
+    std::fflush(stdout);
+    std::cerr << "Error: división por cero\n";
+    std::exit(1);
+}
+
+// readInt/readFloat/readLine on stdin, with gz_read_*'s behavior: numbers
+// skip leading whitespace and read as 0 at end of input
+int nextNonSpace() {
+    int c;
+    do {
+        c = std::getchar();
+    } while (c != EOF && std::isspace(c));
+    return c;
+}
+
+int64_t readInt() {
+    int c = nextNonSpace();
+    if (c == EOF) return 0;
+    bool negative = c == '-';
+    if (c == '-' || c == '+') c = std::getchar();
+    uint64_t value = 0;
+    int digits = 0;
+    for (; c >= '0' && c <= '9'; c = std::getchar(), ++digits) {
+        value = value * 10 + static_cast<uint64_t>(c - '0');
+    }
+    if (digits == 0) {
+        std::fflush(stdout);
+        std::cerr << "Error: readInt esperaba un entero\n";
+        std::exit(1);
+    }
+    if (c != EOF) std::ungetc(c, stdin);
+    return negative ? -static_cast<int64_t>(value) : static_cast<int64_t>(value);
+}
+
+double readFloat() {
+    int c = nextNonSpace();
+    if (c == EOF) return 0.0;
+    std::string token;
+    for (; c != EOF && !std::isspace(c); c = std::getchar()) {
+        token += static_cast<char>(c);
+    }
+    if (c != EOF) std::ungetc(c, stdin);
+    char *end;
+    double value = std::strtod(token.c_str(), &end);
+    if (end == token.c_str()) {
+        std::fflush(stdout);
+        std::cerr << "Error: readFloat esperaba un número\n";
+        std::exit(1);
+    }
+    return value;
+}
+
+} // namespace
+
+const char* Interpreter::newString(const char *data, size_t length) {
+    strings.emplace_back(new char[length + 1]);
+    char *text = strings.back().get();
+    std::memcpy(text, data, length);
+    text[length] = '\0';
+    return text;
+}
+
+Interpreter::Array* Interpreter::newView(Slot *data, int64_t length) {
+    arrays.push_back(std::make_unique<Array>());
+    Array *array = arrays.back().get();
+    array->data = data;
+    array->length = length;
+    return array;
+}
+
+Interpreter::Array* Interpreter::newArray(int64_t length) {
+    arrayData.emplace_back(new Slot[length > 0 ? length : 1]());
+    return newView(arrayData.back().get(), length);
+}
+
+// Only functions whose arguments and result fit in a slot as the compiled
+// code sees them; arrays and builders are laid out differently there
+void Interpreter::requestJit(Function *function) {
+    if (!jit || !function->decl) return;
+    auto native = [](VarDeclStmt::Kind kind) {
+        return kind == VarDeclStmt::INT || kind == VarDeclStmt::INT64 || kind == VarDeclStmt::BOOL ||
+               kind == VarDeclStmt::FLOAT || kind == VarDeclStmt::DOUBLE || kind == VarDeclStmt::STRING;
+    };
+    for (VarDeclStmt::Kind kind : function->paramKinds) {
+        if (!native(kind)) return;
+    }
+    if (function->returnKind != VarDeclStmt::VOID && !native(function->returnKind)) return;
+#ifndef GOZERO_NO_JIT
+    jit->request(function->decl, function->paramKinds, &function->native);
+#endif
+}
+
+int Interpreter::run() {
+    return execute();
+}
+
+int Interpreter::execute() {
+    struct Frame {
+        Function *function;
+        const Instr *resume;
+        Slot *registers;
+        uint16_t result;
+    };
+    // Left uninitialized: zeroing 32 MiB up front would touch every page and
+    // cost more than running a short script. Registers are always written
+    // before they are read
+    std::unique_ptr<Slot[]> stack(new Slot[STACK_SLOTS]);
+    std::vector<Frame> frames;
+
+    Function *function = functions[0].get();
+    const Instr *code = function->code.data();
+    const Instr *ip = code;
+    const Slot *constants = function->constants.data();
+    Slot *r = stack.get();
+    Slot *stackEnd = stack.get() + STACK_SLOTS;
+    const Instr *in;
+    Slot result;
+
+    if (function->numRegisters > STACK_SLOTS) {
+        std::cerr << "Error: el programa necesita demasiados registros para --interp\n";
+        return 1;
+    }
+
+    auto boundsError = [&](const Instr *at) {
+        auto name = function->checkNames.find(static_cast<uint32_t>(at - code));
+        std::printf("Runtime Error: Index out of bounds for variable '%s'\n",
+                    name != function->checkNames.end() ? name->second.c_str() : "array");
+        std::exit(1);
+    };
+    auto formatted = [&](const char *format, auto value) {
+        char buffer[512];
+        int length = std::snprintf(buffer, sizeof buffer, format, value);
+        if (length < static_cast<int>(sizeof buffer)) return newString(buffer, length);
+        std::string big(length + 1, '\0');
+        std::snprintf(&big[0], big.size(), format, value);
+        return newString(big.data(), length);
+    };
+
+#if defined(__GNUC__)
+    static void *const labels[] = {
+#define GZ_OPCODE_LABEL(name) &&op_##name,
+        GZ_OPCODES(GZ_OPCODE_LABEL)
+#undef GZ_OPCODE_LABEL
+    };
+#define DISPATCH() do { in = ip++; goto *labels[static_cast<uint16_t>(in->op)]; } while (0)
+#define CASE(name) op_##name:
+    DISPATCH();
+#else
+#define DISPATCH() goto dispatch
+#define CASE(name) case Op::name:
+dispatch:
+    in = ip++;
+    switch (in->op) {
+#endif
+
+    CASE(MOVE) r[in->a] = r[in->b]; DISPATCH();
+    CASE(LOADK) r[in->a] = constants[in->wide()]; DISPATCH();
+
+    // int wraps at 32 bits like the compiled i32 arithmetic
+#define INT_OP(name, expr) \
+    CASE(name) { uint64_t x = r[in->b].i, y = r[in->c].i; \
+                 r[in->a].i = static_cast<int32_t>(static_cast<uint32_t>(expr)); } DISPATCH();
+    INT_OP(ADD_I, x + y)
+    INT_OP(SUB_I, x - y)
+    INT_OP(MUL_I, x * y)
+#undef INT_OP
+    CASE(DIV_I) {
+        int64_t y = r[in->c].i;
+        if (y == 0) divisionByZero();
+        r[in->a].i = static_cast<int32_t>(static_cast<uint32_t>(r[in->b].i / y));
+    } DISPATCH();
+#define LONG_OP(name, expr) \
+    CASE(name) { uint64_t x = r[in->b].i, y = r[in->c].i; r[in->a].i = static_cast<int64_t>(expr); } DISPATCH();
+    LONG_OP(ADD_L, x + y)
+    LONG_OP(SUB_L, x - y)
+    LONG_OP(MUL_L, x * y)
+#undef LONG_OP
+    CASE(DIV_L) {
+        int64_t x = r[in->b].i, y = r[in->c].i;
+        if (y == 0) divisionByZero();
+        r[in->a].i = y == -1 ? static_cast<int64_t>(0 - static_cast<uint64_t>(x)) : x / y;
+    } DISPATCH();
+#define FLOAT_OP(name, op) \
+    CASE(name) r[in->a].f = static_cast<float>(r[in->b].f) op static_cast<float>(r[in->c].f); DISPATCH();
+    FLOAT_OP(ADD_F, +)
+    FLOAT_OP(SUB_F, -)
+    FLOAT_OP(MUL_F, *)
+    FLOAT_OP(DIV_F, /)
+#undef FLOAT_OP
+#define DOUBLE_OP(name, op) \
+    CASE(name) r[in->a].f = r[in->b].f op r[in->c].f; DISPATCH();
+    DOUBLE_OP(ADD_D, +)
+    DOUBLE_OP(SUB_D, -)
+    DOUBLE_OP(MUL_D, *)
+    DOUBLE_OP(DIV_D, /)
+#undef DOUBLE_OP
+
+#define COMPARE(name, field, op) \
+    CASE(name) r[in->a].i = r[in->b].field op r[in->c].field; DISPATCH();
+    COMPARE(EQ_L, i, ==)
+    COMPARE(NE_L, i, !=)
+    COMPARE(LT_L, i, <)
+    COMPARE(LE_L, i, <=)
+    COMPARE(GT_L, i, >)
+    COMPARE(GE_L, i, >=)
+    COMPARE(EQ_D, f, ==)
+    COMPARE(LT_D, f, <)
+    COMPARE(LE_D, f, <=)
+    COMPARE(GT_D, f, >)
+    COMPARE(GE_D, f, >=)
+#undef COMPARE
+    // Ordered, like fcmp one: false when either side is NaN
+    CASE(NE_D) r[in->a].i = r[in->b].f < r[in->c].f || r[in->b].f > r[in->c].f; DISPATCH();
+#define STRING_COMPARE(name, op) \
+    CASE(name) r[in->a].i = std::strcmp(r[in->b].s, r[in->c].s) op 0; DISPATCH();
+    STRING_COMPARE(EQ_S, ==)
+    STRING_COMPARE(NE_S, !=)
+    STRING_COMPARE(LT_S, <)
+    STRING_COMPARE(LE_S, <=)
+    STRING_COMPARE(GT_S, >)
+    STRING_COMPARE(GE_S, >=)
+#undef STRING_COMPARE
+
+    CASE(TRUTH_L) r[in->a].i = r[in->b].i != 0; DISPATCH();
+    CASE(TRUTH_D) r[in->a].i = r[in->b].f != 0.0; DISPATCH(); // NaN is true, like fcmp une
+    CASE(TO_I32) r[in->a].i = static_cast<int32_t>(static_cast<uint32_t>(r[in->b].i)); DISPATCH();
+    CASE(I2F) r[in->a].f = static_cast<float>(r[in->b].i); DISPATCH();
+    CASE(I2D) r[in->a].f = static_cast<double>(r[in->b].i); DISPATCH();
+    CASE(D2F) r[in->a].f = static_cast<float>(r[in->b].f); DISPATCH();
+    CASE(D2I) r[in->a].i = static_cast<int32_t>(r[in->b].f); DISPATCH();
+    CASE(D2L) r[in->a].i = static_cast<int64_t>(r[in->b].f); DISPATCH();
+
+    CASE(CONCAT) {
+        const char *x = r[in->b].s, *y = r[in->c].s;
+        size_t lx = std::strlen(x), ly = std::strlen(y);
+        strings.emplace_back(new char[lx + ly + 1]);
+        char *text = strings.back().get();
+        std::memcpy(text, x, lx);
+        std::memcpy(text + lx, y, ly + 1);
+        r[in->a].s = text;
+    } DISPATCH();
+    CASE(STR_L) r[in->a].s = formatted("%lld", static_cast<long long>(r[in->b].i)); DISPATCH();
+    CASE(STR_D) r[in->a].s = formatted("%f", r[in->b].f); DISPATCH();
+    CASE(STR_CHAR) {
+        const char *text = r[in->b].s;
+        uint64_t index = static_cast<uint64_t>(r[in->c].i);
+        if (index >= std::strlen(text)) boundsError(in);
+        r[in->a].i = static_cast<signed char>(text[index]);
+    } DISPATCH();
+
+    CASE(ARR_NEW) r[in->a].array = newArray(in->wide()); DISPATCH();
+    CASE(ARR_ALLOC) r[in->a].array = newArray(r[in->b].i); DISPATCH();
+    CASE(ARR_INIT) r[in->a].array->data[in->b] = r[in->c]; DISPATCH();
+    CASE(ARR_GET) {
+        const Array *array = r[in->b].array;
+        uint64_t index = static_cast<uint64_t>(r[in->c].i);
+        if (index >= static_cast<uint64_t>(array->length)) boundsError(in);
+        r[in->a] = array->data[index];
+    } DISPATCH();
+    CASE(ARR_SET) {
+        Array *array = r[in->a].array;
+        uint64_t index = static_cast<uint64_t>(r[in->b].i);
+        if (index >= static_cast<uint64_t>(array->length)) boundsError(in);
+        array->data[index] = r[in->c];
+    } DISPATCH();
+    CASE(ARR_LEN) r[in->a].i = r[in->b].array->length; DISPATCH();
+    CASE(SLICE) {
+        Array *array = r[in->b].array;
+        int64_t lo = r[in->c].i, hi = r[in->c + 1].i;
+        if (static_cast<uint64_t>(hi) > static_cast<uint64_t>(array->length) ||
+            static_cast<uint64_t>(lo) > static_cast<uint64_t>(hi)) {
+            boundsError(in);
+        }
+        r[in->a].array = newView(array->data + lo, hi - lo);
+    } DISPATCH();
+
+    CASE(SB_NEW) {
+        builders.push_back(std::make_unique<std::string>());
+        r[in->a].builder = builders.back().get();
+    } DISPATCH();
+    CASE(SB_APPEND_S) r[in->a].builder->append(r[in->b].s); DISPATCH();
+    CASE(SB_APPEND_L) {
+        char buffer[24];
+        int length = std::snprintf(buffer, sizeof buffer, "%lld", static_cast<long long>(r[in->b].i));
+        r[in->a].builder->append(buffer, length);
+    } DISPATCH();
+    CASE(SB_APPEND_D) r[in->a].builder->append(formatted("%f", r[in->b].f)); DISPATCH();
+    // toString hands the contents over and leaves the builder empty
+    CASE(SB_FINISH) {
+        std::string *text = r[in->b].builder;
+        r[in->a].s = newString(text->data(), text->size());
+        text->clear();
+    } DISPATCH();
+
+    CASE(READ_INT) r[in->a].i = static_cast<int32_t>(static_cast<uint32_t>(readInt())); DISPATCH();
+    CASE(READ_FLOAT) r[in->a].f = static_cast<float>(readFloat()); DISPATCH();
+    CASE(READ_LINE) {
+        std::string line;
+        int c;
+        while ((c = std::getchar()) != EOF && c != '\n') line += static_cast<char>(c);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        r[in->a].s = newString(line.data(), line.size());
+    } DISPATCH();
+    CASE(READ_FILE) {
+        const char *path = r[in->b].s;
+        FILE *file = std::fopen(path, "rb");
+        if (!file) {
+            std::fflush(stdout);
+            std::fprintf(stderr, "Error: no se puede abrir '%s'\n", path);
+            std::exit(1);
+        }
+        std::string contents;
+        char buffer[1 << 16];
+        size_t got;
+        while ((got = std::fread(buffer, 1, sizeof buffer, file)) > 0) contents.append(buffer, got);
+        std::fclose(file);
+        r[in->a].s = newString(contents.data(), contents.size());
+    } DISPATCH();
+
+    CASE(PRINT_L) std::printf("%lld\n", static_cast<long long>(r[in->a].i)); DISPATCH();
+    CASE(PRINT_D) std::printf("%f\n", r[in->a].f); DISPATCH();
+    CASE(PRINT_S) std::printf("%s\n", r[in->a].s); DISPATCH();
+    CASE(PRINT_C) std::printf("%c\n", static_cast<char>(r[in->a].i)); DISPATCH();
+    CASE(PRINT_ARR) {
+        const Array *array = r[in->a].array;
+        std::fputs("[", stdout);
+        for (int64_t i = 0; i < array->length; ++i) {
+            const Slot &element = array->data[i];
+            switch (in->b) {
+                case 0: std::printf("%lld ", static_cast<long long>(element.i)); break;
+                case 1: std::printf("%f ", element.f); break;
+                default: std::printf("%s ", element.s); break;
+            }
+        }
+        std::fputs("]\n", stdout);
+    } DISPATCH();
+
+    CASE(JMP) {
+        uint32_t target = in->wide();
+        if (target < static_cast<uint32_t>(in - code) && ++function->heat == JIT_THRESHOLD) {
+            requestJit(function); // a loop back-edge
+        }
+        ip = code + target;
+    } DISPATCH();
+    CASE(JMPF) if (!r[in->a].i) ip = code + in->wide(); DISPATCH();
+    CASE(JMPT) if (r[in->a].i) ip = code + in->wide(); DISPATCH();
+    CASE(CALL) {
+        Function *callee = functions[in->b].get();
+        if (NativeEntry native = callee->native.load(std::memory_order_acquire)) {
+            r[in->a].i = native(r + in->c);
+            DISPATCH();
+        }
+        if (++callee->heat == JIT_THRESHOLD) {
+            requestJit(callee);
+        }
+        Slot *frame = r + function->numRegisters;
+        if (frame + callee->numRegisters > stackEnd || frames.size() >= MAX_CALL_DEPTH) {
+            std::fflush(stdout);
+            std::cerr << "Error: desbordamiento de pila en '" << callee->name << "'\n";
+            std::exit(1);
+        }
+        for (uint16_t i = 0; i < callee->numParams; ++i) {
+            frame[i] = r[in->c + i];
+        }
+        frames.push_back({function, ip, r, in->a});
+        function = callee;
+        code = ip = function->code.data();
+        constants = function->constants.data();
+        r = frame;
+    } DISPATCH();
+    CASE(RET) result = r[in->a]; goto returning;
+    CASE(RETV) result.i = 0; goto returning;
+
+#if !defined(__GNUC__)
+    }
+#endif
+#undef DISPATCH
+#undef CASE
+
+returning:
+    if (frames.empty()) {
+        std::fflush(stdout);
+        return static_cast<int>(result.i);
+    }
+    {
+        const Frame &caller = frames.back();
+        function = caller.function;
+        code = function->code.data();
+        constants = function->constants.data();
+        ip = caller.resume;
+        r = caller.registers;
+        r[caller.result] = result;
+        frames.pop_back();
+    }
+#if defined(__GNUC__)
+    in = ip++;
+    goto *labels[static_cast<uint16_t>(in->op)];
+#else
+    goto dispatch;
+#endif
+}
@@ -0,0 +1,344 @@
+#include "../include/jit.h"
+#include <llvm/Config/llvm-config.h>
+#include <llvm/ExecutionEngine/ObjectCache.h>
+#include <llvm/ExecutionEngine/Orc/CompileUtils.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+// Tiered execution
+//
+// --jit runs the program on the bytecode interpreter, which counts calls
+// and loop back-edges per specialization. One that gets hot is handed to a
+// worker thread here: a fresh CodeGenerator emits that specialization (and
+// everything it calls) into its own module, the usual -O pipeline optimizes
+// it, and ORC's LLJIT turns it into machine code in this process. The
+// interpreter never waits; it keeps interpreting until the entry pointer is
+// published, and every call after that jumps to native code. A frame that
+// is already running stays interpreted (there is no on-stack replacement).
+//
+// The entry `<specialization>.jit` takes a pointer to the interpreter's
+// argument slots and returns the result as a slot, so one C signature
+// serves every function. Code that needs runtime/gozero_runtime.c (string
+// concatenation, comparisons, builders, ...) is left to the interpreter,
+// since that library is only linked into compiled programs; libc symbols
+// such as printf resolve to this process's.
+//
+// Machine code is kept across runs in an object cache on disk, so a script
+// run again gets its hot functions without optimizing or compiling them.
+
+namespace {
+
+// Interpreter slots: ints are sign-extended to 64 bits, bools are 0/1,
+// floats are widened to double and strings are the pointer itself
+llvm::Value* unpackSlot(llvm::IRBuilder<> &builder, llvm::Value *slot, llvm::Type *type) {
+    if (type->isFloatTy()) {
+        return builder.CreateFPTrunc(builder.CreateBitCast(slot, builder.getDoubleTy()), type, "slot_float");
+    }
+    if (type->isDoubleTy()) return builder.CreateBitCast(slot, type, "slot_double");
+    if (type->isPointerTy()) return builder.CreateIntToPtr(slot, type, "slot_str");
+    return builder.CreateTrunc(slot, type, "slot_int");
+}
+
+llvm::Value* packSlot(llvm::IRBuilder<> &builder, llvm::Value *value) {
+    llvm::Type *type = value->getType();
+    llvm::Type *i64 = builder.getInt64Ty();
+    if (type->isFloatTy()) {
+        value = builder.CreateFPExt(value, builder.getDoubleTy(), "result_double");
+        return builder.CreateBitCast(value, i64, "result_slot");
+    }
+    if (type->isDoubleTy()) return builder.CreateBitCast(value, i64, "result_slot");
+    if (type->isPointerTy()) return builder.CreatePtrToInt(value, i64, "result_slot");
+    if (type->isIntegerTy(1)) return builder.CreateZExt(value, i64, "result_slot");
+    return builder.CreateSExt(value, i64, "result_slot");
+}
+
+// One object file per module under $XDG_CACHE_HOME/gozero/jit (by default
+// ~/.cache/gozero/jit), named by a hash of the unoptimized IR together with
+// the -O level, the target CPU and features and the LLVM version. The key
+// is taken before optimizing, so a hit skips the optimizer as well as code
+// generation; it travels to the compile layer as the module identifier.
+class DiskObjectCache : public llvm::ObjectCache {
+public:
+    DiskObjectCache(std::string directory, std::string target)
+        : directory(std::move(directory)), target(std::move(target)) {}
+
+    // Name the module after its key; true if its object is already on disk
+    bool lookup(llvm::Module &module) {
+        std::string ir;
+        llvm::raw_string_ostream stream(ir);
+        module.print(stream, nullptr);
+        stream.flush();
+
+        llvm::MD5 hash;
+        hash.update(target);
+        hash.update(ir);
+        llvm::MD5::MD5Result result;
+        hash.final(result);
+        module.setModuleIdentifier(result.digest().str().str());
+        return llvm::sys::fs::exists(path(&module));
+    }
+
+    void notifyObjectCompiled(const llvm::Module *module, llvm::MemoryBufferRef object) override {
+        // Write to a temporary and rename it, so concurrent runs never see
+        // half an object. A failure only means no cache next time
+        int fd;
+        llvm::SmallString<128> temporary;
+        if (llvm::sys::fs::createUniqueFile(directory + "/%%%%%%%%.tmp", fd, temporary)) return;
+        llvm::raw_fd_ostream out(fd, /*shouldClose=*/true);
+        out << object.getBuffer();
+        out.close();
+        if (out.has_error()) {
+            out.clear_error();
+            llvm::sys::fs::remove(temporary);
+            return;
+        }
+        if (llvm::sys::fs::rename(temporary, path(module))) {
+            llvm::sys::fs::remove(temporary);
+        }
+    }
+
+    std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module *module) override {
+        auto buffer = llvm::MemoryBuffer::getFile(path(module));
+        if (!buffer) return nullptr;
+        return std::move(*buffer);
+    }
+
+private:
+    std::string directory;
+    std::string target; // everything besides the IR that changes the code
+
+    std::string path(const llvm::Module *module) const {
+        return directory + "/" + module->getModuleIdentifier() + ".o";
+    }
+};
+
+} // namespace
+
+llvm::Function* CodeGenerator::generateJitEntry(const FunctionStmt *stmt,
+                                                const std::vector<VarDeclStmt::Kind> &argKinds) {
+    llvm::Function *function = getSpecialization(stmt, argKinds);
+    if (usesRuntime) return nullptr;
+
+    llvm::Type *i64 = llvm::Type::getInt64Ty(context);
+    llvm::FunctionType *entryType = llvm::FunctionType::get(i64, {llvm::PointerType::getUnqual(i64)}, false);
+    llvm::Function *entry = llvm::Function::Create(entryType, llvm::Function::ExternalLinkage,
+                                                   function->getName() + ".jit", module.get());
+    llvm::IRBuilder<> entryBuilder(llvm::BasicBlock::Create(context, "entry", entry));
+    std::vector<llvm::Value*> args;
+    auto paramIt = function->arg_begin();
+    for (size_t i = 0; i < argKinds.size(); ++i, ++paramIt) {
+        llvm::Value *slotPtr = entryBuilder.CreateConstInBoundsGEP1_64(i64, entry->getArg(0), i, "arg_slot");
+        llvm::Value *slot = entryBuilder.CreateLoad(i64, slotPtr, stmt->params[i]);
+        args.push_back(unpackSlot(entryBuilder, slot, paramIt->getType()));
+    }
+    llvm::Value *result = entryBuilder.CreateCall(function, args);
+    if (function->getReturnType()->isVoidTy()) {
+        entryBuilder.CreateRet(entryBuilder.getInt64(0));
+    } else {
+        entryBuilder.CreateRet(packSlot(entryBuilder, result));
+    }
+
+    // Top-level code stays in the interpreter
+    builder.ClearInsertionPoint();
+    mainFunction->eraseFromParent();
+    mainFunction = nullptr;
+    return entry;
+}
+
+std::unique_ptr<llvm::Module> CodeGenerator::takeJitModule(llvm::Function *entry, llvm::TargetMachine *targetMachine,
+                                                           const std::function<bool(llvm::Module&)> &cached) {
+    // Every request gets a module of its own, so specializations compiled
+    // twice must not clash: only the entry is visible outside
+    for (llvm::Function &function : *module) {
+        if (!function.isDeclaration() && &function != entry) {
+            function.setLinkage(llvm::GlobalValue::InternalLinkage);
+        }
+    }
+    for (llvm::GlobalVariable &global : module->globals()) {
+        if (!global.isDeclaration() && !global.hasLocalLinkage()) {
+            global.setLinkage(llvm::GlobalValue::InternalLinkage);
+        }
+    }
+    module->setTargetTriple(targetMachine->getTargetTriple().str());
+    module->setDataLayout(targetMachine->createDataLayout());
+    if (!cached(*module)) {
+        optimizeModule(targetMachine);
+    }
+    return std::move(module);
+}
+
+struct JitCompiler::State {
+    struct Job {
+        const FunctionStmt *decl;
+        std::vector<VarDeclStmt::Kind> argKinds;
+        std::atomic<Entry> *entry;
+    };
+
+    std::vector<const FunctionStmt*> decls;
+    TypeAnalyzer &typeAnalyzer; // only the worker uses it once the program runs
+    int optLevel;
+    CodeGenerator::BoundsMode boundsMode;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Job> jobs;
+    bool stopping = false;
+    std::thread worker;
+
+    std::unique_ptr<llvm::TargetMachine> targetMachine;
+    std::unique_ptr<DiskObjectCache> cache; // null when it has no directory
+    std::unique_ptr<llvm::orc::LLJIT> jit;
+    bool unavailable = false; // the JIT could not start: everything stays interpreted
+
+    State(TypeAnalyzer &analyzer, int level, CodeGenerator::BoundsMode mode)
+        : typeAnalyzer(analyzer), optLevel(level), boundsMode(mode) {}
+
+    void run();
+    bool start();
+    void compile(const Job &job);
+    void warn(llvm::Error error);
+};
+
+void JitCompiler::State::warn(llvm::Error error) {
+    std::cerr << "Aviso: --jit: " << llvm::toString(std::move(error)) << "\n";
+}
+
+// LLVM is set up on the first request, on the worker thread
+bool JitCompiler::State::start() {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+
+    auto machineBuilder = llvm::orc::JITTargetMachineBuilder::detectHost();
+    if (!machineBuilder) {
+        warn(machineBuilder.takeError());
+        return false;
+    }
+    auto machine = machineBuilder->createTargetMachine();
+    if (!machine) {
+        warn(machine.takeError());
+        return false;
+    }
+    targetMachine = std::move(*machine);
+
+    llvm::orc::LLJITBuilder jitBuilder;
+    jitBuilder.setJITTargetMachineBuilder(std::move(*machineBuilder));
+    std::string directory = CodeGenerator::cacheDirectory();
+    if (!directory.empty() && !llvm::sys::fs::create_directories(directory += "/jit")) {
+        std::string target = targetMachine->getTargetTriple().str() + " " + targetMachine->getTargetCPU().str() + " "
+                             + targetMachine->getTargetFeatureString().str() + " -O" + std::to_string(optLevel)
+                             + " " LLVM_VERSION_STRING;
+        cache = std::make_unique<DiskObjectCache>(directory, target);
+        jitBuilder.setCompileFunctionCreator([this](llvm::orc::JITTargetMachineBuilder machineBuilder)
+                -> llvm::Expected<std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>> {
+            return std::make_unique<llvm::orc::ConcurrentIRCompiler>(std::move(machineBuilder), cache.get());
+        });
+    }
+
+    auto created = jitBuilder.create();
+    if (!created) {
+        warn(created.takeError());
+        return false;
+    }
+    jit = std::move(*created);
+
+    auto symbols = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+        jit->getDataLayout().getGlobalPrefix());
+    if (!symbols) {
+        warn(symbols.takeError());
+        return false;
+    }
+    jit->getMainJITDylib().addGenerator(std::move(*symbols));
+    return true;
+}
+
+void JitCompiler::State::compile(const Job &job) {
+    auto context = std::make_unique<llvm::LLVMContext>();
+    std::unique_ptr<llvm::Module> module;
+    std::string entryName;
+    {
+        CodeGenerator generator(*context, typeAnalyzer);
+        generator.setOptimizationLevel(optLevel);
+        generator.setBoundsMode(boundsMode);
+        for (const FunctionStmt *decl : decls) {
+            generator.generateFunction(decl);
+        }
+        llvm::Function *entry = generator.generateJitEntry(job.decl, job.argKinds);
+        if (!entry) return; // needs the runtime: stays interpreted
+        entryName = entry->getName().str();
+        module = generator.takeJitModule(entry, targetMachine.get(),
+                                         [this](llvm::Module &unoptimized) { return cache && cache->lookup(unoptimized); });
+    }
+
+    if (llvm::Error error = jit->addIRModule(llvm::orc::ThreadSafeModule(std::move(module), std::move(context)))) {
+        warn(std::move(error));
+        return;
+    }
+    auto symbol = jit->lookup(entryName);
+    if (!symbol) {
+        warn(symbol.takeError());
+        return;
+    }
+    job.entry->store(symbol->toPtr<Entry>(), std::memory_order_release);
+}
+
+void JitCompiler::State::run() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (stopping) return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        if (!jit && !unavailable) {
+            unavailable = !start();
+        }
+        if (!unavailable) {
+            compile(job);
+        }
+    }
+}
+
+JitCompiler::JitCompiler(const std::vector<StmtPtr> &program, TypeAnalyzer &analyzer, int optLevel,
+                         CodeGenerator::BoundsMode boundsMode)
+    : state(std::make_unique<State>(analyzer, optLevel, boundsMode)) {
+    for (const auto &stmt : program) {
+        if (auto *decl = dynamic_cast<const FunctionStmt*>(stmt.get())) {
+            state->decls.push_back(decl);
+        }
+    }
+}
+
+JitCompiler::~JitCompiler() {
+    if (!state->worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->stopping = true;
+    }
+    state->wake.notify_one();
+    state->worker.join();
+}
+
+void JitCompiler::request(const FunctionStmt *decl, const std::vector<VarDeclStmt::Kind> &argKinds,
+                          std::atomic<Entry> *entry) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (!state->worker.joinable()) {
+        state->worker = std::thread(&State::run, state.get());
+    }
+    state->jobs.push_back({decl, argKinds, entry});
+    state->wake.notify_one();
+}
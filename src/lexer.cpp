@@ -50,11 +50,24 @@ Token Lexer::lexIdentifier() {
     if (text == "int")    return Token(TokenType::INT, text, startLine, startColumn);
     if (text == "float")  return Token(TokenType::FLOAT, text, startLine, startColumn);
     if (text == "string") return Token(TokenType::STRING, text, startLine, startColumn);
+    if (text == "bool")   return Token(TokenType::BOOL, text, startLine, startColumn);
+    if (text == "int64")  return Token(TokenType::INT64, text, startLine, startColumn);
+    if (text == "double") return Token(TokenType::DOUBLE, text, startLine, startColumn);
+    if (text == "true")   return Token(TokenType::TRUE, text, startLine, startColumn);
+    if (text == "false")  return Token(TokenType::FALSE, text, startLine, startColumn);
     if (text == "print")  return Token(TokenType::PRINT, text, startLine, startColumn);
     if (text == "if")     return Token(TokenType::IF, text, startLine, startColumn);
     if (text == "else")   return Token(TokenType::ELSE, text, startLine, startColumn);
     if (text == "while")  return Token(TokenType::WHILE, text, startLine, startColumn);
     if (text == "for")    return Token(TokenType::FOR, text, startLine, startColumn);
+    if (text == "in")     return Token(TokenType::IN, text, startLine, startColumn);
+    if (text == "parallel") return Token(TokenType::PARALLEL, text, startLine, startColumn);
+    if (text == "go")     return Token(TokenType::GO, text, startLine, startColumn);
+    if (text == "chan")   return Token(TokenType::CHAN, text, startLine, startColumn);
+    if (text == "send")   return Token(TokenType::SEND, text, startLine, startColumn);
+    if (text == "recv")   return Token(TokenType::RECV, text, startLine, startColumn);
+    if (text == "close")  return Token(TokenType::CLOSE, text, startLine, startColumn);
+    if (text == "map")    return Token(TokenType::MAP, text, startLine, startColumn);
     if (text == "fun")    return Token(TokenType::FUN, text, startLine, startColumn);
     if (text == "return") return Token(TokenType::RETURN, text, startLine, startColumn);
     if (text == "void")   return Token(TokenType::VOID, text, startLine, startColumn);
@@ -75,12 +88,46 @@ Token Lexer::lexNumber() {
     return Token(TokenType::INT_LITERAL, src.substr(start, pos - start), startLine, startColumn);
 }
 
+// \$ is a literal '$' (so "\${" is not a hole); holes end at the '}' that
+// balances their '{', and a string inside a hole, holes and all, does not
+// end it or the string around it
+size_t Lexer::stringEnd(const std::string &text, size_t from) {
+    for (size_t i = from; i < text.size(); ++i) {
+        if (text[i] == '\\' && i + 1 < text.size() && text[i + 1] == '$') {
+            ++i;
+        } else if (text[i] == '"') {
+            return i;
+        } else if (text.compare(i, 2, "${") == 0) {
+            i = interpolationEnd(text, i + 2);
+            if (i == std::string::npos) return i;
+        }
+    }
+    return std::string::npos;
+}
+
+size_t Lexer::interpolationEnd(const std::string &text, size_t from) {
+    int depth = 0;
+    for (size_t i = from; i < text.size(); ++i) {
+        if (text[i] == '"') {
+            i = stringEnd(text, i + 1);
+            if (i == std::string::npos) return i;
+        } else if (text[i] == '{') {
+            ++depth;
+        } else if (text[i] == '}' && depth-- == 0) {
+            return i;
+        }
+    }
+    return std::string::npos;
+}
+
 Token Lexer::lexString() {
     int startLine = currentLine;
     int startColumn = currentColumn;
     advance(); // skip "
     size_t start = pos;
-    while (peek() && peek() != '"') advance();
+    size_t end = stringEnd(src, pos);
+    if (end == std::string::npos) end = src.size(); // unterminated: up to the end, as before
+    while (pos < end) advance();
     std::string text = src.substr(start, pos - start);
     if (peek() == '"') advance();
     return Token(TokenType::STRING_LITERAL, text, startLine, startColumn);
@@ -209,6 +256,11 @@ std::vector<Token> Lexer::tokenize() {
             advance();
             continue; 
         }
+        if (c == ':') {
+            tokens.emplace_back(TokenType::COLON, ":", currentLine, currentColumn);
+            advance();
+            continue;
+        }
         if (c == '(') { 
             tokens.emplace_back(TokenType::LPAREN, "(", currentLine, currentColumn);
             advance();
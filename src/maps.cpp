@@ -0,0 +1,137 @@
+#include "../include/code_generator.h"
+#include <iostream>
+#include <variant>
+#include <cstdlib>
+#include <cstdint>
+
+// Maps
+//
+// map[string]T is an opaque gz_map* from the runtime, a Swiss table (see
+// runtime/gozero_runtime.c). Values travel as 64-bit slots (toSlot/fromSlot)
+// and every operation passes the key together with its 64-bit hash. For
+// string literal keys the hash is computed here at compile time, so
+// m["total"] does no hashing at run time. A missing key reads as the zero
+// value of T.
+
+namespace {
+
+// Must match gz_str_hash in the runtime: FNV-1a finished with fmix64
+uint64_t hashString(const std::string &s) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : s) {
+        if (c == 0) break; // the runtime sees a C string
+        h ^= c;
+        h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+} // namespace
+
+llvm::Value* CodeGenerator::generateMap(const MapExpr *expr) {
+    llvm::Value *sizeHint = expr->sizeHint ? generateTyped(expr->sizeHint.get(), VarDeclStmt::INT64)
+                                           : builder.getInt64(0);
+    if (!sizeHint) return nullptr;
+    llvm::FunctionCallee newFunc = module->getOrInsertFunction(
+        "gz_map_new", llvm::FunctionType::get(getLLVMType(VarDeclStmt::MAP_INT),
+                                              {llvm::Type::getInt64Ty(context)}, false));
+    usesRuntime = true;
+    return builder.CreateCall(newFunc, {sizeHint}, "map");
+}
+
+std::pair<llvm::Value*, llvm::Value*> CodeGenerator::generateMapKey(const Expr *keyExpr) {
+    llvm::Value *key = generate(keyExpr);
+    if (!key) return {nullptr, nullptr};
+    if (auto *lit = dynamic_cast<const LiteralExpr*>(keyExpr)) {
+        if (std::holds_alternative<std::string>(lit->value)) {
+            return {key, builder.getInt64(hashString(std::get<std::string>(lit->value)))};
+        }
+    }
+    llvm::FunctionCallee hashFunc = module->getOrInsertFunction(
+        "gz_str_hash", llvm::FunctionType::get(llvm::Type::getInt64Ty(context), {key->getType()}, false));
+    return {key, builder.CreateCall(hashFunc, {key}, "key_hash")};
+}
+
+llvm::Value* CodeGenerator::generateMapGet(const IndexExpr *expr, VarDeclStmt::Kind mapKind) {
+    llvm::Value *map = generate(expr->array.get());
+    if (!map) return nullptr;
+    auto [key, hash] = generateMapKey(expr->index.get());
+    if (!key) return nullptr;
+
+    emitDebugLocation(expr->line, expr->column);
+    llvm::Type *i64 = llvm::Type::getInt64Ty(context);
+    llvm::FunctionCallee getFunc = module->getOrInsertFunction(
+        "gz_map_get", llvm::FunctionType::get(i64, {map->getType(), key->getType(), i64}, false));
+    usesRuntime = true;
+    llvm::Value *slot = builder.CreateCall(getFunc, {map, key, hash}, "map_slot");
+    return fromSlot(slot, TypeAnalyzer::elementType(mapKind));
+}
+
+void CodeGenerator::generateMapSet(const IndexAssignStmt *stmt, VarDeclStmt::Kind mapKind) {
+    llvm::AllocaInst *mapAlloca = findVariable(stmt->name);
+    if (!mapAlloca) return;
+    typeAnalyzer.mapKeyCheck(stmt->index.get(), stmt->line, stmt->column);
+    VarDeclStmt::Kind valueKind = TypeAnalyzer::elementType(mapKind);
+    if ((valueKind == VarDeclStmt::STRING) != (typeAnalyzer.inferType(stmt->expr.get()) == VarDeclStmt::STRING)) {
+        std::cerr << "Error (line " << stmt->line << ":" << stmt->column << "): el valor no es del tipo de los valores del map '"
+                  << stmt->name << "'\n";
+        std::exit(1);
+    }
+
+    auto [key, hash] = generateMapKey(stmt->index.get());
+    llvm::Value *value = generateTyped(stmt->expr.get(), valueKind);
+    if (!key || !value) return;
+    llvm::Value *map = builder.CreateLoad(mapAlloca->getAllocatedType(), mapAlloca, "map_load");
+
+    emitDebugLocation(stmt->line, stmt->column);
+    llvm::Type *i64 = llvm::Type::getInt64Ty(context);
+    llvm::FunctionCallee setFunc = module->getOrInsertFunction(
+        "gz_map_set", llvm::FunctionType::get(llvm::Type::getVoidTy(context),
+                                              {map->getType(), key->getType(), i64, i64}, false));
+    builder.CreateCall(setFunc, {map, key, hash, toSlot(value, valueKind)});
+    usesRuntime = true;
+}
+
+// has(m, k), delete(m, k) and len(m)
+llvm::Value* CodeGenerator::generateMapBuiltin(const CallExpr *call) {
+    llvm::Value *map = generate(call->args[0].get());
+    if (!map) return nullptr;
+    llvm::Type *i32 = llvm::Type::getInt32Ty(context);
+    llvm::Type *i64 = llvm::Type::getInt64Ty(context);
+    usesRuntime = true;
+
+    if (call->callee == "len") {
+        llvm::FunctionCallee lenFunc = module->getOrInsertFunction(
+            "gz_map_len", llvm::FunctionType::get(i64, {map->getType()}, false));
+        return builder.CreateTrunc(builder.CreateCall(lenFunc, {map}, "map_len"), i32, "map_len_i32");
+    }
+
+    auto [key, hash] = generateMapKey(call->args[1].get());
+    if (!key) return nullptr;
+    emitDebugLocation(call->line, call->column);
+    if (call->callee == "has") {
+        llvm::FunctionCallee hasFunc = module->getOrInsertFunction(
+            "gz_map_has", llvm::FunctionType::get(i32, {map->getType(), key->getType(), i64}, false));
+        llvm::Value *found = builder.CreateCall(hasFunc, {map, key, hash}, "map_has");
+        return builder.CreateICmpNE(found, builder.getInt32(0), "map_has_bool");
+    }
+    llvm::FunctionCallee deleteFunc = module->getOrInsertFunction(
+        "gz_map_delete", llvm::FunctionType::get(i32, {map->getType(), key->getType(), i64}, false));
+    builder.CreateCall(deleteFunc, {map, key, hash});
+    return nullptr;
+}
+
+// Store the key of the next live slot at or after `cursor` into keyOut and
+// return the cursor to continue from, or -1 when the map is exhausted
+llvm::Value* CodeGenerator::emitMapNext(llvm::Value *map, llvm::Value *cursor, llvm::Value *keyOut) {
+    llvm::Type *i64 = llvm::Type::getInt64Ty(context);
+    llvm::FunctionCallee nextFunc = module->getOrInsertFunction(
+        "gz_map_next", llvm::FunctionType::get(i64, {map->getType(), i64, keyOut->getType()}, false));
+    usesRuntime = true;
+    return builder.CreateCall(nextFunc, {map, cursor, keyOut}, "map_next");
+}
@@ -0,0 +1,265 @@
+#include "../include/code_generator.h"
+#include <iostream>
+#include <cstdlib>
+
+// parallel for (i := a; i < b; ++i) { ... }
+//
+// The body is outlined into `void parallel_for.body(i8* ctx, i64 lo, i64 hi)`,
+// which runs iterations [lo, hi) in order. The variables the body reads from
+// the enclosing scopes are copied into a context struct before the loop:
+// scalars are read-only inside the body (TypeAnalyzer::validateParallelBody),
+// and arrays are captured as their element pointer, so element stores land in
+// the caller's array. The runtime (gz_parallel_for in runtime/gozero_runtime.c)
+// splits [a, b) into chunks over a work-stealing thread pool and returns once
+// every iteration has run. Each call of the outlined body has its own frame,
+// so variables declared in the body are private to the iteration.
+
+namespace {
+
+void collectExprNames(const Expr *expr, std::set<std::string> &names);
+
+void collectStmtNames(const Stmt *stmt, std::set<std::string> &names) {
+    if (!stmt) return;
+    if (auto *varDecl = dynamic_cast<const VarDeclStmt*>(stmt)) {
+        collectExprNames(varDecl->init.get(), names);
+    } else if (auto *inferDecl = dynamic_cast<const InferDeclStmt*>(stmt)) {
+        collectExprNames(inferDecl->init.get(), names);
+    } else if (auto *assign = dynamic_cast<const AssignStmt*>(stmt)) {
+        names.insert(assign->name);
+        collectExprNames(assign->expr.get(), names);
+    } else if (auto *indexAssign = dynamic_cast<const IndexAssignStmt*>(stmt)) {
+        names.insert(indexAssign->name);
+        collectExprNames(indexAssign->index.get(), names);
+        collectExprNames(indexAssign->expr.get(), names);
+    } else if (auto *print = dynamic_cast<const PrintStmt*>(stmt)) {
+        collectExprNames(print->expr.get(), names);
+    } else if (auto *exprStmt = dynamic_cast<const ExprStmt*>(stmt)) {
+        collectExprNames(exprStmt->expr.get(), names);
+    } else if (auto *goStmt = dynamic_cast<const GoStmt*>(stmt)) {
+        collectExprNames(goStmt->call.get(), names);
+    } else if (auto *send = dynamic_cast<const SendStmt*>(stmt)) {
+        collectExprNames(send->chan.get(), names);
+        collectExprNames(send->value.get(), names);
+    } else if (auto *closeStmt = dynamic_cast<const CloseStmt*>(stmt)) {
+        collectExprNames(closeStmt->chan.get(), names);
+    } else if (auto *ifStmt = dynamic_cast<const IfStmt*>(stmt)) {
+        collectExprNames(ifStmt->cond.get(), names);
+        for (const auto &s : ifStmt->thenBranch) collectStmtNames(s.get(), names);
+        for (const auto &s : ifStmt->elseBranch) collectStmtNames(s.get(), names);
+    } else if (auto *whileStmt = dynamic_cast<const WhileStmt*>(stmt)) {
+        collectExprNames(whileStmt->cond.get(), names);
+        for (const auto &s : whileStmt->body) collectStmtNames(s.get(), names);
+    } else if (auto *forStmt = dynamic_cast<const ForStmt*>(stmt)) {
+        collectStmtNames(forStmt->init.get(), names);
+        collectExprNames(forStmt->cond.get(), names);
+        collectStmtNames(forStmt->post.get(), names);
+        for (const auto &s : forStmt->body) collectStmtNames(s.get(), names);
+    } else if (auto *forIn = dynamic_cast<const ForInStmt*>(stmt)) {
+        collectExprNames(forIn->iterable.get(), names);
+        for (const auto &s : forIn->body) collectStmtNames(s.get(), names);
+    }
+}
+
+void collectExprNames(const Expr *expr, std::set<std::string> &names) {
+    if (!expr) return;
+    if (auto *var = dynamic_cast<const VarExpr*>(expr)) {
+        names.insert(var->name);
+    } else if (auto *bin = dynamic_cast<const BinaryExpr*>(expr)) {
+        collectExprNames(bin->left.get(), names);
+        collectExprNames(bin->right.get(), names);
+    } else if (auto *unary = dynamic_cast<const UnaryExpr*>(expr)) {
+        names.insert(unary->varName);
+    } else if (auto *array = dynamic_cast<const ArrayExpr*>(expr)) {
+        for (const auto &elem : array->elements) collectExprNames(elem.get(), names);
+    } else if (auto *index = dynamic_cast<const IndexExpr*>(expr)) {
+        collectExprNames(index->array.get(), names);
+        collectExprNames(index->index.get(), names);
+    } else if (auto *slice = dynamic_cast<const SliceExpr*>(expr)) {
+        collectExprNames(slice->array.get(), names);
+        collectExprNames(slice->lo.get(), names);
+        collectExprNames(slice->hi.get(), names);
+    } else if (auto *call = dynamic_cast<const CallExpr*>(expr)) {
+        for (const auto &arg : call->args) collectExprNames(arg.get(), names);
+    } else if (auto *chan = dynamic_cast<const ChanExpr*>(expr)) {
+        collectExprNames(chan->capacity.get(), names);
+    } else if (auto *map = dynamic_cast<const MapExpr*>(expr)) {
+        collectExprNames(map->sizeHint.get(), names);
+    } else if (auto *recv = dynamic_cast<const RecvExpr*>(expr)) {
+        if (!recv->target.empty()) names.insert(recv->target);
+        collectExprNames(recv->chan.get(), names);
+    } else if (auto *interp = dynamic_cast<const InterpExpr*>(expr)) {
+        for (const auto &hole : interp->holes) collectExprNames(hole.get(), names);
+    }
+}
+
+} // namespace
+
+void CodeGenerator::generateParallelFor(const ForStmt *stmt) {
+    typeAnalyzer.validateParallelBody(stmt);
+
+    typeAnalyzer.pushScope(); // parallel for scope (holds the index)
+    pushScope();
+    if (stmt->init) {
+        generateStatement(stmt->init.get());
+    }
+
+    // Only canonical counting loops can be split into independent ranges
+    std::string indexVar;
+    const Expr *bound = nullptr;
+    bool inclusive = false;
+    const Expr *lowerBound = nullptr;
+    std::string initName;
+    if (auto *inferDecl = dynamic_cast<const InferDeclStmt*>(stmt->init.get())) {
+        initName = inferDecl->name;
+        lowerBound = inferDecl->init.get();
+    } else if (auto *varDecl = dynamic_cast<const VarDeclStmt*>(stmt->init.get())) {
+        initName = varDecl->name;
+        lowerBound = varDecl->init.get();
+    }
+    if (!lowerBound || !stmt->cond ||
+        !matchCountingLoop(stmt->cond.get(), stmt->post.get(), indexVar, bound, inclusive) ||
+        initName != indexVar) {
+        std::cerr << "Error (line " << stmt->line << ":" << stmt->column
+                  << "): parallel for requiere la forma (i := inicio; i < fin; ++i) con i de tipo int\n";
+        std::exit(1);
+    }
+
+    // Range checks are hoisted here, before any worker starts
+    auto savedProvenIndexes = provenIndexes;
+    proveLoopIndexes(indexVar, lowerBound, bound, inclusive, stmt->body, nullptr);
+
+    llvm::Type *i64 = llvm::Type::getInt64Ty(context);
+    llvm::Type *i8Ptr = llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context));
+    llvm::AllocaInst *indexAlloca = findVariable(indexVar);
+    llvm::Value *lo = builder.CreateSExt(
+        builder.CreateLoad(indexAlloca->getAllocatedType(), indexAlloca, "parallel_lo"), i64, "parallel_lo64");
+    llvm::Value *hi = generateTyped(bound, VarDeclStmt::INT);
+    if (!hi) return;
+    hi = builder.CreateSExt(hi, i64, "parallel_hi64");
+    if (inclusive) {
+        hi = builder.CreateAdd(hi, llvm::ConstantInt::get(i64, 1), "parallel_hi_incl");
+    }
+
+    if (instrument) {
+        size_t profileSite = createLoopProfileSite("parallel for", stmt->line, stmt->column);
+        incrementProfileCounter(profileSites[profileSite].counters[0]);
+        llvm::Value *trips = builder.CreateSelect(builder.CreateICmpSLT(lo, hi), builder.CreateSub(hi, lo),
+                                                  llvm::ConstantInt::get(i64, 0), "parallel_trips");
+        incrementProfileCounter(profileSites[profileSite].counters[1], trips);
+    }
+
+    // Capture every enclosing variable the body mentions (by value)
+    std::set<std::string> names;
+    for (const auto &bodyStmt : stmt->body) {
+        collectStmtNames(bodyStmt.get(), names);
+    }
+    struct Capture {
+        std::string name;
+        llvm::AllocaInst *alloca;
+        bool hasLength; // runtime-length array: its i64 length follows
+    };
+    std::vector<Capture> captures;
+    std::vector<llvm::Type*> fieldTypes;
+    for (const auto &name : names) {
+        if (name == indexVar) continue;
+        llvm::AllocaInst *alloca = findVariable(name);
+        if (!alloca) continue;
+        bool hasLength = arrayLengths.count(name) > 0;
+        captures.push_back({name, alloca, hasLength});
+        fieldTypes.push_back(alloca->getAllocatedType());
+        if (hasLength) fieldTypes.push_back(i64);
+    }
+    llvm::StructType *ctxType = llvm::StructType::get(context, fieldTypes);
+    llvm::AllocaInst *ctxAlloca = createEntryBlockAlloca("parallel_ctx", ctxType);
+    unsigned field = 0;
+    for (const auto &capture : captures) {
+        llvm::Value *value = builder.CreateLoad(capture.alloca->getAllocatedType(), capture.alloca, capture.name);
+        builder.CreateStore(value, builder.CreateStructGEP(ctxType, ctxAlloca, field++));
+        if (capture.hasLength) {
+            llvm::AllocaInst *lenAlloca = arrayLengths[capture.name];
+            llvm::Value *length = builder.CreateLoad(i64, lenAlloca, capture.name + "_len");
+            builder.CreateStore(length, builder.CreateStructGEP(ctxType, ctxAlloca, field++));
+        }
+    }
+
+    // Outline the body
+    llvm::FunctionType *bodyType = llvm::FunctionType::get(llvm::Type::getVoidTy(context), {i8Ptr, i64, i64}, false);
+    llvm::Function *bodyFunction = llvm::Function::Create(bodyType, llvm::Function::InternalLinkage,
+                                                          "parallel_for.body", module.get());
+    auto argIt = bodyFunction->arg_begin();
+    llvm::Value *ctxArg = &*argIt++;
+    llvm::Value *loArg = &*argIt++;
+    llvm::Value *hiArg = &*argIt;
+    ctxArg->setName("ctx");
+    loArg->setName("lo");
+    hiArg->setName("hi");
+
+    llvm::IRBuilderBase::InsertPoint oldInsertPoint = builder.saveIP();
+    llvm::Function *oldFunction = currentFunction;
+    llvm::DebugLoc oldDebugLoc = builder.getCurrentDebugLocation();
+    auto oldNamedValuesStack = std::move(namedValuesStack);
+    auto oldVariableTypes = variableTypes;
+    auto oldArraySizes = arraySizes;
+    auto oldArrayLengths = arrayLengths;
+    namedValuesStack.clear();
+
+    builder.SetInsertPoint(llvm::BasicBlock::Create(context, "entry", bodyFunction));
+    currentFunction = bodyFunction;
+    if (diBuilder) {
+        createDebugFunction(bodyFunction, "parallel_for", stmt->line, VarDeclStmt::VOID, {});
+    }
+    emitDebugLocation(stmt->line, stmt->column);
+    pushScope();
+
+    llvm::Value *ctx = builder.CreatePointerCast(ctxArg, llvm::PointerType::getUnqual(ctxType), "ctx_struct");
+    field = 0;
+    for (const auto &capture : captures) {
+        llvm::Type *type = capture.alloca->getAllocatedType();
+        llvm::AllocaInst *local = createEntryBlockAlloca(capture.name, type);
+        builder.CreateStore(builder.CreateLoad(type, builder.CreateStructGEP(ctxType, ctx, field++)), local);
+        declareVariable(capture.name, local);
+        if (capture.hasLength) {
+            llvm::AllocaInst *lenLocal = createEntryBlockAlloca(capture.name + ".len", i64);
+            builder.CreateStore(builder.CreateLoad(i64, builder.CreateStructGEP(ctxType, ctx, field++)), lenLocal);
+            arrayLengths[capture.name] = lenLocal;
+        }
+    }
+    llvm::AllocaInst *localIndex = createEntryBlockAlloca(indexVar, indexAlloca->getAllocatedType());
+    declareVariable(indexVar, localIndex);
+
+    llvm::Type *i32 = llvm::Type::getInt32Ty(context);
+    llvm::Value *first = builder.CreateTrunc(loArg, i32, "first");
+    llvm::Value *count = builder.CreateTrunc(builder.CreateSub(hiArg, loArg), i32, "count");
+    emitCountedLoop(count, "parallel", [&](llvm::Value *offset) {
+        builder.CreateStore(builder.CreateAdd(first, offset, indexVar), localIndex);
+        typeAnalyzer.pushScope();
+        pushScope();
+        for (const auto &bodyStmt : stmt->body) {
+            generateStatement(bodyStmt.get());
+        }
+        popScope();
+        typeAnalyzer.popScope();
+    });
+    builder.CreateRetVoid();
+
+    popScope();
+    currentFunction = oldFunction;
+    namedValuesStack = std::move(oldNamedValuesStack);
+    variableTypes = std::move(oldVariableTypes);
+    arraySizes = std::move(oldArraySizes);
+    arrayLengths = std::move(oldArrayLengths);
+    builder.restoreIP(oldInsertPoint);
+    builder.SetCurrentDebugLocation(oldDebugLoc);
+
+    // gz_parallel_for(body, ctx, lo, hi) returns after the last iteration
+    llvm::FunctionCallee parallelFor = module->getOrInsertFunction(
+        "gz_parallel_for",
+        llvm::FunctionType::get(llvm::Type::getVoidTy(context),
+                                {llvm::PointerType::getUnqual(bodyType), i8Ptr, i64, i64}, false));
+    builder.CreateCall(parallelFor, {bodyFunction, builder.CreatePointerCast(ctxAlloca, i8Ptr, "ctx"), lo, hi});
+    usesRuntime = true;
+
+    provenIndexes = savedProvenIndexes;
+    popScope();
+    typeAnalyzer.popScope(); // End parallel for scope
+}
@@ -1,6 +1,9 @@
 #include "../include/parser.h"
+#include "../include/lexer.h"
+#include "../include/type_analyzer.h"
 #include <iostream>
 #include <cstdlib>
+#include <cstdint>
 
 Parser::Parser(const std::vector<Token> &toks) : tokens(toks) {}
 
@@ -31,6 +34,49 @@ void Parser::expect(TokenType t, const std::string &msg) {
     }
 }
 
+bool Parser::isTypeKeyword(TokenType t) {
+    return t == TokenType::INT || t == TokenType::FLOAT || t == TokenType::STRING ||
+           t == TokenType::BOOL || t == TokenType::INT64 || t == TokenType::DOUBLE;
+}
+
+VarDeclStmt::Kind Parser::typeKeywordKind(TokenType t) {
+    switch (t) {
+        case TokenType::INT: return VarDeclStmt::INT;
+        case TokenType::FLOAT: return VarDeclStmt::FLOAT;
+        case TokenType::STRING: return VarDeclStmt::STRING;
+        case TokenType::BOOL: return VarDeclStmt::BOOL;
+        case TokenType::INT64: return VarDeclStmt::INT64;
+        case TokenType::DOUBLE: return VarDeclStmt::DOUBLE;
+        default: return VarDeclStmt::VOID;
+    }
+}
+
+VarDeclStmt::Kind Parser::parseChanElementType() {
+    if (!isTypeKeyword(peek().type)) {
+        std::cerr << "Parse error: se esperaba el tipo de los elementos tras 'chan' en '" << peek().lexeme << "'\n";
+        std::exit(1);
+    }
+    VarDeclStmt::Kind elemKind = typeKeywordKind(advance().type);
+    TypeAnalyzer::chanTypeOf(elemKind); // reject unsupported element kinds early
+    return elemKind;
+}
+
+VarDeclStmt::Kind Parser::parseMapValueType() {
+    expect(TokenType::LBRACKET, "se esperaba '[' tras 'map'");
+    if (!match(TokenType::STRING)) {
+        std::cerr << "Parse error: las claves de un map deben ser string en '" << peek().lexeme << "'\n";
+        std::exit(1);
+    }
+    expect(TokenType::RBRACKET, "se esperaba ']'");
+    if (!isTypeKeyword(peek().type)) {
+        std::cerr << "Parse error: se esperaba el tipo de los valores del map en '" << peek().lexeme << "'\n";
+        std::exit(1);
+    }
+    VarDeclStmt::Kind valueKind = typeKeywordKind(advance().type);
+    TypeAnalyzer::mapTypeOf(valueKind); // reject unsupported value kinds early
+    return valueKind;
+}
+
 ExprPtr Parser::parseExpression() {
     return parseOr();
 }
@@ -38,8 +84,9 @@ ExprPtr Parser::parseExpression() {
 ExprPtr Parser::parseOr() {
     ExprPtr expr = parseAnd();
     while (match(TokenType::OR)) {
+        Token opToken = tokens[pos-1];
         ExprPtr right = parseAnd();
-        expr = std::make_unique<BinaryExpr>(BinaryExpr::Op::OR, std::move(expr), std::move(right));
+        expr = at(std::make_unique<BinaryExpr>(BinaryExpr::Op::OR, std::move(expr), std::move(right)), opToken);
     }
     return expr;
 }
@@ -47,8 +94,9 @@ ExprPtr Parser::parseOr() {
 ExprPtr Parser::parseAnd() {
     ExprPtr expr = parseEquality();
     while (match(TokenType::AND)) {
+        Token opToken = tokens[pos-1];
         ExprPtr right = parseEquality();
-        expr = std::make_unique<BinaryExpr>(BinaryExpr::Op::AND, std::move(expr), std::move(right));
+        expr = at(std::make_unique<BinaryExpr>(BinaryExpr::Op::AND, std::move(expr), std::move(right)), opToken);
     }
     return expr;
 }
@@ -57,11 +105,13 @@ ExprPtr Parser::parseEquality() {
     ExprPtr expr = parseRelational();
     while (true) {
         if (match(TokenType::EQ)) {
+            Token opToken = tokens[pos-1];
             ExprPtr right = parseRelational();
-            expr = std::make_unique<BinaryExpr>(BinaryExpr::Op::EQ, std::move(expr), std::move(right));
+            expr = at(std::make_unique<BinaryExpr>(BinaryExpr::Op::EQ, std::move(expr), std::move(right)), opToken);
         } else if (match(TokenType::NEQ)) {
+            Token opToken = tokens[pos-1];
             ExprPtr right = parseRelational();
-            expr = std::make_unique<BinaryExpr>(BinaryExpr::Op::NEQ, std::move(expr), std::move(right));
+            expr = at(std::make_unique<BinaryExpr>(BinaryExpr::Op::NEQ, std::move(expr), std::move(right)), opToken);
         } else break;
     }
     return expr;
@@ -71,17 +121,21 @@ ExprPtr Parser::parseRelational() {
     ExprPtr expr = parseAddSub();
     while (true) {
         if (match(TokenType::LT)) {
+            Token opToken = tokens[pos-1];
             ExprPtr right = parseAddSub();
-            expr = std::make_unique<BinaryExpr>(BinaryExpr::Op::LT, std::move(expr), std::move(right));
+            expr = at(std::make_unique<BinaryExpr>(BinaryExpr::Op::LT, std::move(expr), std::move(right)), opToken);
         } else if (match(TokenType::LE)) {
+            Token opToken = tokens[pos-1];
             ExprPtr right = parseAddSub();
-            expr = std::make_unique<BinaryExpr>(BinaryExpr::Op::LE, std::move(expr), std::move(right));
+            expr = at(std::make_unique<BinaryExpr>(BinaryExpr::Op::LE, std::move(expr), std::move(right)), opToken);
         } else if (match(TokenType::GT)) {
+            Token opToken = tokens[pos-1];
             ExprPtr right = parseAddSub();
-            expr = std::make_unique<BinaryExpr>(BinaryExpr::Op::GT, std::move(expr), std::move(right));
+            expr = at(std::make_unique<BinaryExpr>(BinaryExpr::Op::GT, std::move(expr), std::move(right)), opToken);
         } else if (match(TokenType::GE)) {
+            Token opToken = tokens[pos-1];
             ExprPtr right = parseAddSub();
-            expr = std::make_unique<BinaryExpr>(BinaryExpr::Op::GE, std::move(expr), std::move(right));
+            expr = at(std::make_unique<BinaryExpr>(BinaryExpr::Op::GE, std::move(expr), std::move(right)), opToken);
         } else break;
     }
     return expr;
@@ -91,11 +145,13 @@ ExprPtr Parser::parseAddSub() {
     ExprPtr expr = parseMulDiv();
     while (true) {
         if (match(TokenType::PLUS)) {
+            Token opToken = tokens[pos-1];
             ExprPtr right = parseMulDiv();
-            expr = std::make_unique<BinaryExpr>(BinaryExpr::Op::ADD, std::move(expr), std::move(right));
+            expr = at(std::make_unique<BinaryExpr>(BinaryExpr::Op::ADD, std::move(expr), std::move(right)), opToken);
         } else if (match(TokenType::MINUS)) {
+            Token opToken = tokens[pos-1];
             ExprPtr right = parseMulDiv();
-            expr = std::make_unique<BinaryExpr>(BinaryExpr::Op::SUB, std::move(expr), std::move(right));
+            expr = at(std::make_unique<BinaryExpr>(BinaryExpr::Op::SUB, std::move(expr), std::move(right)), opToken);
         } else break;
     }
     return expr;
@@ -105,11 +161,13 @@ ExprPtr Parser::parseMulDiv() {
     ExprPtr expr = parseUnary();
     while (true) {
         if (match(TokenType::MUL)) {
+            Token opToken = tokens[pos-1];
             ExprPtr right = parseUnary();
-            expr = std::make_unique<BinaryExpr>(BinaryExpr::Op::MUL, std::move(expr), std::move(right));
+            expr = at(std::make_unique<BinaryExpr>(BinaryExpr::Op::MUL, std::move(expr), std::move(right)), opToken);
         } else if (match(TokenType::DIV)) {
+            Token opToken = tokens[pos-1];
             ExprPtr right = parseUnary();
-            expr = std::make_unique<BinaryExpr>(BinaryExpr::Op::DIV, std::move(expr), std::move(right));
+            expr = at(std::make_unique<BinaryExpr>(BinaryExpr::Op::DIV, std::move(expr), std::move(right)), opToken);
         } else break;
     }
     return expr;
@@ -117,25 +175,40 @@ ExprPtr Parser::parseMulDiv() {
 
 ExprPtr Parser::parseUnary() {
     if (match(TokenType::INCREMENT)) {
+        Token opToken = tokens[pos-1];
         expect(TokenType::IDENT, "se esperaba identificador después de ++");
         std::string varName = tokens[pos-1].lexeme;
-        return std::make_unique<UnaryExpr>(UnaryExpr::Op::PRE_INC, varName);
+        return at(std::make_unique<UnaryExpr>(UnaryExpr::Op::PRE_INC, varName), opToken);
     }
     if (match(TokenType::DECREMENT)) {
+        Token opToken = tokens[pos-1];
         expect(TokenType::IDENT, "se esperaba identificador después de --");
         std::string varName = tokens[pos-1].lexeme;
-        return std::make_unique<UnaryExpr>(UnaryExpr::Op::PRE_DEC, varName);
+        return at(std::make_unique<UnaryExpr>(UnaryExpr::Op::PRE_DEC, varName), opToken);
     }
     return parsePrimary();
 }
 
 ExprPtr Parser::parsePrimary() {
-    if (match(TokenType::INT_LITERAL))
-        return std::make_unique<LiteralExpr>(std::stoi(tokens[pos-1].lexeme));
+    if (match(TokenType::INT_LITERAL)) {
+        // Literals that do not fit in 32 bits are int64
+        long long value = std::stoll(tokens[pos-1].lexeme);
+        if (value > INT32_MAX) {
+            return at(std::make_unique<LiteralExpr>(value), tokens[pos-1]);
+        }
+        return at(std::make_unique<LiteralExpr>(static_cast<int>(value)), tokens[pos-1]);
+    }
     if (match(TokenType::FLOAT_LITERAL))
-        return std::make_unique<LiteralExpr>(std::stof(tokens[pos-1].lexeme));
-    if (match(TokenType::STRING_LITERAL))
-        return std::make_unique<LiteralExpr>(tokens[pos-1].lexeme);
+        return at(std::make_unique<LiteralExpr>(std::stod(tokens[pos-1].lexeme)), tokens[pos-1]);
+    if (match(TokenType::STRING_LITERAL)) {
+        const std::string &text = tokens[pos-1].lexeme;
+        if (text.find("${") != std::string::npos || text.find("\\$") != std::string::npos) {
+            return parseInterpolation(tokens[pos-1]);
+        }
+        return at(std::make_unique<LiteralExpr>(tokens[pos-1].lexeme), tokens[pos-1]);
+    }
+    if (match(TokenType::TRUE) || match(TokenType::FALSE))
+        return at(std::make_unique<LiteralExpr>(tokens[pos-1].type == TokenType::TRUE), tokens[pos-1]);
     if (match(TokenType::IDENT)) {
         Token identToken = tokens[pos-1];
         std::string name = identToken.lexeme;
@@ -148,15 +221,22 @@ ExprPtr Parser::parsePrimary() {
                 } while (match(TokenType::COMMA));
                 expect(TokenType::RPAREN, "se esperaba ')'");
             }
-            return std::make_unique<CallExpr>(name, std::move(args));
+            return at(std::make_unique<CallExpr>(name, std::move(args)), identToken);
         }
-        // Check for array indexing
+        // Check for array indexing or slicing
         if (match(TokenType::LBRACKET)) {
-            ExprPtr index = parseExpression();
+            ExprPtr index = check(TokenType::COLON) ? nullptr : parseExpression();
+            if (match(TokenType::COLON)) {
+                ExprPtr hi = check(TokenType::RBRACKET) ? nullptr : parseExpression();
+                expect(TokenType::RBRACKET, "se esperaba ']'");
+                return at(std::make_unique<SliceExpr>(
+                    std::make_unique<VarExpr>(name, identToken.line, identToken.column),
+                    std::move(index), std::move(hi)), identToken);
+            }
             expect(TokenType::RBRACKET, "se esperaba ']'");
-            return std::make_unique<IndexExpr>(
+            return at(std::make_unique<IndexExpr>(
                 std::make_unique<VarExpr>(name, identToken.line, identToken.column), 
-                std::move(index));
+                std::move(index)), identToken);
         }
         return std::make_unique<VarExpr>(name, identToken.line, identToken.column);
     }
@@ -165,8 +245,40 @@ ExprPtr Parser::parsePrimary() {
         expect(TokenType::RPAREN, "se esperaba ')'");
         return e;
     }
+    // chan T(capacity)
+    if (match(TokenType::CHAN)) {
+        Token chanToken = tokens[pos-1];
+        VarDeclStmt::Kind elemKind = parseChanElementType();
+        expect(TokenType::LPAREN, "se esperaba '(' con la capacidad del canal");
+        ExprPtr capacity = parseExpression();
+        expect(TokenType::RPAREN, "se esperaba ')'");
+        return at(std::make_unique<ChanExpr>(elemKind, std::move(capacity)), chanToken);
+    }
+    // map[string]T() or map[string]T(hint)
+    if (match(TokenType::MAP)) {
+        Token mapToken = tokens[pos-1];
+        VarDeclStmt::Kind valueKind = parseMapValueType();
+        expect(TokenType::LPAREN, "se esperaba '(' tras el tipo del map");
+        ExprPtr sizeHint = check(TokenType::RPAREN) ? nullptr : parseExpression();
+        expect(TokenType::RPAREN, "se esperaba ')'");
+        return at(std::make_unique<MapExpr>(valueKind, std::move(sizeHint)), mapToken);
+    }
+    // recv(c) or recv(c, x)
+    if (match(TokenType::RECV)) {
+        Token recvToken = tokens[pos-1];
+        expect(TokenType::LPAREN, "se esperaba '(' tras recv");
+        ExprPtr chan = parseExpression();
+        std::string target;
+        if (match(TokenType::COMMA)) {
+            expect(TokenType::IDENT, "se esperaba una variable en recv(canal, variable)");
+            target = tokens[pos-1].lexeme;
+        }
+        expect(TokenType::RPAREN, "se esperaba ')'");
+        return at(std::make_unique<RecvExpr>(std::move(chan), target), recvToken);
+    }
     if (match(TokenType::LBRACKET)) {
-        return parseArray();
+        Token bracketToken = tokens[pos-1];
+        return at(parseArray(), bracketToken);
     }
     std::cerr << "Parse error: expresión inesperada\n";
     std::exit(1);
@@ -193,6 +305,63 @@ ExprPtr Parser::parseArray() {
     return std::make_unique<ArrayExpr>(std::move(elements));
 }
 
+// "x=${x} y=${y}": the text is split here into literal segments and the
+// expressions inside ${...}, each lexed and parsed on its own. The tokens of
+// a hole are moved to where it sits in the source, so errors point there.
+// \$ stands for a literal '$'; a string left without holes is a plain literal.
+ExprPtr Parser::parseInterpolation(const Token &stringToken) {
+    const std::string &text = stringToken.lexeme;
+    auto interp = at(std::make_unique<InterpExpr>(), stringToken);
+    std::string segment;
+    int line = stringToken.line;
+    int column = stringToken.column + 1; // of text[i], past the opening quote
+    size_t i = 0;
+    auto step = [&](size_t to) {
+        for (; i < to; ++i) {
+            if (text[i] == '\n') { ++line; column = 1; } else { ++column; }
+        }
+    };
+
+    while (i < text.size()) {
+        if (text.compare(i, 2, "\\$") == 0) {
+            segment += '$';
+            step(i + 2);
+            continue;
+        }
+        if (text.compare(i, 2, "${") != 0) {
+            segment += text[i];
+            step(i + 1);
+            continue;
+        }
+        size_t close = Lexer::interpolationEnd(text, i + 2);
+        if (close == std::string::npos) {
+            std::cerr << "Parse error: falta '}' en la interpolación del string (línea " << line << ")\n";
+            std::exit(1);
+        }
+        std::vector<Token> holeTokens = Lexer(text.substr(i + 2, close - i - 2)).tokenize();
+        for (Token &tok : holeTokens) {
+            if (tok.line == 1) tok.column += column + 1;
+            tok.line += line - 1;
+        }
+        Parser holeParser(holeTokens);
+        if (holeParser.check(TokenType::EOF_TOKEN)) {
+            std::cerr << "Parse error: interpolación vacía '${}' en el string (línea " << line << ")\n";
+            std::exit(1);
+        }
+        ExprPtr hole = holeParser.parseExpression();
+        holeParser.expect(TokenType::EOF_TOKEN, "se esperaba '}' al final de la interpolación");
+        interp->segments.push_back(std::move(segment));
+        segment.clear();
+        interp->holes.push_back(std::move(hole));
+        step(close + 1);
+    }
+    if (interp->holes.empty()) {
+        return at(std::make_unique<LiteralExpr>(segment), stringToken);
+    }
+    interp->segments.push_back(std::move(segment));
+    return interp;
+}
+
 std::vector<StmtPtr> Parser::parseBlock() {
     expect(TokenType::LBRACE, "se esperaba '{'");
     std::vector<StmtPtr> stmts;
@@ -205,6 +374,7 @@ std::vector<StmtPtr> Parser::parseBlock() {
 }
 
 StmtPtr Parser::parseIf() {
+    Token ifToken = tokens[pos-1];
     expect(TokenType::LPAREN, "se esperaba '(' tras if");
     ExprPtr cond = parseExpression();
     expect(TokenType::RPAREN, "se esperaba ')'");
@@ -213,18 +383,23 @@ StmtPtr Parser::parseIf() {
     if (match(TokenType::ELSE)) {
         elseBranch = parseBlock();
     }
-    return std::make_unique<IfStmt>(std::move(cond), std::move(thenBranch), std::move(elseBranch));
+    return at(std::make_unique<IfStmt>(std::move(cond), std::move(thenBranch), std::move(elseBranch)), ifToken);
 }
 
 StmtPtr Parser::parseWhile() {
+    Token whileToken = tokens[pos-1];
     expect(TokenType::LPAREN, "se esperaba '(' tras while");
     ExprPtr cond = parseExpression();
     expect(TokenType::RPAREN, "se esperaba ')'");
     auto body = parseBlock();
-    return std::make_unique<WhileStmt>(std::move(cond), std::move(body));
+    return std::make_unique<WhileStmt>(std::move(cond), std::move(body), whileToken.line, whileToken.column);
 }
 
 StmtPtr Parser::parseFor() {
+    if (check(TokenType::IDENT) && pos + 1 < tokens.size() && tokens[pos + 1].type == TokenType::IN) {
+        return parseForIn();
+    }
+    Token forToken = tokens[pos-1];
     expect(TokenType::LPAREN, "se esperaba '(' tras for");
     StmtPtr init = nullptr;
     if (!match(TokenType::SEMICOLON)) {
@@ -242,47 +417,54 @@ StmtPtr Parser::parseFor() {
         expect(TokenType::RPAREN, "se esperaba ')'");
     }
     auto body = parseBlock();
-    return std::make_unique<ForStmt>(std::move(init), std::move(cond), std::move(post), std::move(body));
+    return std::make_unique<ForStmt>(std::move(init), std::move(cond), std::move(post), std::move(body),
+                                     forToken.line, forToken.column);
+}
+
+StmtPtr Parser::parseForIn() {
+    Token forToken = tokens[pos-1];
+    std::string var = advance().lexeme;
+    advance(); // in
+    ExprPtr iterable = parseExpression();
+    auto body = parseBlock();
+    return std::make_unique<ForInStmt>(std::move(var), std::move(iterable), std::move(body),
+                                       forToken.line, forToken.column);
 }
 
 StmtPtr Parser::parseForInitOrDecl() {
-    if (peek().type == TokenType::INT || peek().type == TokenType::STRING || peek().type == TokenType::FLOAT) {
-        TokenType typeToken = advance().type;
-        VarDeclStmt::Kind type;
-        if (typeToken == TokenType::INT) type = VarDeclStmt::INT;
-        else if (typeToken == TokenType::FLOAT) type = VarDeclStmt::FLOAT;
-        else type = VarDeclStmt::STRING;
+    Token startToken = peek();
+    if (isTypeKeyword(peek().type)) {
+        VarDeclStmt::Kind type = typeKeywordKind(advance().type);
         
         expect(TokenType::IDENT, "se esperaba identificador");
         std::string name = tokens[pos-1].lexeme;
         expect(TokenType::ASSIGN, "se esperaba '='");
         ExprPtr init = parseExpression();
         
-        // Check if the expression is an array and adjust type accordingly
-        if (dynamic_cast<const ArrayExpr*>(init.get())) {
-            if (type == VarDeclStmt::INT) type = VarDeclStmt::INT_ARRAY;
-            else if (type == VarDeclStmt::FLOAT) type = VarDeclStmt::FLOAT_ARRAY;
-            else if (type == VarDeclStmt::STRING) type = VarDeclStmt::STRING_ARRAY;
+        // Check if the expression is an array (or a slice) and adjust type accordingly
+        if (dynamic_cast<const ArrayExpr*>(init.get()) || dynamic_cast<const SliceExpr*>(init.get())) {
+            type = TypeAnalyzer::arrayTypeOf(type);
         }
         
-        return std::make_unique<VarDeclStmt>(type, name, std::move(init));
+        return at(std::make_unique<VarDeclStmt>(type, name, std::move(init)), startToken);
     }
     if (peek().type == TokenType::IDENT && pos+1 < tokens.size()
         && tokens[pos+1].type == TokenType::COLON_ASSIGN) {
         std::string name = advance().lexeme;
         advance(); // :=
         ExprPtr init = parseExpression();
-        return std::make_unique<InferDeclStmt>(name, std::move(init));
+        return at(std::make_unique<InferDeclStmt>(name, std::move(init)), startToken);
     }
     // expresión como stmt
     ExprPtr e = parseExpression();
-    return std::make_unique<ExprStmt>(std::move(e));
+    return at(std::make_unique<ExprStmt>(std::move(e)), startToken);
 }
 
 StmtPtr Parser::parseForPost() {
+    Token startToken = peek();
     if (peek().type == TokenType::INCREMENT || peek().type == TokenType::DECREMENT) {
         ExprPtr e = parseUnary();
-        return std::make_unique<ExprStmt>(std::move(e));
+        return at(std::make_unique<ExprStmt>(std::move(e)), startToken);
     }
     if (peek().type == TokenType::IDENT && pos + 1 < tokens.size() && tokens[pos + 1].type == TokenType::ASSIGN) {
         Token identToken = advance();
@@ -292,17 +474,14 @@ StmtPtr Parser::parseForPost() {
         return std::make_unique<AssignStmt>(name, std::move(expr), identToken.line, identToken.column);
     }
     ExprPtr e = parseExpression();
-    return std::make_unique<ExprStmt>(std::move(e));
+    return at(std::make_unique<ExprStmt>(std::move(e)), startToken);
 }
 
 StmtPtr Parser::parseFunction(bool inference) {
     VarDeclStmt::Kind retType = VarDeclStmt::VOID; // valor por defecto
     if (!inference) {
         // función con tipo explícito: int/float/string/void function_name(...)
-        if (tokens[pos-1].type == TokenType::INT) retType = VarDeclStmt::INT;
-        else if (tokens[pos-1].type == TokenType::FLOAT) retType = VarDeclStmt::FLOAT;
-        else if (tokens[pos-1].type == TokenType::STRING) retType = VarDeclStmt::STRING;
-        else retType = VarDeclStmt::VOID;
+        retType = typeKeywordKind(tokens[pos-1].type);
         
         // Verificar si hay [] después del tipo (bloquear arrays como retorno)
         if (check(TokenType::LBRACKET)) {
@@ -312,7 +491,8 @@ StmtPtr Parser::parseFunction(bool inference) {
     }
 
     expect(TokenType::IDENT, "se esperaba nombre de función");
-    std::string name = tokens[pos-1].lexeme;
+    Token nameToken = tokens[pos-1];
+    std::string name = nameToken.lexeme;
 
     expect(TokenType::LPAREN, "se esperaba '('");
     std::vector<std::string> params;
@@ -341,7 +521,8 @@ StmtPtr Parser::parseFunction(bool inference) {
         paramIsArray.push_back(false);
     }
     
-    return std::make_unique<FunctionStmt>(inference, retType, name, std::move(params), std::move(paramIsArray), std::move(body));
+    return std::make_unique<FunctionStmt>(inference, retType, name, std::move(params), std::move(paramIsArray), std::move(body),
+                                          nameToken.line, nameToken.column);
 }
 
 StmtPtr Parser::parseStatement() {
@@ -349,6 +530,7 @@ StmtPtr Parser::parseStatement() {
     if (match(TokenType::SEMICOLON)) {
         return nullptr;
     }
+    Token startToken = peek();
 
     // Functions
     if (match(TokenType::FUN)) {
@@ -356,8 +538,7 @@ StmtPtr Parser::parseStatement() {
     }
     
     // Explicit function declaration
-    if ((peek().type == TokenType::INT || peek().type == TokenType::FLOAT || 
-         peek().type == TokenType::STRING || peek().type == TokenType::VOID) &&
+    if ((isTypeKeyword(peek().type) || peek().type == TokenType::VOID) &&
         pos + 2 < tokens.size() && tokens[pos+1].type == TokenType::IDENT &&
         tokens[pos+2].type == TokenType::LPAREN) {
         advance(); // consume type
@@ -371,13 +552,62 @@ StmtPtr Parser::parseStatement() {
             value = parseExpression();
             expect(TokenType::SEMICOLON, "se esperaba ';'");
         }
-        return std::make_unique<ReturnStmt>(std::move(value));
+        return at(std::make_unique<ReturnStmt>(std::move(value)), startToken);
     }
 
     // Control flow statements
     if (match(TokenType::IF)) return parseIf();
     if (match(TokenType::WHILE)) return parseWhile();
     if (match(TokenType::FOR)) return parseFor();
+    if (match(TokenType::PARALLEL)) {
+        expect(TokenType::FOR, "se esperaba 'for' tras parallel");
+        StmtPtr loop = parseFor();
+        auto *forStmt = dynamic_cast<ForStmt*>(loop.get());
+        if (!forStmt) {
+            std::cerr << "Parse error: parallel for requiere la forma (i := inicio; i < fin; ++i) (línea "
+                      << loop->line << ")\n";
+            std::exit(1);
+        }
+        forStmt->parallel = true;
+        return loop;
+    }
+
+    // go f(args);
+    if (match(TokenType::GO)) {
+        Token goToken = tokens[pos-1];
+        ExprPtr call = parseExpression();
+        if (!dynamic_cast<const CallExpr*>(call.get())) {
+            std::cerr << "Parse error: se esperaba una llamada a función tras 'go' (línea " << goToken.line << ")\n";
+            std::exit(1);
+        }
+        expect(TokenType::SEMICOLON, "se esperaba ';'");
+        return std::make_unique<GoStmt>(std::move(call), goToken.line, goToken.column);
+    }
+
+    // Channel operations: send(c, v); close(c);
+    if (match(TokenType::SEND)) {
+        Token sendToken = tokens[pos-1];
+        expect(TokenType::LPAREN, "se esperaba '(' tras send");
+        ExprPtr chan = parseExpression();
+        expect(TokenType::COMMA, "se esperaba ',' en send(canal, valor)");
+        ExprPtr value = parseExpression();
+        expect(TokenType::RPAREN, "se esperaba ')'");
+        expect(TokenType::SEMICOLON, "se esperaba ';'");
+        return std::make_unique<SendStmt>(std::move(chan), std::move(value), sendToken.line, sendToken.column);
+    }
+    if (match(TokenType::CLOSE)) {
+        Token closeToken = tokens[pos-1];
+        expect(TokenType::LPAREN, "se esperaba '(' tras close");
+        ExprPtr chan = parseExpression();
+        expect(TokenType::RPAREN, "se esperaba ')'");
+        expect(TokenType::SEMICOLON, "se esperaba ';'");
+        return std::make_unique<CloseStmt>(std::move(chan), closeToken.line, closeToken.column);
+    }
+    if (check(TokenType::RECV)) {
+        ExprPtr e = parseExpression();
+        expect(TokenType::SEMICOLON, "se esperaba ';'");
+        return at(std::make_unique<ExprStmt>(std::move(e)), startToken);
+    }
 
     // Type inference with :=
     if (peek().type == TokenType::IDENT && pos + 1 < tokens.size()
@@ -386,30 +616,47 @@ StmtPtr Parser::parseStatement() {
         advance(); // :=
         ExprPtr init = parseExpression();
         expect(TokenType::SEMICOLON, "se esperaba ';'");
-        return std::make_unique<InferDeclStmt>(name, std::move(init));
+        return at(std::make_unique<InferDeclStmt>(name, std::move(init)), startToken);
+    }
+
+    // Explicit channel declaration: chan int c = chan int(16);
+    if (match(TokenType::CHAN)) {
+        VarDeclStmt::Kind type = TypeAnalyzer::chanTypeOf(parseChanElementType());
+        expect(TokenType::IDENT, "se esperaba identificador");
+        std::string name = tokens[pos-1].lexeme;
+        expect(TokenType::ASSIGN, "se esperaba '='");
+        ExprPtr init = parseExpression();
+        expect(TokenType::SEMICOLON, "se esperaba ';'");
+        return at(std::make_unique<VarDeclStmt>(type, name, std::move(init)), startToken);
+    }
+
+    // Explicit map declaration: map[string]int m = map[string]int();
+    if (match(TokenType::MAP)) {
+        VarDeclStmt::Kind type = TypeAnalyzer::mapTypeOf(parseMapValueType());
+        expect(TokenType::IDENT, "se esperaba identificador");
+        std::string name = tokens[pos-1].lexeme;
+        expect(TokenType::ASSIGN, "se esperaba '='");
+        ExprPtr init = parseExpression();
+        expect(TokenType::SEMICOLON, "se esperaba ';'");
+        return at(std::make_unique<VarDeclStmt>(type, name, std::move(init)), startToken);
     }
 
     // Explicit type declaration
-    if (match(TokenType::INT) || match(TokenType::FLOAT) || match(TokenType::STRING)) {
-        VarDeclStmt::Kind type;
-        if (tokens[pos-1].type == TokenType::INT) type = VarDeclStmt::INT;
-        else if (tokens[pos-1].type == TokenType::FLOAT) type = VarDeclStmt::FLOAT;
-        else type = VarDeclStmt::STRING;
+    if (isTypeKeyword(peek().type)) {
+        VarDeclStmt::Kind type = typeKeywordKind(advance().type);
 
         expect(TokenType::IDENT, "se esperaba identificador");
         std::string name = tokens[pos-1].lexeme;
         expect(TokenType::ASSIGN, "se esperaba '='");
         ExprPtr init = parseExpression();
         
-        // Check if the expression is an array and adjust type accordingly
-        if (dynamic_cast<const ArrayExpr*>(init.get())) {
-            if (type == VarDeclStmt::INT) type = VarDeclStmt::INT_ARRAY;
-            else if (type == VarDeclStmt::FLOAT) type = VarDeclStmt::FLOAT_ARRAY;
-            else if (type == VarDeclStmt::STRING) type = VarDeclStmt::STRING_ARRAY;
+        // Check if the expression is an array (or a slice) and adjust type accordingly
+        if (dynamic_cast<const ArrayExpr*>(init.get()) || dynamic_cast<const SliceExpr*>(init.get())) {
+            type = TypeAnalyzer::arrayTypeOf(type);
         }
         
         expect(TokenType::SEMICOLON, "se esperaba ';'");
-        return std::make_unique<VarDeclStmt>(type, name, std::move(init));
+        return at(std::make_unique<VarDeclStmt>(type, name, std::move(init)), startToken);
     }
 
     // Assignment
@@ -423,6 +670,23 @@ StmtPtr Parser::parseStatement() {
         return std::make_unique<AssignStmt>(name, std::move(expr), identToken.line, identToken.column);
     }
 
+    // Element assignment: name[index] = expr
+    if (peek().type == TokenType::IDENT && pos + 1 < tokens.size()
+        && tokens[pos + 1].type == TokenType::LBRACKET) {
+        size_t start = pos;
+        Token identToken = advance();
+        advance(); // [
+        ExprPtr index = parseExpression();
+        expect(TokenType::RBRACKET, "se esperaba ']'");
+        if (match(TokenType::ASSIGN)) {
+            ExprPtr expr = parseExpression();
+            expect(TokenType::SEMICOLON, "se esperaba ';'");
+            return std::make_unique<IndexAssignStmt>(identToken.lexeme, std::move(index), std::move(expr),
+                                                     identToken.line, identToken.column);
+        }
+        pos = start;
+    }
+
     // Print statement
     if (match(TokenType::PRINT)) {
         Token printToken = tokens[pos-1];
@@ -437,7 +701,7 @@ StmtPtr Parser::parseStatement() {
     if (peek().type == TokenType::INCREMENT || peek().type == TokenType::DECREMENT) {
         ExprPtr e = parseUnary();
         expect(TokenType::SEMICOLON, "se esperaba ';'");
-        return std::make_unique<ExprStmt>(std::move(e));
+        return at(std::make_unique<ExprStmt>(std::move(e)), startToken);
     }
 
     // Function call as statement
@@ -445,7 +709,7 @@ StmtPtr Parser::parseStatement() {
         && tokens[pos + 1].type == TokenType::LPAREN) {
         ExprPtr e = parseExpression();
         expect(TokenType::SEMICOLON, "se esperaba ';'");
-        return std::make_unique<ExprStmt>(std::move(e));
+        return at(std::make_unique<ExprStmt>(std::move(e)), startToken);
     }
 
     if (match(TokenType::EOF_TOKEN)) return nullptr;
@@ -9,15 +9,47 @@ void CodeGenerator::generatePrintStmt(const PrintStmt *stmt) {
         llvm::AllocaInst *alloca = findVariable(var->name);
         if (alloca && variableTypes.find(var->name) != variableTypes.end()) {
             VarDeclStmt::Kind varType = variableTypes[var->name];
-            if (varType == VarDeclStmt::INT_ARRAY || 
-                varType == VarDeclStmt::FLOAT_ARRAY || 
-                varType == VarDeclStmt::STRING_ARRAY) {
-                printArrayElements(var->name, varType);
+            if (TypeAnalyzer::isArrayType(varType)) {
+                llvm::Value *arrayPtr = builder.CreateLoad(alloca->getAllocatedType(), alloca, "array_load");
+                printArrayElements(arrayPtr, getArrayLength(var->name), varType);
                 return;
             }
         }
     }
+    if (auto *slice = dynamic_cast<const SliceExpr*>(stmt->expr.get())) {
+        VarDeclStmt::Kind sliceType = typeAnalyzer.inferType(slice);
+        llvm::Value *slicePtr = generate(slice);
+        if (!slicePtr) return;
+        printArrayElements(slicePtr, getArrayLength(slice), sliceType);
+        return;
+    }
     
+    // Channels are opaque handles
+    bool isChan = dynamic_cast<const ChanExpr*>(stmt->expr.get()) != nullptr;
+    if (auto *var = dynamic_cast<const VarExpr*>(stmt->expr.get())) {
+        auto typeIt = variableTypes.find(var->name);
+        isChan = typeIt != variableTypes.end() && TypeAnalyzer::isChanType(typeIt->second);
+    }
+    if (isChan) {
+        std::cerr << "Error (line " << stmt->line << ":" << stmt->column << "): no se puede imprimir un canal\n";
+        std::exit(1);
+    }
+    bool isMap = dynamic_cast<const MapExpr*>(stmt->expr.get()) != nullptr;
+    if (auto *var = dynamic_cast<const VarExpr*>(stmt->expr.get())) {
+        auto typeIt = variableTypes.find(var->name);
+        isMap = typeIt != variableTypes.end() && TypeAnalyzer::isMapType(typeIt->second);
+    }
+    if (isMap) {
+        std::cerr << "Error (line " << stmt->line << ":" << stmt->column
+                  << "): no se puede imprimir un map; recórralo con for k in m\n";
+        std::exit(1);
+    }
+    if (typeAnalyzer.inferType(stmt->expr.get()) == VarDeclStmt::BUILDER) {
+        std::cerr << "Error (line " << stmt->line << ":" << stmt->column
+                  << "): no se puede imprimir un builder; use toString(b)\n";
+        std::exit(1);
+    }
+
     // Check if we're printing a character (string index access)
     bool isCharacter = false;
     if (auto *index = dynamic_cast<const IndexExpr*>(stmt->expr.get())) {
@@ -44,8 +76,15 @@ void CodeGenerator::generatePrintStmt(const PrintStmt *stmt) {
 
     if (isCharacter) {
         fmtStr = "%c\n";
+    } else if (val->getType()->isIntegerTy(1)) {
+        fmtStr = "%d\n";
+        printVal = builder.CreateZExt(val, llvm::Type::getInt32Ty(context), "bool_val");
+    } else if (val->getType()->isIntegerTy(64)) {
+        fmtStr = "%lld\n";
     } else if (val->getType()->isIntegerTy()) {
         fmtStr = "%d\n";
+    } else if (val->getType()->isDoubleTy()) {
+        fmtStr = "%f\n";
     } else if (val->getType()->isFloatTy()) {
         fmtStr = "%f\n";
         // Convert float to double for printf
@@ -69,32 +108,24 @@ void CodeGenerator::generatePrintStmt(const PrintStmt *stmt) {
     builder.CreateCall(printfFunc, {strPtr, printVal});
 }
 
-void CodeGenerator::printArrayElements(const std::string &arrayName, VarDeclStmt::Kind arrayType) {
-    // Load the array pointer
-    llvm::AllocaInst *arrayAlloca = findVariable(arrayName);
-    if (!arrayAlloca) return;
-    
-    llvm::Value *arrayPtr = builder.CreateLoad(arrayAlloca->getAllocatedType(), arrayAlloca, "array_load");
-    
-    // Get the real array size
+void CodeGenerator::printArrayElements(llvm::Value *arrayPtr, llvm::Value *length, VarDeclStmt::Kind arrayType) {
+    // Unroll over a compile-time size, loop over a runtime one
     int arraySize = 5; // Default fallback
-    auto sizeIt = arraySizes.find(arrayName);
-    if (sizeIt != arraySizes.end()) {
-        arraySize = sizeIt->second;
+    if (auto *constLength = llvm::dyn_cast_or_null<llvm::ConstantInt>(length)) {
+        arraySize = constLength->getSExtValue();
     }
     
     // Determine element type and format string
-    llvm::Type *elemType;
+    llvm::Type *elemType = getLLVMType(TypeAnalyzer::elementType(arrayType));
     std::string fmtStr;
     
-    if (arrayType == VarDeclStmt::INT_ARRAY) {
-        elemType = llvm::Type::getInt32Ty(context);
+    if (elemType->isIntegerTy(64)) {
+        fmtStr = "%lld ";
+    } else if (elemType->isIntegerTy()) {
         fmtStr = "%d ";
-    } else if (arrayType == VarDeclStmt::FLOAT_ARRAY) {
-        elemType = llvm::Type::getFloatTy(context);
+    } else if (elemType->isFloatingPointTy()) {
         fmtStr = "%f ";
     } else {
-        elemType = llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(context));
         fmtStr = "%s ";
     }
     
@@ -116,10 +147,9 @@ void CodeGenerator::printArrayElements(const std::string &arrayName, VarDeclStmt
     builder.CreateCall(printfFunc, {openPtr});
     
     // Print elements
-    for (int i = 0; i < arraySize; i++) {
+    auto printElement = [&](llvm::Value *index) {
         // Get element pointer
-        llvm::Value *elemPtr = builder.CreateInBoundsGEP(
-            elemType, arrayPtr, {llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), i)}, "elem_ptr");
+        llvm::Value *elemPtr = builder.CreateInBoundsGEP(elemType, arrayPtr, {index}, "elem_ptr");
         
         // Load element
         llvm::Value *elem = builder.CreateLoad(elemType, elemPtr, "elem");
@@ -132,11 +162,18 @@ void CodeGenerator::printArrayElements(const std::string &arrayName, VarDeclStmt
         llvm::Value *fmtPtr = builder.CreateInBoundsGEP(fmtVar->getValueType(), fmtVar, indices, "format");
         
         // Convert float to double for printf if needed
-        if (arrayType == VarDeclStmt::FLOAT_ARRAY) {
+        if (elemType->isFloatTy()) {
             elem = builder.CreateFPExt(elem, llvm::Type::getDoubleTy(context), "double_val");
         }
         
         builder.CreateCall(printfFunc, {fmtPtr, elem});
+    };
+    if (length && !llvm::isa<llvm::ConstantInt>(length)) {
+        emitCountedLoop(length, "print", printElement); // array parameter or slice
+    } else {
+        for (int i = 0; i < arraySize; i++) {
+            printElement(builder.getInt32(i));
+        }
     }
     
     // Print closing bracket and newline
@@ -150,6 +187,11 @@ void CodeGenerator::printArrayElements(const std::string &arrayName, VarDeclStmt
 }
 
 void CodeGenerator::generateStatement(const Stmt *stmt) {
+    // As in generate(): a loop's back edge keeps the loop's line, not the
+    // line of the last statement of its body
+    llvm::DebugLoc parentLocation = builder.getCurrentDebugLocation();
+    emitDebugLocation(stmt->line, stmt->column);
+
     if (auto *varDecl = dynamic_cast<const VarDeclStmt*>(stmt)) {
         generateVarDecl(varDecl);
     }
@@ -159,6 +201,9 @@ void CodeGenerator::generateStatement(const Stmt *stmt) {
     else if (auto *assign = dynamic_cast<const AssignStmt*>(stmt)) {
         generateAssign(assign);
     }
+    else if (auto *indexAssign = dynamic_cast<const IndexAssignStmt*>(stmt)) {
+        generateIndexAssign(indexAssign);
+    }
     else if (auto *print = dynamic_cast<const PrintStmt*>(stmt)) {
         generatePrintStmt(print);
     }
@@ -169,26 +214,40 @@ void CodeGenerator::generateStatement(const Stmt *stmt) {
         generateWhile(whileStmt);
     }
     else if (auto *forStmt = dynamic_cast<const ForStmt*>(stmt)) {
-        generateFor(forStmt);
+        if (forStmt->parallel) {
+            generateParallelFor(forStmt);
+        } else {
+            generateFor(forStmt);
+        }
+    }
+    else if (auto *forIn = dynamic_cast<const ForInStmt*>(stmt)) {
+        generateForIn(forIn);
     }
     else if (auto *exprStmt = dynamic_cast<const ExprStmt*>(stmt)) {
         generate(exprStmt->expr.get());
     }
+    else if (auto *goStmt = dynamic_cast<const GoStmt*>(stmt)) {
+        generateGo(goStmt);
+    }
+    else if (auto *send = dynamic_cast<const SendStmt*>(stmt)) {
+        generateSend(send);
+    }
+    else if (auto *closeStmt = dynamic_cast<const CloseStmt*>(stmt)) {
+        generateClose(closeStmt);
+    }
     else if (auto *funcStmt = dynamic_cast<const FunctionStmt*>(stmt)) {
         generateFunction(funcStmt);
     }
     else if (auto *retStmt = dynamic_cast<const ReturnStmt*>(stmt)) {
         generateReturn(retStmt);
     }
+    builder.SetCurrentDebugLocation(parentLocation);
 }
 
 void CodeGenerator::generateIf(const IfStmt *stmt) {
-    llvm::Value *condValue = generate(stmt->cond.get());
-    if (!condValue) return;
-
-    // Convert condition to boolean
-    llvm::Value *condBool = builder.CreateICmpNE(condValue, 
-        llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), 0), "if_cond");
+    // Conditions are i1 and feed the branch directly
+    llvm::Value *condBool = generateCondition(stmt->cond.get());
+    if (!condBool) return;
 
     llvm::Function *function = currentFunction ? currentFunction : mainFunction;
     llvm::BasicBlock *thenBB = llvm::BasicBlock::Create(context, "then", function);
@@ -229,16 +288,31 @@ void CodeGenerator::generateWhile(const WhileStmt *stmt) {
     llvm::BasicBlock *bodyBB = llvm::BasicBlock::Create(context, "while_body", function);
     llvm::BasicBlock *endBB = llvm::BasicBlock::Create(context, "while_end", function);
 
+    size_t profileSite = 0;
+    if (instrument) {
+        profileSite = createLoopProfileSite("while", stmt->line, stmt->column);
+        incrementProfileCounter(profileSites[profileSite].counters[0]);
+    }
+
+    // Counting loops of the form while (i < n) { ...; ++i; } drop the
+    // per-access bounds checks on a[i]
+    auto savedProvenIndexes = provenIndexes;
+    std::string indexVar;
+    const Expr *bound = nullptr;
+    bool inclusive = false;
+    const Stmt *step = stmt->body.empty() ? nullptr : stmt->body.back().get();
+    if (matchCountingLoop(stmt->cond.get(), step, indexVar, bound, inclusive)) {
+        proveLoopIndexes(indexVar, nullptr, bound, inclusive, stmt->body, step);
+    }
+    std::vector<std::string> builtStrings = beginLoopBuilders(stmt);
+
     // Jump to condition check
     builder.CreateBr(condBB);
 
     // Condition check
     builder.SetInsertPoint(condBB);
-    llvm::Value *condValue = generate(stmt->cond.get());
-    if (!condValue) return;
-    
-    llvm::Value *condBool = builder.CreateICmpNE(condValue, 
-        llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), 0), "while_cond");
+    llvm::Value *condBool = generateCondition(stmt->cond.get());
+    if (!condBool) return;
     builder.CreateCondBr(condBool, bodyBB, endBB);
 
     // Generate body
@@ -250,10 +324,15 @@ void CodeGenerator::generateWhile(const WhileStmt *stmt) {
     }
     popScope();
     typeAnalyzer.popScope();
+    if (instrument) {
+        incrementProfileCounter(profileSites[profileSite].counters[1]);
+    }
     builder.CreateBr(condBB); // Loop back to condition
+    provenIndexes = savedProvenIndexes;
 
     // Continue after loop
     builder.SetInsertPoint(endBB);
+    endLoopBuilders(builtStrings);
 }
 
 void CodeGenerator::generateFor(const ForStmt *stmt) {
@@ -265,6 +344,14 @@ void CodeGenerator::generateFor(const ForStmt *stmt) {
     llvm::BasicBlock *postBB = llvm::BasicBlock::Create(context, "for_post", function);
     llvm::BasicBlock *endBB = llvm::BasicBlock::Create(context, "for_end", function);
 
+    size_t profileSite = 0;
+    if (instrument) {
+        profileSite = createLoopProfileSite("for", stmt->line, stmt->column);
+        incrementProfileCounter(profileSites[profileSite].counters[0]);
+    }
+
+    std::vector<std::string> builtStrings = beginLoopBuilders(stmt);
+
     // Jump to init block
     builder.CreateBr(initBB);
 
@@ -275,15 +362,28 @@ void CodeGenerator::generateFor(const ForStmt *stmt) {
     if (stmt->init) {
         generateStatement(stmt->init.get());
     }
+
+    // Canonical counting loops drop the per-access bounds checks on a[i]
+    auto savedProvenIndexes = provenIndexes;
+    std::string indexVar;
+    const Expr *bound = nullptr;
+    bool inclusive = false;
+    if (stmt->cond && matchCountingLoop(stmt->cond.get(), stmt->post.get(), indexVar, bound, inclusive)) {
+        const Expr *lowerBound = nullptr;
+        if (auto *inferDecl = dynamic_cast<const InferDeclStmt*>(stmt->init.get())) {
+            if (inferDecl->name == indexVar) lowerBound = inferDecl->init.get();
+        } else if (auto *varDecl = dynamic_cast<const VarDeclStmt*>(stmt->init.get())) {
+            if (varDecl->name == indexVar) lowerBound = varDecl->init.get();
+        }
+        proveLoopIndexes(indexVar, lowerBound, bound, inclusive, stmt->body, nullptr);
+    }
     builder.CreateBr(condBB);
 
     // Generate condition
     builder.SetInsertPoint(condBB);
     if (stmt->cond) {
-        llvm::Value *condValue = generate(stmt->cond.get());
-        if (!condValue) return;
-        llvm::Value *condBool = builder.CreateICmpNE(condValue, 
-            llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), 0), "for_cond");
+        llvm::Value *condBool = generateCondition(stmt->cond.get());
+        if (!condBool) return;
         builder.CreateCondBr(condBool, bodyBB, endBB);
     } else {
         builder.CreateBr(bodyBB); // Infinite loop if no condition
@@ -301,56 +401,221 @@ void CodeGenerator::generateFor(const ForStmt *stmt) {
     if (stmt->post) {
         generateStatement(stmt->post.get());
     }
+    if (instrument) {
+        incrementProfileCounter(profileSites[profileSite].counters[1]);
+    }
     builder.CreateBr(condBB); // Loop back to condition
 
+    provenIndexes = savedProvenIndexes;
+
     // Continue after loop
     builder.SetInsertPoint(endBB);
+    endLoopBuilders(builtStrings);
     popScope();
     typeAnalyzer.popScope(); // End for loop scope
 }
 
+void CodeGenerator::generateForIn(const ForInStmt *stmt) {
+    bool overLines = typeAnalyzer.isLinesIterable(stmt->iterable.get());
+    VarDeclStmt::Kind iterableKind = overLines ? VarDeclStmt::VOID : typeAnalyzer.inferType(stmt->iterable.get());
+    VarDeclStmt::Kind elemKind = typeAnalyzer.forInElementType(stmt);
+
+    size_t profileSite = 0;
+    if (instrument) {
+        profileSite = createLoopProfileSite("for in", stmt->line, stmt->column);
+        incrementProfileCounter(profileSites[profileSite].counters[0]);
+    }
+
+    // The iterable (and an array's length) are evaluated once, up front
+    llvm::Value *iterable = overLines ? emitLinesOpen(static_cast<const CallExpr*>(stmt->iterable.get()))
+                                      : generate(stmt->iterable.get());
+    if (!iterable) return;
+    llvm::Value *length = nullptr;
+    if (TypeAnalyzer::isArrayType(iterableKind)) {
+        length = getArrayLength(stmt->iterable.get());
+        if (!length) {
+            std::cerr << "Error (line " << stmt->line << ":" << stmt->column
+                      << "): no se puede determinar el tamaño del array recorrido\n";
+            std::exit(1);
+        }
+    }
+
+    std::vector<std::string> builtStrings = beginLoopBuilders(stmt);
+
+    typeAnalyzer.pushScope(); // for-in scope (holds the element)
+    pushScope();
+    typeAnalyzer.declareVariable(stmt->var, elemKind);
+    llvm::Type *elemType = getLLVMType(elemKind);
+    llvm::AllocaInst *element = createEntryBlockAlloca(stmt->var, elemType);
+    declareVariable(stmt->var, element);
+    auto shadowed = variableTypes.find(stmt->var);
+    bool hadOuterType = shadowed != variableTypes.end();
+    VarDeclStmt::Kind outerType = hadOuterType ? shadowed->second : VarDeclStmt::VOID;
+    variableTypes[stmt->var] = elemKind;
+    declareDebugVariable(stmt->var, element, elemKind, stmt->line, stmt->column);
+
+    auto generateBody = [&]() {
+        for (const auto &bodyStmt : stmt->body) {
+            generateStatement(bodyStmt.get());
+        }
+        if (instrument) {
+            incrementProfileCounter(profileSites[profileSite].counters[1]);
+        }
+    };
+
+    if (length) {
+        // The index never leaves [0, length), so elements are read without
+        // bounds checks and the loop is a plain counted loop over the array
+        emitCountedLoop(length, "for_in", [&](llvm::Value *index) {
+            llvm::Value *elemPtr = builder.CreateInBoundsGEP(elemType, iterable, index, "elem_ptr");
+            builder.CreateStore(builder.CreateLoad(elemType, elemPtr, stmt->var + "_elem"), element);
+            generateBody();
+        });
+    } else if (TypeAnalyzer::isMapType(iterableKind)) {
+        // Maps: visit the key of every live slot, in table order
+        llvm::Function *function = currentFunction ? currentFunction : mainFunction;
+        llvm::BasicBlock *condBB = llvm::BasicBlock::Create(context, "for_in_next", function);
+        llvm::BasicBlock *bodyBB = llvm::BasicBlock::Create(context, "for_in_body", function);
+        llvm::BasicBlock *endBB = llvm::BasicBlock::Create(context, "for_in_end", function);
+        llvm::Type *i64 = llvm::Type::getInt64Ty(context);
+        llvm::AllocaInst *cursor = createEntryBlockAlloca(stmt->var + ".cursor", i64);
+        builder.CreateStore(builder.getInt64(0), cursor);
+        builder.CreateBr(condBB);
+
+        builder.SetInsertPoint(condBB);
+        llvm::Value *next = emitMapNext(iterable, builder.CreateLoad(i64, cursor, "cursor"), element);
+        builder.CreateStore(next, cursor);
+        builder.CreateCondBr(builder.CreateICmpSGE(next, builder.getInt64(0), "map_more"), bodyBB, endBB);
+
+        builder.SetInsertPoint(bodyBB);
+        generateBody();
+        builder.CreateBr(condBB);
+        builder.SetInsertPoint(endBB);
+    } else if (overLines) {
+        // lines(path): pull lines until the runtime returns NULL
+        llvm::Function *function = currentFunction ? currentFunction : mainFunction;
+        llvm::BasicBlock *condBB = llvm::BasicBlock::Create(context, "for_in_line", function);
+        llvm::BasicBlock *bodyBB = llvm::BasicBlock::Create(context, "for_in_body", function);
+        llvm::BasicBlock *endBB = llvm::BasicBlock::Create(context, "for_in_end", function);
+        builder.CreateBr(condBB);
+
+        builder.SetInsertPoint(condBB);
+        llvm::Value *line = emitNextLine(iterable);
+        builder.CreateStore(line, element);
+        builder.CreateCondBr(builder.CreateIsNotNull(line, "line_more"), bodyBB, endBB);
+
+        builder.SetInsertPoint(bodyBB);
+        generateBody();
+        builder.CreateBr(condBB);
+        builder.SetInsertPoint(endBB);
+    } else {
+        // Channels: receive until closed and drained
+        llvm::Function *function = currentFunction ? currentFunction : mainFunction;
+        llvm::BasicBlock *condBB = llvm::BasicBlock::Create(context, "for_in_recv", function);
+        llvm::BasicBlock *bodyBB = llvm::BasicBlock::Create(context, "for_in_body", function);
+        llvm::BasicBlock *endBB = llvm::BasicBlock::Create(context, "for_in_end", function);
+        builder.CreateBr(condBB);
+
+        builder.SetInsertPoint(condBB);
+        llvm::Value *more = nullptr;
+        builder.CreateStore(emitChanRecv(iterable, elemKind, more), element);
+        builder.CreateCondBr(more, bodyBB, endBB);
+
+        builder.SetInsertPoint(bodyBB);
+        generateBody();
+        builder.CreateBr(condBB);
+        builder.SetInsertPoint(endBB);
+    }
+
+    if (hadOuterType) {
+        variableTypes[stmt->var] = outerType;
+    } else {
+        variableTypes.erase(stmt->var);
+    }
+    popScope();
+    typeAnalyzer.popScope();
+    endLoopBuilders(builtStrings);
+}
+
 void CodeGenerator::generateFunction(const FunctionStmt *stmt) {
-    // Get inferred parameter types from type analyzer
-    std::vector<VarDeclStmt::Kind> paramKinds = typeAnalyzer.getFunctionParams(stmt->name);
-    
-    // Build LLVM parameter types
+    // Bodies are generated on demand, once per distinct argument-type tuple
+    // seen at a call site (see getSpecialization)
+    functionDecls[stmt->name] = stmt;
+}
+
+llvm::Function* CodeGenerator::getSpecialization(const FunctionStmt *stmt,
+                                                 const std::vector<VarDeclStmt::Kind> &argKinds) {
+    if (argKinds.size() != stmt->params.size()) {
+        std::cerr << "Error: la función '" << stmt->name << "' espera " << stmt->params.size()
+                  << " argumentos pero recibió " << argKinds.size() << "\n";
+        std::cerr << "Compilación terminada debido a errores.\n";
+        std::exit(1);
+    }
+
+    // Specializations are named after their signature, e.g. suma.int.float
+    std::string mangledName = stmt->name;
+    std::vector<VarDeclStmt::Kind> paramKinds;
     std::vector<llvm::Type*> paramTypes;
-    for (size_t i = 0; i < stmt->params.size(); ++i) {
-        llvm::Type* paramType;
-        
-        // Si el parámetro es array, usar puntero
-        if (i < stmt->paramIsArray.size() && stmt->paramIsArray[i]) {
-            paramType = llvm::PointerType::getUnqual(llvm::Type::getInt32Ty(context)); // int* para arrays
-        } else {
-            if (i < paramKinds.size()) {
-                paramType = getLLVMType(paramKinds[i]);
-            } else {
-                paramType = llvm::Type::getInt32Ty(context); // Default to int
-            }
+    for (size_t i = 0; i < argKinds.size(); ++i) {
+        VarDeclStmt::Kind paramKind = argKinds[i];
+        bool isArray = TypeAnalyzer::isArrayType(paramKind);
+        if (i < stmt->paramIsArray.size() && stmt->paramIsArray[i] && !isArray) {
+            std::cerr << "Error: el parámetro '" << stmt->params[i] << "' de '" << stmt->name
+                      << "' espera un array\n";
+            std::cerr << "Compilación terminada debido a errores.\n";
+            std::exit(1);
         }
-        
-        paramTypes.push_back(paramType);
+        switch (paramKind) {
+            case VarDeclStmt::INT: mangledName += ".int"; break;
+            case VarDeclStmt::FLOAT: mangledName += ".float"; break;
+            case VarDeclStmt::STRING: mangledName += ".string"; break;
+            case VarDeclStmt::INT_ARRAY: mangledName += ".int_array"; break;
+            case VarDeclStmt::FLOAT_ARRAY: mangledName += ".float_array"; break;
+            case VarDeclStmt::STRING_ARRAY: mangledName += ".string_array"; break;
+            case VarDeclStmt::BOOL: mangledName += ".bool"; break;
+            case VarDeclStmt::INT64: mangledName += ".int64"; break;
+            case VarDeclStmt::DOUBLE: mangledName += ".double"; break;
+            case VarDeclStmt::INT64_ARRAY: mangledName += ".int64_array"; break;
+            case VarDeclStmt::DOUBLE_ARRAY: mangledName += ".double_array"; break;
+            case VarDeclStmt::CHAN_INT: mangledName += ".chan_int"; break;
+            case VarDeclStmt::CHAN_FLOAT: mangledName += ".chan_float"; break;
+            case VarDeclStmt::CHAN_STRING: mangledName += ".chan_string"; break;
+            case VarDeclStmt::MAP_INT: mangledName += ".map_int"; break;
+            case VarDeclStmt::MAP_FLOAT: mangledName += ".map_float"; break;
+            case VarDeclStmt::MAP_STRING: mangledName += ".map_string"; break;
+            case VarDeclStmt::BUILDER: mangledName += ".builder"; break;
+            case VarDeclStmt::VOID:
+                std::cerr << "Error: argumento sin valor en la llamada a '" << stmt->name << "'\n";
+                std::cerr << "Compilación terminada debido a errores.\n";
+                std::exit(1);
+        }
+        paramKinds.push_back(paramKind);
+        paramTypes.push_back(isArray ? static_cast<llvm::Type*>(getArrayViewType(paramKind)) : getLLVMType(paramKind));
     }
-    
-    llvm::Type *returnType;
-    VarDeclStmt::Kind actualReturnType;
-    
-    // Get the return type from type analyzer (already determined in main)
-    actualReturnType = typeAnalyzer.getFunctionReturnType(stmt->name);
-    
-    if (actualReturnType == VarDeclStmt::VOID) {
-        returnType = llvm::Type::getVoidTy(context);
-    } else {
-        returnType = getLLVMType(actualReturnType);
+
+    auto cached = functions.find(mangledName);
+    if (cached != functions.end()) {
+        return cached->second;
     }
-    
+
+    // Return type of this signature, from the interprocedural fixpoint
+    VarDeclStmt::Kind returnKind = typeAnalyzer.inferReturnType(stmt->name, paramKinds);
+    llvm::Type *returnType = getLLVMType(returnKind);
+
     llvm::FunctionType *funcType = llvm::FunctionType::get(returnType, paramTypes, false);
-    llvm::Function *function = llvm::Function::Create(funcType, llvm::Function::ExternalLinkage, stmt->name, module.get());
-    
-    // Register function
-    functions[stmt->name] = function;
-    functionTypes[stmt->name] = actualReturnType;
-    
+    llvm::Function *function = llvm::Function::Create(funcType, llvm::Function::ExternalLinkage, mangledName, module.get());
+
+    // Register before generating the body so recursive calls hit the cache
+    functions[mangledName] = function;
+    functionTypes[mangledName] = returnKind;
+
+    generateFunctionBody(stmt, function, paramKinds, returnKind);
+    return function;
+}
+
+void CodeGenerator::generateFunctionBody(const FunctionStmt *stmt, llvm::Function *function,
+                                         const std::vector<VarDeclStmt::Kind> &paramKinds,
+                                         VarDeclStmt::Kind returnKind) {
     // Set parameter names
     auto argIt = function->arg_begin();
     for (size_t i = 0; i < stmt->params.size(); ++i, ++argIt) {
@@ -360,12 +625,27 @@ void CodeGenerator::generateFunction(const FunctionStmt *stmt) {
     // Create function body
     llvm::BasicBlock *funcBB = llvm::BasicBlock::Create(context, "entry", function);
     
-    // Save current builder state
-    llvm::BasicBlock *oldInsertBlock = builder.GetInsertBlock();
+    // Save current builder state; the caller may be in the middle of an
+    // expression, and the callee must not see the caller's variables
+    llvm::IRBuilderBase::InsertPoint oldInsertPoint = builder.saveIP();
     llvm::Function *oldFunction = currentFunction;
+    llvm::DebugLoc oldDebugLoc = builder.getCurrentDebugLocation();
+    auto oldProvenIndexes = provenIndexes;
+    auto oldNamedValuesStack = std::move(namedValuesStack);
+    auto oldVariableTypes = variableTypes;
+    auto oldArraySizes = arraySizes;
+    auto oldArrayLengths = arrayLengths;
+    auto oldLoopBuilders = std::move(loopBuilders);
+    namedValuesStack.clear();
+    provenIndexes.clear();
+    loopBuilders.clear();
     
     builder.SetInsertPoint(funcBB);
     currentFunction = function;
+    if (diBuilder) {
+        createDebugFunction(function, stmt->name, stmt->line, returnKind, paramKinds);
+    }
+    emitProfileEntry(function, function->getName().str(), stmt->line, stmt->column);
     
     // Create new scope for function
     typeAnalyzer.pushScope();
@@ -374,21 +654,26 @@ void CodeGenerator::generateFunction(const FunctionStmt *stmt) {
     // Add parameters to scope
     argIt = function->arg_begin();
     for (size_t i = 0; i < stmt->params.size(); ++i, ++argIt) {
-        llvm::Type *paramType = paramTypes[i];
-        llvm::AllocaInst *paramAlloca = createEntryBlockAlloca(stmt->params[i], paramType);
-        builder.CreateStore(&*argIt, paramAlloca);
-        declareVariable(stmt->params[i], paramAlloca);
-        
-        // Also declare in type analyzer
-        VarDeclStmt::Kind paramKind = (i < paramKinds.size()) ? paramKinds[i] : VarDeclStmt::INT;
-        
-        // Si el parámetro está marcado como array, usar INT_ARRAY
-        if (i < stmt->paramIsArray.size() && stmt->paramIsArray[i]) {
-            paramKind = VarDeclStmt::INT_ARRAY;
+        const std::string &paramName = stmt->params[i];
+        llvm::AllocaInst *paramAlloca = createEntryBlockAlloca(paramName, getLLVMType(paramKinds[i]));
+        arraySizes.erase(paramName);
+        arrayLengths.erase(paramName);
+        if (argIt->getType()->isStructTy()) {
+            // Split the {ptr, len} view: the pointer behaves like any local
+            // array, the length feeds bounds checks and loops
+            builder.CreateStore(builder.CreateExtractValue(&*argIt, 0, paramName + "_ptr"), paramAlloca);
+            llvm::AllocaInst *lenAlloca = createEntryBlockAlloca(paramName + ".len", llvm::Type::getInt64Ty(context));
+            builder.CreateStore(builder.CreateExtractValue(&*argIt, 1, paramName + "_len"), lenAlloca);
+            arrayLengths[paramName] = lenAlloca;
+        } else {
+            builder.CreateStore(&*argIt, paramAlloca);
         }
+        declareVariable(paramName, paramAlloca);
         
-        typeAnalyzer.declareVariable(stmt->params[i], paramKind);
-        variableTypes[stmt->params[i]] = paramKind;
+        // Also declare in type analyzer
+        typeAnalyzer.declareVariable(paramName, paramKinds[i]);
+        variableTypes[paramName] = paramKinds[i];
+        declareDebugVariable(stmt->params[i], paramAlloca, paramKinds[i], stmt->line, stmt->column, i + 1);
     }
     
     // Generate function body
@@ -397,31 +682,53 @@ void CodeGenerator::generateFunction(const FunctionStmt *stmt) {
     }
     
     // Add default return if needed
-    if (actualReturnType == VarDeclStmt::VOID) {
+    emitProfileExit();
+    if (returnKind == VarDeclStmt::VOID) {
         builder.CreateRetVoid();
     } else {
         // Default return value if no explicit return
-        llvm::Value *defaultVal = llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), 0);
-        builder.CreateRet(defaultVal);
+        builder.CreateRet(llvm::Constant::getNullValue(function->getReturnType()));
     }
     
     // Restore previous state
     popScope();
     typeAnalyzer.popScope();
     currentFunction = oldFunction;
-    if (oldInsertBlock) {
-        builder.SetInsertPoint(oldInsertBlock);
-    }
+    namedValuesStack = std::move(oldNamedValuesStack);
+    variableTypes = std::move(oldVariableTypes);
+    arraySizes = std::move(oldArraySizes);
+    arrayLengths = std::move(oldArrayLengths);
+    loopBuilders = std::move(oldLoopBuilders);
+    builder.restoreIP(oldInsertPoint);
+    builder.SetCurrentDebugLocation(oldDebugLoc);
+    provenIndexes = oldProvenIndexes;
 }
 
 void CodeGenerator::generateReturn(const ReturnStmt *stmt) {
     if (stmt->value) {
         llvm::Value *retVal = generate(stmt->value.get());
-        if (retVal) {
-            builder.CreateRet(retVal);
+        if (!retVal) return;
+
+        // A specialization may compute a float where an int is declared (or
+        // vice versa); convert to the signature's return type
+        llvm::Function *function = currentFunction ? currentFunction : mainFunction;
+        retVal = convertValue(retVal, function->getReturnType());
+        if (!retVal) {
+            std::cerr << "Error: tipo de retorno incompatible en '" << function->getName().str() << "'\n";
+            std::cerr << "Compilación terminada debido a errores.\n";
+            std::exit(1);
         }
+        emitProfileExit();
+        builder.CreateRet(retVal);
     } else {
+        emitProfileExit();
         builder.CreateRetVoid();
     }
+
+    // Anything emitted after a return is dead, but it still needs a block of
+    // its own so the function stays well formed for the optimizer
+    llvm::Function *function = currentFunction ? currentFunction : mainFunction;
+    llvm::BasicBlock *afterRetBB = llvm::BasicBlock::Create(context, "after_return", function);
+    builder.SetInsertPoint(afterRetBB);
 }
 
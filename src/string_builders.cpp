@@ -0,0 +1,407 @@
+#include "../include/code_generator.h"
+#include <iostream>
+#include <cstdlib>
+#include <variant>
+
+// String builders
+//
+// builder() is an opaque gz_sb* from the runtime: a byte buffer that grows
+// geometrically, so appending n bytes costs O(n) amortized instead of the
+// copy of the whole string that s = s + x makes. append(b, x) formats
+// numbers straight into the buffer (as print would show them) and
+// toString(b) hands the buffer over as the string without copying; the
+// builder then starts again empty.
+//
+// Loops that only ever grow a string, `s = s + a + b` and nothing else
+// touching s, are rewritten to use a builder behind the scenes: the loop
+// starts one from s, every such assignment appends a and b, and s gets the
+// result when the loop exits.
+//
+// "x=${x} y=${y}" is built without intermediate strings: the result's size
+// is bounded up front (literal text, strlen of string holes, the widest a
+// number of each type can print), one buffer is taken from the string arena
+// and every piece is written straight into it.
+
+namespace {
+
+bool mentions(const Expr *expr, const std::string &name);
+
+bool mentionsAny(const std::vector<ExprPtr> &exprs, const std::string &name) {
+    for (const auto &expr : exprs) {
+        if (mentions(expr.get(), name)) return true;
+    }
+    return false;
+}
+
+bool mentions(const Expr *expr, const std::string &name) {
+    if (!expr || dynamic_cast<const LiteralExpr*>(expr)) return false;
+    if (auto *var = dynamic_cast<const VarExpr*>(expr)) return var->name == name;
+    if (auto *bin = dynamic_cast<const BinaryExpr*>(expr)) {
+        return mentions(bin->left.get(), name) || mentions(bin->right.get(), name);
+    }
+    if (auto *unary = dynamic_cast<const UnaryExpr*>(expr)) return unary->varName == name;
+    if (auto *array = dynamic_cast<const ArrayExpr*>(expr)) return mentionsAny(array->elements, name);
+    if (auto *index = dynamic_cast<const IndexExpr*>(expr)) {
+        return mentions(index->array.get(), name) || mentions(index->index.get(), name);
+    }
+    if (auto *slice = dynamic_cast<const SliceExpr*>(expr)) {
+        return mentions(slice->array.get(), name) || mentions(slice->lo.get(), name) ||
+               mentions(slice->hi.get(), name);
+    }
+    if (auto *call = dynamic_cast<const CallExpr*>(expr)) return mentionsAny(call->args, name);
+    if (auto *chan = dynamic_cast<const ChanExpr*>(expr)) return mentions(chan->capacity.get(), name);
+    if (auto *map = dynamic_cast<const MapExpr*>(expr)) return mentions(map->sizeHint.get(), name);
+    if (auto *recv = dynamic_cast<const RecvExpr*>(expr)) {
+        return recv->target == name || mentions(recv->chan.get(), name);
+    }
+    if (auto *interp = dynamic_cast<const InterpExpr*>(expr)) return mentionsAny(interp->holes, name);
+    return true; // unknown expression: assume it does
+}
+
+// The operands of `name = name + a + b ...`, left to right
+bool matchAppend(const AssignStmt *assign, std::vector<const Expr*> &pieces) {
+    const Expr *expr = assign->expr.get();
+    std::vector<const Expr*> reversed;
+    while (auto *bin = dynamic_cast<const BinaryExpr*>(expr)) {
+        if (bin->op != BinaryExpr::Op::ADD) break;
+        reversed.push_back(bin->right.get());
+        expr = bin->left.get();
+    }
+    auto *var = dynamic_cast<const VarExpr*>(expr);
+    if (!var || var->name != assign->name || reversed.empty()) return false;
+    pieces.assign(reversed.rbegin(), reversed.rend());
+    return true;
+}
+
+void collectAppendTargets(const Stmt *stmt, std::set<std::string> &names);
+
+void collectAppendTargets(const std::vector<StmtPtr> &body, std::set<std::string> &names) {
+    for (const auto &stmt : body) collectAppendTargets(stmt.get(), names);
+}
+
+void collectAppendTargets(const Stmt *stmt, std::set<std::string> &names) {
+    std::vector<const Expr*> pieces;
+    if (auto *assign = dynamic_cast<const AssignStmt*>(stmt)) {
+        if (matchAppend(assign, pieces)) names.insert(assign->name);
+    } else if (auto *ifStmt = dynamic_cast<const IfStmt*>(stmt)) {
+        collectAppendTargets(ifStmt->thenBranch, names);
+        collectAppendTargets(ifStmt->elseBranch, names);
+    } else if (auto *whileStmt = dynamic_cast<const WhileStmt*>(stmt)) {
+        collectAppendTargets(whileStmt->body, names);
+    } else if (auto *forStmt = dynamic_cast<const ForStmt*>(stmt)) {
+        collectAppendTargets(forStmt->body, names);
+    } else if (auto *forIn = dynamic_cast<const ForInStmt*>(stmt)) {
+        collectAppendTargets(forIn->body, names);
+    }
+}
+
+// True when every use of `name` in stmt is an append to it whose operands do
+// not read it, and stmt declares no variable of that name
+bool onlyAppends(const Stmt *stmt, const std::string &name);
+
+bool onlyAppends(const std::vector<StmtPtr> &body, const std::string &name) {
+    for (const auto &stmt : body) {
+        if (!onlyAppends(stmt.get(), name)) return false;
+    }
+    return true;
+}
+
+bool onlyAppends(const Stmt *stmt, const std::string &name) {
+    if (!stmt) return true;
+    if (auto *varDecl = dynamic_cast<const VarDeclStmt*>(stmt)) {
+        return varDecl->name != name && !mentions(varDecl->init.get(), name);
+    }
+    if (auto *inferDecl = dynamic_cast<const InferDeclStmt*>(stmt)) {
+        return inferDecl->name != name && !mentions(inferDecl->init.get(), name);
+    }
+    if (auto *assign = dynamic_cast<const AssignStmt*>(stmt)) {
+        if (assign->name != name) return !mentions(assign->expr.get(), name);
+        std::vector<const Expr*> pieces;
+        if (!matchAppend(assign, pieces)) return false;
+        for (const Expr *piece : pieces) {
+            if (mentions(piece, name)) return false;
+        }
+        return true;
+    }
+    if (auto *indexAssign = dynamic_cast<const IndexAssignStmt*>(stmt)) {
+        return indexAssign->name != name && !mentions(indexAssign->index.get(), name) &&
+               !mentions(indexAssign->expr.get(), name);
+    }
+    if (auto *print = dynamic_cast<const PrintStmt*>(stmt)) return !mentions(print->expr.get(), name);
+    if (auto *exprStmt = dynamic_cast<const ExprStmt*>(stmt)) return !mentions(exprStmt->expr.get(), name);
+    if (auto *goStmt = dynamic_cast<const GoStmt*>(stmt)) return !mentions(goStmt->call.get(), name);
+    if (auto *send = dynamic_cast<const SendStmt*>(stmt)) {
+        return !mentions(send->chan.get(), name) && !mentions(send->value.get(), name);
+    }
+    if (auto *closeStmt = dynamic_cast<const CloseStmt*>(stmt)) return !mentions(closeStmt->chan.get(), name);
+    if (auto *retStmt = dynamic_cast<const ReturnStmt*>(stmt)) return !mentions(retStmt->value.get(), name);
+    if (auto *ifStmt = dynamic_cast<const IfStmt*>(stmt)) {
+        return !mentions(ifStmt->cond.get(), name) && onlyAppends(ifStmt->thenBranch, name) &&
+               onlyAppends(ifStmt->elseBranch, name);
+    }
+    if (auto *whileStmt = dynamic_cast<const WhileStmt*>(stmt)) {
+        return !mentions(whileStmt->cond.get(), name) && onlyAppends(whileStmt->body, name);
+    }
+    if (auto *forStmt = dynamic_cast<const ForStmt*>(stmt)) {
+        // A parallel body cannot write shared variables at all; leave it to
+        // the usual checks
+        return !forStmt->parallel && onlyAppends(forStmt->init.get(), name) &&
+               !mentions(forStmt->cond.get(), name) && onlyAppends(forStmt->post.get(), name) &&
+               onlyAppends(forStmt->body, name);
+    }
+    if (auto *forIn = dynamic_cast<const ForInStmt*>(stmt)) {
+        return forIn->var != name && !mentions(forIn->iterable.get(), name) && onlyAppends(forIn->body, name);
+    }
+    return false; // functions and unknown statements
+}
+
+} // namespace
+
+llvm::Value* CodeGenerator::generateBuilderBuiltin(const CallExpr *call) {
+    llvm::Type *sbType = getLLVMType(VarDeclStmt::BUILDER);
+    usesRuntime = true;
+    if (call->callee == "builder") {
+        llvm::FunctionCallee newFunc = module->getOrInsertFunction(
+            "gz_sb_new", llvm::FunctionType::get(sbType, false));
+        return builder.CreateCall(newFunc, {}, "builder");
+    }
+
+    llvm::Value *sb = generate(call->args[0].get());
+    if (!sb) return nullptr;
+    if (call->callee == "append") {
+        emitBuilderAppend(sb, call->args[1].get());
+        return nullptr;
+    }
+    llvm::FunctionCallee finishFunc = module->getOrInsertFunction(
+        "gz_sb_finish", llvm::FunctionType::get(getLLVMType(VarDeclStmt::STRING), {sbType}, false));
+    return builder.CreateCall(finishFunc, {sb}, "built");
+}
+
+// Append a string, or a number formatted as print shows it
+void CodeGenerator::emitBuilderAppend(llvm::Value *sb, const Expr *value) {
+    // An interpolated string goes into the builder piece by piece
+    if (auto *interp = dynamic_cast<const InterpExpr*>(value)) {
+        typeAnalyzer.inferType(interp);
+        llvm::FunctionCallee appendFunc = module->getOrInsertFunction(
+            "gz_sb_append", llvm::FunctionType::get(llvm::Type::getVoidTy(context),
+                                                    {sb->getType(), getLLVMType(VarDeclStmt::STRING)}, false));
+        for (size_t i = 0; i < interp->segments.size(); ++i) {
+            if (!interp->segments[i].empty()) {
+                builder.CreateCall(appendFunc, {sb, createStringConstant(interp->segments[i])});
+            }
+            if (i < interp->holes.size()) emitBuilderAppend(sb, interp->holes[i].get());
+        }
+        usesRuntime = true;
+        return;
+    }
+    VarDeclStmt::Kind kind = typeAnalyzer.inferType(value);
+    const char *appendName;
+    VarDeclStmt::Kind argKind;
+    if (kind == VarDeclStmt::STRING) {
+        appendName = "gz_sb_append";
+        argKind = VarDeclStmt::STRING;
+    } else if (kind == VarDeclStmt::FLOAT || kind == VarDeclStmt::DOUBLE) {
+        appendName = "gz_sb_append_float";
+        argKind = VarDeclStmt::DOUBLE;
+    } else if (TypeAnalyzer::isNumericType(kind)) {
+        appendName = "gz_sb_append_int";
+        argKind = VarDeclStmt::INT64;
+    } else {
+        std::cerr << "Error (line " << value->line << ":" << value->column
+                  << "): solo se pueden añadir números o strings a un string\n";
+        std::exit(1);
+    }
+    llvm::Value *arg = generate(value);
+    if (!arg) return;
+    // Bools read as 0/1 rather than sign-extending to -1
+    if (kind == VarDeclStmt::BOOL) arg = builder.CreateZExt(arg, getLLVMType(VarDeclStmt::INT64), "bool_to_int");
+    if (llvm::Value *converted = convertValue(arg, getLLVMType(argKind))) {
+        arg = converted;
+    }
+    llvm::FunctionCallee appendFunc = module->getOrInsertFunction(
+        appendName, llvm::FunctionType::get(llvm::Type::getVoidTy(context), {sb->getType(), arg->getType()}, false));
+    builder.CreateCall(appendFunc, {sb, arg});
+    usesRuntime = true;
+}
+
+// A string operand of +; numbers are formatted as print shows them
+llvm::Value* CodeGenerator::generateAsString(const Expr *expr) {
+    VarDeclStmt::Kind kind = typeAnalyzer.inferType(expr);
+    if (kind == VarDeclStmt::STRING) return generate(expr);
+    if (!TypeAnalyzer::isNumericType(kind)) {
+        std::cerr << "Error (line " << expr->line << ":" << expr->column
+                  << "): solo se pueden concatenar números o strings a un string\n";
+        std::exit(1);
+    }
+    llvm::Value *value = generate(expr);
+    if (!value) return nullptr;
+    bool isFloat = kind == VarDeclStmt::FLOAT || kind == VarDeclStmt::DOUBLE;
+    llvm::Type *argType = getLLVMType(isFloat ? VarDeclStmt::DOUBLE : VarDeclStmt::INT64);
+    if (kind == VarDeclStmt::BOOL) value = builder.CreateZExt(value, argType, "bool_to_int");
+    if (llvm::Value *converted = convertValue(value, argType)) {
+        value = converted;
+    }
+    llvm::FunctionCallee formatFunc = module->getOrInsertFunction(
+        isFloat ? "gz_str_of_float" : "gz_str_of_int",
+        llvm::FunctionType::get(getLLVMType(VarDeclStmt::STRING), {argType}, false));
+    usesRuntime = true;
+    return builder.CreateCall(formatFunc, {value}, "num_str");
+}
+
+// Start a builder for every string the loop only appends to; called right
+// before the loop, with endLoopBuilders right after it
+std::vector<std::string> CodeGenerator::beginLoopBuilders(const Stmt *loop) {
+    std::set<std::string> candidates;
+    collectAppendTargets(loop, candidates);
+    std::vector<std::string> started;
+    for (const std::string &name : candidates) {
+        auto typeIt = variableTypes.find(name);
+        llvm::AllocaInst *alloca = findVariable(name);
+        if (!alloca || typeIt == variableTypes.end() || typeIt->second != VarDeclStmt::STRING ||
+            loopBuilders.count(name) || !onlyAppends(loop, name)) {
+            continue;
+        }
+        llvm::Type *sbType = getLLVMType(VarDeclStmt::BUILDER);
+        llvm::FunctionCallee fromFunc = module->getOrInsertFunction(
+            "gz_sb_from", llvm::FunctionType::get(sbType, {alloca->getAllocatedType()}, false));
+        llvm::AllocaInst *sbSlot = createEntryBlockAlloca(name + ".builder", sbType);
+        llvm::Value *current = builder.CreateLoad(alloca->getAllocatedType(), alloca, name + "_load");
+        builder.CreateStore(builder.CreateCall(fromFunc, {current}, name + "_builder"), sbSlot);
+        loopBuilders[name] = sbSlot;
+        started.push_back(name);
+        usesRuntime = true;
+    }
+    return started;
+}
+
+void CodeGenerator::endLoopBuilders(const std::vector<std::string> &names) {
+    for (const std::string &name : names) {
+        llvm::AllocaInst *sbSlot = loopBuilders[name];
+        loopBuilders.erase(name);
+        llvm::Value *sb = builder.CreateLoad(sbSlot->getAllocatedType(), sbSlot, name + "_builder");
+        // The string takes the buffer and the builder itself is freed
+        llvm::FunctionCallee doneFunc = module->getOrInsertFunction(
+            "gz_sb_done", llvm::FunctionType::get(getLLVMType(VarDeclStmt::STRING), {sb->getType()}, false));
+        builder.CreateStore(builder.CreateCall(doneFunc, {sb}, name + "_built"), findVariable(name));
+    }
+}
+
+void CodeGenerator::generateLoopAppend(const AssignStmt *stmt) {
+    std::vector<const Expr*> pieces;
+    matchAppend(stmt, pieces);
+    llvm::AllocaInst *sbSlot = loopBuilders[stmt->name];
+    llvm::Value *sb = builder.CreateLoad(sbSlot->getAllocatedType(), sbSlot, stmt->name + "_builder");
+    for (const Expr *piece : pieces) {
+        emitBuilderAppend(sb, piece);
+    }
+}
+
+llvm::Value* CodeGenerator::generateInterpolation(const InterpExpr *expr) {
+    typeAnalyzer.inferType(expr); // every hole must be a number or a string
+    llvm::Type *i8 = llvm::Type::getInt8Ty(context);
+    llvm::Type *i64 = llvm::Type::getInt64Ty(context);
+    llvm::Type *strType = getLLVMType(VarDeclStmt::STRING);
+    llvm::Type *doubleType = getLLVMType(VarDeclStmt::DOUBLE);
+
+    // Literal holes are folded into the text around them; the other holes
+    // are evaluated left to right before anything is written
+    struct Piece {
+        std::string text;
+        VarDeclStmt::Kind kind = VarDeclStmt::STRING;
+        llvm::Value *value = nullptr; // nullptr for text
+        llvm::Value *length = nullptr; // of a string hole
+    };
+    std::vector<Piece> pieces;
+    auto addText = [&](const std::string &text) {
+        if (pieces.empty() || pieces.back().value) pieces.push_back(Piece());
+        pieces.back().text += text;
+    };
+    for (size_t i = 0; i < expr->segments.size(); ++i) {
+        addText(expr->segments[i]);
+        if (i == expr->holes.size()) break;
+        const Expr *hole = expr->holes[i].get();
+        if (auto *lit = dynamic_cast<const LiteralExpr*>(hole)) {
+            if (auto *text = std::get_if<std::string>(&lit->value)) { addText(*text); continue; }
+            if (auto *number = std::get_if<int>(&lit->value)) { addText(std::to_string(*number)); continue; }
+            if (auto *number = std::get_if<long long>(&lit->value)) { addText(std::to_string(*number)); continue; }
+            if (auto *flag = std::get_if<bool>(&lit->value)) { addText(*flag ? "1" : "0"); continue; }
+        }
+        Piece piece;
+        piece.kind = typeAnalyzer.inferType(hole);
+        piece.value = generate(hole);
+        if (!piece.value) return nullptr;
+        pieces.push_back(std::move(piece));
+    }
+    if (pieces.size() == 1 && !pieces[0].value) return createStringConstant(pieces[0].text);
+
+    emitDebugLocation(expr->line, expr->column);
+    usesRuntime = true;
+    llvm::FunctionCallee strlenFunc = module->getOrInsertFunction(
+        "strlen", llvm::FunctionType::get(i64, {strType}, false));
+    llvm::FunctionCallee boundFunc = module->getOrInsertFunction(
+        "gz_fmt_float_bound", llvm::FunctionType::get(i64, {doubleType}, false));
+
+    // Room for everything plus the terminator
+    uint64_t fixedSize = 1;
+    llvm::Value *size = nullptr;
+    auto addSize = [&](llvm::Value *extra) {
+        size = size ? builder.CreateAdd(size, extra, "interp_size") : extra;
+    };
+    for (Piece &piece : pieces) {
+        if (!piece.value) {
+            fixedSize += piece.text.size();
+            continue;
+        }
+        switch (piece.kind) {
+            case VarDeclStmt::STRING:
+                piece.length = builder.CreateCall(strlenFunc, {piece.value}, "hole_len");
+                addSize(piece.length);
+                break;
+            case VarDeclStmt::BOOL: fixedSize += 1; break;
+            case VarDeclStmt::INT: fixedSize += 11; break; // -2147483648
+            case VarDeclStmt::FLOAT: fixedSize += 48; break; // -FLT_MAX with %f
+            case VarDeclStmt::DOUBLE:
+                addSize(builder.CreateCall(boundFunc, {piece.value}, "hole_bound"));
+                break;
+            default: fixedSize += 20; break; // int64
+        }
+    }
+    addSize(builder.getInt64(fixedSize));
+
+    llvm::FunctionCallee allocFunc = module->getOrInsertFunction(
+        "gz_str_alloc", llvm::FunctionType::get(strType, {i64}, false));
+    llvm::FunctionCallee intFunc = module->getOrInsertFunction(
+        "gz_fmt_int", llvm::FunctionType::get(i64, {strType, i64}, false));
+    llvm::FunctionCallee floatFunc = module->getOrInsertFunction(
+        "gz_fmt_float", llvm::FunctionType::get(i64, {strType, doubleType}, false));
+    llvm::Value *out = builder.CreateCall(allocFunc, {size}, "interp");
+    llvm::Value *cursor = out;
+    for (const Piece &piece : pieces) {
+        llvm::Value *written;
+        if (!piece.value) {
+            if (piece.text.empty()) continue;
+            builder.CreateMemCpy(cursor, llvm::MaybeAlign(1), createStringConstant(piece.text),
+                                 llvm::MaybeAlign(1), piece.text.size());
+            written = builder.getInt64(piece.text.size());
+        } else if (piece.kind == VarDeclStmt::STRING) {
+            builder.CreateMemCpy(cursor, llvm::MaybeAlign(1), piece.value, llvm::MaybeAlign(1), piece.length);
+            written = piece.length;
+        } else if (piece.kind == VarDeclStmt::BOOL) {
+            // Bools print as 1/0
+            llvm::Value *digit = builder.CreateAdd(builder.CreateZExt(piece.value, i8), builder.getInt8('0'), "bool_digit");
+            builder.CreateStore(digit, cursor);
+            written = builder.getInt64(1);
+        } else if (piece.kind == VarDeclStmt::FLOAT || piece.kind == VarDeclStmt::DOUBLE) {
+            llvm::Value *arg = piece.value;
+            if (llvm::Value *converted = convertValue(arg, doubleType)) arg = converted;
+            written = builder.CreateCall(floatFunc, {cursor, arg}, "float_len");
+        } else {
+            llvm::Value *arg = piece.value;
+            if (llvm::Value *converted = convertValue(arg, i64)) arg = converted;
+            written = builder.CreateCall(intFunc, {cursor, arg}, "int_len");
+        }
+        cursor = builder.CreateInBoundsGEP(i8, cursor, written, "interp_cursor");
+    }
+    builder.CreateStore(builder.getInt8(0), cursor);
+    return out;
+}
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <variant>
 #include <cstdlib>
+#include <algorithm>
 
 TypeAnalyzer::TypeAnalyzer() {
     pushScope(); // Global scope
@@ -17,14 +18,107 @@ void TypeAnalyzer::popScope() {
     }
 }
 
+bool TypeAnalyzer::isArrayType(VarDeclStmt::Kind kind) {
+    return kind == VarDeclStmt::INT_ARRAY || kind == VarDeclStmt::FLOAT_ARRAY ||
+           kind == VarDeclStmt::STRING_ARRAY || kind == VarDeclStmt::INT64_ARRAY ||
+           kind == VarDeclStmt::DOUBLE_ARRAY;
+}
+
+bool TypeAnalyzer::isChanType(VarDeclStmt::Kind kind) {
+    return kind == VarDeclStmt::CHAN_INT || kind == VarDeclStmt::CHAN_FLOAT || kind == VarDeclStmt::CHAN_STRING;
+}
+
+bool TypeAnalyzer::isMapType(VarDeclStmt::Kind kind) {
+    return kind == VarDeclStmt::MAP_INT || kind == VarDeclStmt::MAP_FLOAT || kind == VarDeclStmt::MAP_STRING;
+}
+
+bool TypeAnalyzer::isNumericType(VarDeclStmt::Kind kind) {
+    return kind == VarDeclStmt::BOOL || kind == VarDeclStmt::INT || kind == VarDeclStmt::INT64 ||
+           kind == VarDeclStmt::FLOAT || kind == VarDeclStmt::DOUBLE;
+}
+
+VarDeclStmt::Kind TypeAnalyzer::elementType(VarDeclStmt::Kind containerKind) {
+    switch (containerKind) {
+        case VarDeclStmt::INT_ARRAY: return VarDeclStmt::INT;
+        case VarDeclStmt::FLOAT_ARRAY: return VarDeclStmt::FLOAT;
+        case VarDeclStmt::STRING_ARRAY: return VarDeclStmt::STRING;
+        case VarDeclStmt::INT64_ARRAY: return VarDeclStmt::INT64;
+        case VarDeclStmt::DOUBLE_ARRAY: return VarDeclStmt::DOUBLE;
+        case VarDeclStmt::CHAN_INT: return VarDeclStmt::INT;
+        case VarDeclStmt::CHAN_FLOAT: return VarDeclStmt::FLOAT;
+        case VarDeclStmt::CHAN_STRING: return VarDeclStmt::STRING;
+        case VarDeclStmt::MAP_INT: return VarDeclStmt::INT;
+        case VarDeclStmt::MAP_FLOAT: return VarDeclStmt::FLOAT;
+        case VarDeclStmt::MAP_STRING: return VarDeclStmt::STRING;
+        default: return VarDeclStmt::VOID;
+    }
+}
+
+VarDeclStmt::Kind TypeAnalyzer::chanTypeOf(VarDeclStmt::Kind elementKind) {
+    switch (elementKind) {
+        case VarDeclStmt::INT: return VarDeclStmt::CHAN_INT;
+        case VarDeclStmt::FLOAT: return VarDeclStmt::CHAN_FLOAT;
+        case VarDeclStmt::STRING: return VarDeclStmt::CHAN_STRING;
+        default:
+            std::cerr << "Error: los canales solo admiten int, float o string\n";
+            std::exit(1);
+    }
+}
+
+VarDeclStmt::Kind TypeAnalyzer::mapTypeOf(VarDeclStmt::Kind valueKind) {
+    switch (valueKind) {
+        case VarDeclStmt::INT: return VarDeclStmt::MAP_INT;
+        case VarDeclStmt::FLOAT: return VarDeclStmt::MAP_FLOAT;
+        case VarDeclStmt::STRING: return VarDeclStmt::MAP_STRING;
+        default:
+            std::cerr << "Error: los maps solo admiten valores int, float o string\n";
+            std::exit(1);
+    }
+}
+
+VarDeclStmt::Kind TypeAnalyzer::arrayTypeOf(VarDeclStmt::Kind elementKind) {
+    switch (elementKind) {
+        case VarDeclStmt::INT: return VarDeclStmt::INT_ARRAY;
+        case VarDeclStmt::FLOAT: return VarDeclStmt::FLOAT_ARRAY;
+        case VarDeclStmt::STRING: return VarDeclStmt::STRING_ARRAY;
+        case VarDeclStmt::INT64: return VarDeclStmt::INT64_ARRAY;
+        case VarDeclStmt::DOUBLE: return VarDeclStmt::DOUBLE_ARRAY;
+        case VarDeclStmt::BOOL:
+            std::cerr << "Error: arrays de bool no soportados\n";
+            std::exit(1);
+        default:
+            std::cerr << "Error: tipo de array no soportado\n";
+            std::exit(1);
+    }
+}
+
+VarDeclStmt::Kind TypeAnalyzer::promoteNumeric(VarDeclStmt::Kind left, VarDeclStmt::Kind right) {
+    if (left == VarDeclStmt::DOUBLE || right == VarDeclStmt::DOUBLE) {
+        return VarDeclStmt::DOUBLE;
+    }
+    if (left == VarDeclStmt::FLOAT || right == VarDeclStmt::FLOAT) {
+        // float cannot hold every int64; widen both to double
+        bool wide = left == VarDeclStmt::INT64 || right == VarDeclStmt::INT64;
+        return wide ? VarDeclStmt::DOUBLE : VarDeclStmt::FLOAT;
+    }
+    if (left == VarDeclStmt::INT64 || right == VarDeclStmt::INT64) {
+        return VarDeclStmt::INT64;
+    }
+    return VarDeclStmt::INT; // bools widen to int in arithmetic
+}
+
 VarDeclStmt::Kind TypeAnalyzer::inferType(const Expr *expr) {
     if (auto *lit = dynamic_cast<const LiteralExpr*>(expr)) {
         if (std::holds_alternative<int>(lit->value))
             return VarDeclStmt::INT;
-        if (std::holds_alternative<float>(lit->value))
+        if (std::holds_alternative<long long>(lit->value))
+            return VarDeclStmt::INT64;
+        if (std::holds_alternative<double>(lit->value))
             return VarDeclStmt::FLOAT;
         if (std::holds_alternative<std::string>(lit->value))
             return VarDeclStmt::STRING;
+        if (std::holds_alternative<bool>(lit->value))
+            return VarDeclStmt::BOOL;
     }
     if (auto *var = dynamic_cast<const VarExpr*>(expr)) {
         for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
@@ -47,41 +141,32 @@ VarDeclStmt::Kind TypeAnalyzer::inferType(const Expr *expr) {
         }
 
         // Array operations (array + array, array * array, array * scalar)
-        if ((left_type == VarDeclStmt::INT_ARRAY || left_type == VarDeclStmt::FLOAT_ARRAY) &&
-            (right_type == VarDeclStmt::INT_ARRAY || right_type == VarDeclStmt::FLOAT_ARRAY)) {
+        bool leftNumericArray = isArrayType(left_type) && left_type != VarDeclStmt::STRING_ARRAY;
+        bool rightNumericArray = isArrayType(right_type) && right_type != VarDeclStmt::STRING_ARRAY;
+        if (leftNumericArray && rightNumericArray) {
             // Array + Array or Array * Array
             if (bin->op == BinaryExpr::Op::ADD || bin->op == BinaryExpr::Op::MUL) {
-                if (left_type == VarDeclStmt::FLOAT_ARRAY || right_type == VarDeclStmt::FLOAT_ARRAY) {
-                    return VarDeclStmt::FLOAT_ARRAY;
-                }
-                return VarDeclStmt::INT_ARRAY;
+                return arrayTypeOf(promoteNumeric(elementType(left_type), elementType(right_type)));
             }
         }
         
         // Array * Scalar operations
-        if ((left_type == VarDeclStmt::INT_ARRAY || left_type == VarDeclStmt::FLOAT_ARRAY) &&
-            (right_type == VarDeclStmt::INT || right_type == VarDeclStmt::FLOAT)) {
+        if (leftNumericArray && isNumericType(right_type) && right_type != VarDeclStmt::BOOL) {
             if (bin->op == BinaryExpr::Op::MUL) {
-                if (left_type == VarDeclStmt::FLOAT_ARRAY || right_type == VarDeclStmt::FLOAT) {
-                    return VarDeclStmt::FLOAT_ARRAY;
-                }
-                return VarDeclStmt::INT_ARRAY;
+                return arrayTypeOf(promoteNumeric(elementType(left_type), right_type));
             }
         }
 
-        // Logical operations return INT (0 or 1)
+        // Logical operations and comparisons return BOOL (an i1)
         if (bin->op == BinaryExpr::Op::AND || bin->op == BinaryExpr::Op::OR ||
             bin->op == BinaryExpr::Op::EQ || bin->op == BinaryExpr::Op::NEQ ||
             bin->op == BinaryExpr::Op::LT || bin->op == BinaryExpr::Op::LE ||
             bin->op == BinaryExpr::Op::GT || bin->op == BinaryExpr::Op::GE) {
-            return VarDeclStmt::INT;
+            return VarDeclStmt::BOOL;
         }
 
         // Arithmetic operations
-        if (left_type == VarDeclStmt::FLOAT || right_type == VarDeclStmt::FLOAT) {
-            return VarDeclStmt::FLOAT;
-        }
-        return VarDeclStmt::INT;
+        return promoteNumeric(left_type, right_type);
     }
     if (auto *unary = dynamic_cast<const UnaryExpr*>(expr)) {
         return getVariableType(unary->varName);
@@ -91,42 +176,87 @@ VarDeclStmt::Kind TypeAnalyzer::inferType(const Expr *expr) {
             return VarDeclStmt::INT_ARRAY; // default
         }
         // Infer type from first element
-        auto firstType = inferType(array->elements[0].get());
-        switch (firstType) {
-            case VarDeclStmt::INT:
-                return VarDeclStmt::INT_ARRAY;
-            case VarDeclStmt::FLOAT:
-                return VarDeclStmt::FLOAT_ARRAY;
-            case VarDeclStmt::STRING:
-                return VarDeclStmt::STRING_ARRAY;
-            default:
-                std::cerr << "Error: tipo de array no soportado\n";
-                std::exit(1);
-        }
+        return arrayTypeOf(inferType(array->elements[0].get()));
     }
     if (auto *index = dynamic_cast<const IndexExpr*>(expr)) {
         auto arrayType = inferType(index->array.get());
-        switch (arrayType) {
-            case VarDeclStmt::INT_ARRAY:
-                return VarDeclStmt::INT;
-            case VarDeclStmt::FLOAT_ARRAY:
-                return VarDeclStmt::FLOAT;
-            case VarDeclStmt::STRING_ARRAY:
-                return VarDeclStmt::STRING;
-            case VarDeclStmt::STRING:
-                return VarDeclStmt::INT; // Character access
-            default:
-                std::cerr << "Error: indexación en tipo no-array\n";
+        if (arrayType == VarDeclStmt::STRING) {
+            return VarDeclStmt::INT; // Character access
+        }
+        if (isMapType(arrayType)) {
+            mapKeyCheck(index->index.get(), index->line, index->column);
+            return elementType(arrayType); // the zero value when the key is missing
+        }
+        if (!isArrayType(arrayType)) {
+            std::cerr << "Error: indexación en tipo no-array\n";
+            std::exit(1);
+        }
+        return elementType(arrayType);
+    }
+    if (auto *slice = dynamic_cast<const SliceExpr*>(expr)) {
+        auto arrayType = inferType(slice->array.get());
+        if (!isArrayType(arrayType)) {
+            std::cerr << "Error (line " << slice->line << ":" << slice->column
+                      << "): solo se pueden tomar slices de arrays\n";
+            std::exit(1);
+        }
+        return arrayType;
+    }
+    if (auto *chan = dynamic_cast<const ChanExpr*>(expr)) {
+        return chanTypeOf(chan->elemKind);
+    }
+    if (auto *map = dynamic_cast<const MapExpr*>(expr)) {
+        return mapTypeOf(map->valueKind);
+    }
+    if (auto *recv = dynamic_cast<const RecvExpr*>(expr)) {
+        VarDeclStmt::Kind elemKind = channelElementType(recv->chan.get(), recv->line, recv->column);
+        return recv->target.empty() ? elemKind : VarDeclStmt::BOOL;
+    }
+    if (auto *interp = dynamic_cast<const InterpExpr*>(expr)) {
+        for (const auto &hole : interp->holes) {
+            VarDeclStmt::Kind holeKind = inferType(hole.get());
+            if (holeKind != VarDeclStmt::STRING && !isNumericType(holeKind)) {
+                std::cerr << "Error (line " << hole->line << ":" << hole->column
+                          << "): solo se pueden interpolar números o strings\n";
                 std::exit(1);
+            }
         }
+        return VarDeclStmt::STRING;
     }
     if (auto *call = dynamic_cast<const CallExpr*>(expr)) {
-        auto it = functions.find(call->callee);
-        if (it != functions.end()) {
-            return it->second;
+        if (isLenBuiltin(call)) {
+            return VarDeclStmt::INT;
         }
-        std::cerr << "Error: función no declarada '" << call->callee << "'\n";
-        std::exit(1);
+        if (isMapBuiltin(call)) {
+            return call->callee == "has" ? VarDeclStmt::BOOL : VarDeclStmt::VOID;
+        }
+        if (isFileBuiltin(call)) {
+            if (call->callee == "readFile") return VarDeclStmt::STRING;
+            if (call->callee == "mapInts") return VarDeclStmt::INT_ARRAY;
+            if (call->callee == "mapFloats") return VarDeclStmt::FLOAT_ARRAY;
+            std::cerr << "Error (line " << call->line << ":" << call->column
+                      << "): lines(ruta) solo puede recorrerse con for linea in lines(ruta)\n";
+            std::exit(1);
+        }
+        if (isReadBuiltin(call)) {
+            if (call->callee == "readInt") return VarDeclStmt::INT;
+            if (call->callee == "readFloat") return VarDeclStmt::FLOAT;
+            return VarDeclStmt::STRING;
+        }
+        if (isBuilderBuiltin(call)) {
+            if (call->callee == "builder") return VarDeclStmt::BUILDER;
+            if (call->callee == "toString") return VarDeclStmt::STRING;
+            return VarDeclStmt::VOID;
+        }
+        if (!hasFunction(call->callee)) {
+            std::cerr << "Error: función no declarada '" << call->callee << "'\n";
+            std::exit(1);
+        }
+        std::vector<VarDeclStmt::Kind> argTypes;
+        for (const auto &arg : call->args) {
+            argTypes.push_back(inferType(arg.get()));
+        }
+        return inferReturnType(call->callee, argTypes);
     }
     return VarDeclStmt::INT; // default
 }
@@ -135,13 +265,71 @@ void TypeAnalyzer::declareFunction(const std::string &name, VarDeclStmt::Kind re
     functions[name] = returnType;
 }
 
-void TypeAnalyzer::setFunctionParams(const std::string &name, const std::vector<VarDeclStmt::Kind> &paramTypes) {
-    functionParams[name] = paramTypes;
+void TypeAnalyzer::registerFunction(const FunctionStmt *funcStmt) {
+    functionDecls[funcStmt->name] = funcStmt;
+    // `fun` return types are inferred per call signature (inferReturnType)
+    declareFunction(funcStmt->name, funcStmt->inference ? VarDeclStmt::VOID : funcStmt->retType);
 }
 
-std::vector<VarDeclStmt::Kind> TypeAnalyzer::getFunctionParams(const std::string &name) {
-    auto it = functionParams.find(name);
-    if (it != functionParams.end()) {
+VarDeclStmt::Kind TypeAnalyzer::inferReturnType(const std::string &name, const std::vector<VarDeclStmt::Kind> &argTypes) {
+    auto declIt = functionDecls.find(name);
+    if (declIt == functionDecls.end() || !declIt->second->inference) {
+        return getFunctionReturnType(name);
+    }
+
+    Signature signature(name, argTypes);
+    auto known = returnTypes.find(signature);
+    if (known != returnTypes.end()) {
+        // Reading a signature still being inferred makes the reader's result
+        // depend on that approximation
+        for (size_t slot = 0; slot < inferenceStack.size(); ++slot) {
+            if (inferenceStack[slot] == signature && slot < lowestDependency) {
+                lowestDependency = slot;
+            }
+        }
+        return known->second;
+    }
+
+    size_t depth = inferenceStack.size();
+    size_t outerDependency = lowestDependency;
+    inferenceStack.push_back(signature);
+    returnTypes[signature] = VarDeclStmt::VOID;
+
+    // Iterate the body until the return type stops growing. Results of other
+    // signatures computed from a stale approximation are discarded each round
+    VarDeclStmt::Kind result;
+    while (true) {
+        size_t tentativeMark = tentativeReturnTypes.size();
+        lowestDependency = SIZE_MAX;
+        result = analyzeReturnType(declIt->second, argTypes);
+        if (result == returnTypes[signature]) break;
+        returnTypes[signature] = result;
+        for (size_t i = tentativeMark; i < tentativeReturnTypes.size(); ++i) {
+            returnTypes.erase(tentativeReturnTypes[i]);
+        }
+        tentativeReturnTypes.resize(tentativeMark);
+    }
+    inferenceStack.pop_back();
+
+    // Mutual recursion: the result is only final once the outer signature is
+    if (lowestDependency < depth) {
+        tentativeReturnTypes.push_back(signature);
+    }
+    lowestDependency = std::min(outerDependency, lowestDependency);
+    return result;
+}
+
+void TypeAnalyzer::addFunctionSignature(const std::string &name, const std::vector<VarDeclStmt::Kind> &paramTypes) {
+    auto &signatures = functionSignatures[name];
+    for (const auto &signature : signatures) {
+        if (signature == paramTypes) return;
+    }
+    signatures.push_back(paramTypes);
+}
+
+std::vector<std::vector<VarDeclStmt::Kind>> TypeAnalyzer::getFunctionSignatures(const std::string &name) {
+    auto it = functionSignatures.find(name);
+    if (it != functionSignatures.end()) {
         return it->second;
     }
     return {}; // Return empty vector if function not found
@@ -151,6 +339,97 @@ bool TypeAnalyzer::hasFunction(const std::string &name) {
     return functions.find(name) != functions.end();
 }
 
+// len(a) is built in unless the program declares its own `len`
+bool TypeAnalyzer::isLenBuiltin(const CallExpr *call) {
+    if (call->callee != "len" || hasFunction("len")) return false;
+    if (call->args.size() != 1) {
+        std::cerr << "Error (line " << call->line << ":" << call->column
+                  << "): len espera un único argumento de tipo array o map\n";
+        std::exit(1);
+    }
+    VarDeclStmt::Kind kind = inferType(call->args[0].get());
+    if (!isArrayType(kind) && !isMapType(kind)) {
+        std::cerr << "Error (line " << call->line << ":" << call->column
+                  << "): len espera un único argumento de tipo array o map\n";
+        std::exit(1);
+    }
+    return true;
+}
+
+// has(m, k) and delete(m, k), likewise unless the program declares its own
+bool TypeAnalyzer::isMapBuiltin(const CallExpr *call) {
+    if ((call->callee != "has" && call->callee != "delete") || hasFunction(call->callee)) return false;
+    if (call->args.size() != 2 || !isMapType(inferType(call->args[0].get()))) {
+        std::cerr << "Error (line " << call->line << ":" << call->column << "): " << call->callee
+                  << " espera un map y una clave\n";
+        std::exit(1);
+    }
+    mapKeyCheck(call->args[1].get(), call->line, call->column);
+    return true;
+}
+
+// readFile(path), mapInts(path), mapFloats(path) and lines(path)
+bool TypeAnalyzer::isFileBuiltin(const CallExpr *call) {
+    const std::string &name = call->callee;
+    if ((name != "readFile" && name != "mapInts" && name != "mapFloats" && name != "lines") || hasFunction(name)) {
+        return false;
+    }
+    if (call->args.size() != 1 || inferType(call->args[0].get()) != VarDeclStmt::STRING) {
+        std::cerr << "Error (line " << call->line << ":" << call->column << "): " << name
+                  << " espera la ruta de un archivo (string)\n";
+        std::exit(1);
+    }
+    return true;
+}
+
+// readInt(), readFloat() and readLine() from standard input
+bool TypeAnalyzer::isReadBuiltin(const CallExpr *call) {
+    const std::string &name = call->callee;
+    if ((name != "readInt" && name != "readFloat" && name != "readLine") || hasFunction(name)) {
+        return false;
+    }
+    if (!call->args.empty()) {
+        std::cerr << "Error (line " << call->line << ":" << call->column << "): " << name
+                  << " no recibe argumentos\n";
+        std::exit(1);
+    }
+    return true;
+}
+
+bool TypeAnalyzer::isBuilderBuiltin(const CallExpr *call) {
+    const std::string &name = call->callee;
+    if ((name != "builder" && name != "append" && name != "toString") || hasFunction(name)) {
+        return false;
+    }
+    size_t arity = name == "builder" ? 0 : name == "append" ? 2 : 1;
+    bool valid = call->args.size() == arity &&
+                 (arity == 0 || inferType(call->args[0].get()) == VarDeclStmt::BUILDER);
+    if (valid && arity == 2) {
+        VarDeclStmt::Kind valueKind = inferType(call->args[1].get());
+        valid = isNumericType(valueKind) || valueKind == VarDeclStmt::STRING;
+    }
+    if (!valid) {
+        std::cerr << "Error (line " << call->line << ":" << call->column << "): ";
+        if (name == "builder") std::cerr << "builder no recibe argumentos\n";
+        else if (name == "append") std::cerr << "append espera un builder y un número o string\n";
+        else std::cerr << "toString espera un builder\n";
+        std::exit(1);
+    }
+    return true;
+}
+
+bool TypeAnalyzer::isLinesIterable(const Expr *expr) {
+    auto *call = dynamic_cast<const CallExpr*>(expr);
+    return call && call->callee == "lines" && isFileBuiltin(call);
+}
+
+void TypeAnalyzer::mapKeyCheck(const Expr *key, int line, int column) {
+    if (inferType(key) != VarDeclStmt::STRING) {
+        std::cerr << "Error (line " << line << ":" << column << "): las claves de un map deben ser string\n";
+        std::exit(1);
+    }
+}
+
 void TypeAnalyzer::declareVariable(const std::string &name, VarDeclStmt::Kind type) {
     if (!scopes.empty()) {
         scopes.back()[name] = type;
@@ -177,19 +456,18 @@ bool TypeAnalyzer::hasVariable(const std::string &name) {
     return false;
 }
 
-void TypeAnalyzer::analyzeCallExpr(const CallExpr *call) {
-    if (!hasFunction(call->callee)) {
-        return; // Function not declared yet
-    }
-
+std::vector<VarDeclStmt::Kind> TypeAnalyzer::analyzeCallExpr(const CallExpr *call) {
     std::vector<VarDeclStmt::Kind> paramTypes;
     for (const auto &arg : call->args) {
         VarDeclStmt::Kind argType = inferType(arg.get());
         paramTypes.push_back(argType);
     }
 
-    // Update function parameter types
-    setFunctionParams(call->callee, paramTypes);
+    // Every distinct argument-type tuple gets its own specialization
+    if (hasFunction(call->callee)) {
+        addFunctionSignature(call->callee, paramTypes);
+    }
+    return paramTypes;
 }
 
 void TypeAnalyzer::analyzeExpression(const Expr *expr) {
@@ -201,10 +479,24 @@ void TypeAnalyzer::analyzeExpression(const Expr *expr) {
     } else if (auto *index = dynamic_cast<const IndexExpr*>(expr)) {
         analyzeExpression(index->array.get());
         analyzeExpression(index->index.get());
+    } else if (auto *slice = dynamic_cast<const SliceExpr*>(expr)) {
+        analyzeExpression(slice->array.get());
+        if (slice->lo) analyzeExpression(slice->lo.get());
+        if (slice->hi) analyzeExpression(slice->hi.get());
     } else if (auto *array = dynamic_cast<const ArrayExpr*>(expr)) {
         for (const auto &elem : array->elements) {
             analyzeExpression(elem.get());
         }
+    } else if (auto *chan = dynamic_cast<const ChanExpr*>(expr)) {
+        analyzeExpression(chan->capacity.get());
+    } else if (auto *map = dynamic_cast<const MapExpr*>(expr)) {
+        if (map->sizeHint) analyzeExpression(map->sizeHint.get());
+    } else if (auto *recv = dynamic_cast<const RecvExpr*>(expr)) {
+        analyzeExpression(recv->chan.get());
+    } else if (auto *interp = dynamic_cast<const InterpExpr*>(expr)) {
+        for (const auto &hole : interp->holes) {
+            analyzeExpression(hole.get());
+        }
     }
 }
 
@@ -213,12 +505,22 @@ void TypeAnalyzer::analyzeStatement(const Stmt *stmt) {
         analyzeExpression(print->expr.get());
     } else if (auto *assign = dynamic_cast<const AssignStmt*>(stmt)) {
         analyzeExpression(assign->expr.get());
+    } else if (auto *indexAssign = dynamic_cast<const IndexAssignStmt*>(stmt)) {
+        analyzeExpression(indexAssign->index.get());
+        analyzeExpression(indexAssign->expr.get());
     } else if (auto *varDecl = dynamic_cast<const VarDeclStmt*>(stmt)) {
         analyzeExpression(varDecl->init.get());
     } else if (auto *inferDecl = dynamic_cast<const InferDeclStmt*>(stmt)) {
         analyzeExpression(inferDecl->init.get());
     } else if (auto *exprStmt = dynamic_cast<const ExprStmt*>(stmt)) {
         analyzeExpression(exprStmt->expr.get());
+    } else if (auto *goStmt = dynamic_cast<const GoStmt*>(stmt)) {
+        analyzeExpression(goStmt->call.get());
+    } else if (auto *send = dynamic_cast<const SendStmt*>(stmt)) {
+        analyzeExpression(send->chan.get());
+        analyzeExpression(send->value.get());
+    } else if (auto *closeStmt = dynamic_cast<const CloseStmt*>(stmt)) {
+        analyzeExpression(closeStmt->chan.get());
     } else if (auto *ifStmt = dynamic_cast<const IfStmt*>(stmt)) {
         analyzeExpression(ifStmt->cond.get());
         for (const auto &thenStmt : ifStmt->thenBranch) {
@@ -239,6 +541,11 @@ void TypeAnalyzer::analyzeStatement(const Stmt *stmt) {
         for (const auto &bodyStmt : forStmt->body) {
             analyzeStatement(bodyStmt.get());
         }
+    } else if (auto *forIn = dynamic_cast<const ForInStmt*>(stmt)) {
+        analyzeExpression(forIn->iterable.get());
+        for (const auto &bodyStmt : forIn->body) {
+            analyzeStatement(bodyStmt.get());
+        }
     } else if (auto *funcStmt = dynamic_cast<const FunctionStmt*>(stmt)) {
         for (const auto &bodyStmt : funcStmt->body) {
             analyzeStatement(bodyStmt.get());
@@ -250,6 +557,44 @@ void TypeAnalyzer::analyzeStatement(const Stmt *stmt) {
     }
 }
 
+VarDeclStmt::Kind TypeAnalyzer::channelElementType(const Expr *chanExpr, int line, int column) {
+    VarDeclStmt::Kind kind = inferType(chanExpr);
+    if (!isChanType(kind)) {
+        std::cerr << "Error (line " << line << ":" << column << "): se esperaba un canal\n";
+        std::exit(1);
+    }
+    return elementType(kind);
+}
+
+VarDeclStmt::Kind TypeAnalyzer::analyzeSend(const SendStmt *stmt) {
+    VarDeclStmt::Kind elemKind = channelElementType(stmt->chan.get(), stmt->line, stmt->column);
+    VarDeclStmt::Kind valueKind = inferType(stmt->value.get());
+    bool compatible = (elemKind == VarDeclStmt::STRING) ? valueKind == VarDeclStmt::STRING
+                                                        : isNumericType(valueKind);
+    if (!compatible) {
+        std::cerr << "Error (line " << stmt->line << ":" << stmt->column
+                  << "): el valor enviado no es compatible con el tipo del canal\n";
+        std::exit(1);
+    }
+    return elemKind;
+}
+
+VarDeclStmt::Kind TypeAnalyzer::forInElementType(const ForInStmt *stmt) {
+    if (isLinesIterable(stmt->iterable.get())) {
+        return VarDeclStmt::STRING;
+    }
+    VarDeclStmt::Kind kind = inferType(stmt->iterable.get());
+    if (isMapType(kind)) {
+        return VarDeclStmt::STRING; // the keys
+    }
+    if (!isArrayType(kind) && !isChanType(kind)) {
+        std::cerr << "Error (line " << stmt->line << ":" << stmt->column
+                  << "): for-in solo puede recorrer arrays, canales o maps\n";
+        std::exit(1);
+    }
+    return elementType(kind);
+}
+
 bool TypeAnalyzer::hasExplicitReturn(const std::vector<StmtPtr> &body) {
     for (const auto &stmt : body) {
         if (dynamic_cast<const ReturnStmt*>(stmt.get())) {
@@ -271,10 +616,84 @@ bool TypeAnalyzer::hasExplicitReturn(const std::vector<StmtPtr> &body) {
                 return true;
             }
         }
+        else if (auto *forIn = dynamic_cast<const ForInStmt*>(stmt.get())) {
+            if (hasExplicitReturn(forIn->body)) {
+                return true;
+            }
+        }
     }
     return false;
 }
 
+VarDeclStmt::Kind TypeAnalyzer::analyzeReturnType(const FunctionStmt *funcStmt, const std::vector<VarDeclStmt::Kind> &argTypes) {
+    pushScope();
+    for (size_t i = 0; i < funcStmt->params.size() && i < argTypes.size(); ++i) {
+        declareVariable(funcStmt->params[i], argTypes[i]);
+    }
+
+    // Seed with the current approximation so each round can only grow
+    VarDeclStmt::Kind result = returnTypes[Signature(funcStmt->name, argTypes)];
+    for (const auto &stmt : funcStmt->body) {
+        collectReturnTypes(stmt.get(), funcStmt->name, result);
+    }
+    popScope();
+    return result;
+}
+
+void TypeAnalyzer::collectReturnTypes(const Stmt *stmt, const std::string &functionName, VarDeclStmt::Kind &result) {
+    if (auto *varDecl = dynamic_cast<const VarDeclStmt*>(stmt)) {
+        declareVariable(varDecl->name, varDecl->type);
+    } else if (auto *inferDecl = dynamic_cast<const InferDeclStmt*>(stmt)) {
+        declareVariable(inferDecl->name, inferType(inferDecl->init.get()));
+    } else if (auto *ifStmt = dynamic_cast<const IfStmt*>(stmt)) {
+        pushScope();
+        for (const auto &thenStmt : ifStmt->thenBranch) {
+            collectReturnTypes(thenStmt.get(), functionName, result);
+        }
+        popScope();
+        pushScope();
+        for (const auto &elseStmt : ifStmt->elseBranch) {
+            collectReturnTypes(elseStmt.get(), functionName, result);
+        }
+        popScope();
+    } else if (auto *whileStmt = dynamic_cast<const WhileStmt*>(stmt)) {
+        pushScope();
+        for (const auto &bodyStmt : whileStmt->body) {
+            collectReturnTypes(bodyStmt.get(), functionName, result);
+        }
+        popScope();
+    } else if (auto *forStmt = dynamic_cast<const ForStmt*>(stmt)) {
+        pushScope();
+        if (forStmt->init) collectReturnTypes(forStmt->init.get(), functionName, result);
+        for (const auto &bodyStmt : forStmt->body) {
+            collectReturnTypes(bodyStmt.get(), functionName, result);
+        }
+        popScope();
+    } else if (auto *forIn = dynamic_cast<const ForInStmt*>(stmt)) {
+        VarDeclStmt::Kind elemKind = forInElementType(forIn);
+        pushScope();
+        declareVariable(forIn->var, elemKind);
+        for (const auto &bodyStmt : forIn->body) {
+            collectReturnTypes(bodyStmt.get(), functionName, result);
+        }
+        popScope();
+    } else if (auto *retStmt = dynamic_cast<const ReturnStmt*>(stmt)) {
+        if (!retStmt->value) return;
+
+        // Join: VOID is the bottom, numbers follow promoteNumeric, anything
+        // else must agree
+        VarDeclStmt::Kind kind = inferType(retStmt->value.get());
+        if (result == VarDeclStmt::VOID || result == kind || kind == VarDeclStmt::VOID) {
+            result = (kind == VarDeclStmt::VOID) ? result : kind;
+        } else if (isNumericType(result) && isNumericType(kind)) {
+            result = promoteNumeric(result, kind);
+        } else {
+            std::cerr << "Error: la función '" << functionName << "' retorna valores de tipos incompatibles\n";
+            std::exit(1);
+        }
+    }
+}
+
 VarDeclStmt::Kind TypeAnalyzer::getFunctionReturnType(const std::string &name) {
     auto it = functions.find(name);
     if (it != functions.end()) {
@@ -284,13 +703,17 @@ VarDeclStmt::Kind TypeAnalyzer::getFunctionReturnType(const std::string &name) {
 }
 
 void TypeAnalyzer::validateFunctionScopes(const FunctionStmt *funcStmt) {
-    std::cout << "Validando función: " << funcStmt->name << std::endl;
+    if (verbose) std::cout << "Validando función: " << funcStmt->name << std::endl;
     
     // Create a map of local variables (parameters only, no access to main variables)
     std::map<std::string, VarDeclStmt::Kind> localVars;
     
     // Add function parameters to local scope
-    std::vector<VarDeclStmt::Kind> paramTypes = getFunctionParams(funcStmt->name);
+    std::vector<VarDeclStmt::Kind> paramTypes;
+    auto signatures = getFunctionSignatures(funcStmt->name);
+    if (!signatures.empty()) {
+        paramTypes = signatures.front();
+    }
     for (size_t i = 0; i < funcStmt->params.size(); ++i) {
         // Default to INT if no explicit type information available
         VarDeclStmt::Kind paramType = VarDeclStmt::INT;
@@ -352,6 +775,11 @@ void TypeAnalyzer::validateExpressionInFunctionScope(const Expr *expr, const std
         validateExpressionInFunctionScope(index->array.get(), localVars, functionName);
         validateExpressionInFunctionScope(index->index.get(), localVars, functionName);
     }
+    else if (auto *slice = dynamic_cast<const SliceExpr*>(expr)) {
+        validateExpressionInFunctionScope(slice->array.get(), localVars, functionName);
+        if (slice->lo) validateExpressionInFunctionScope(slice->lo.get(), localVars, functionName);
+        if (slice->hi) validateExpressionInFunctionScope(slice->hi.get(), localVars, functionName);
+    }
     else if (auto *array = dynamic_cast<const ArrayExpr*>(expr)) {
         for (const auto &elem : array->elements) {
             validateExpressionInFunctionScope(elem.get(), localVars, functionName);
@@ -365,9 +793,37 @@ void TypeAnalyzer::validateExpressionInFunctionScope(const Expr *expr, const std
             std::exit(1);
         }
     }
+    else if (auto *chan = dynamic_cast<const ChanExpr*>(expr)) {
+        validateExpressionInFunctionScope(chan->capacity.get(), localVars, functionName);
+    }
+    else if (auto *map = dynamic_cast<const MapExpr*>(expr)) {
+        if (map->sizeHint) validateExpressionInFunctionScope(map->sizeHint.get(), localVars, functionName);
+    }
+    else if (auto *recv = dynamic_cast<const RecvExpr*>(expr)) {
+        validateExpressionInFunctionScope(recv->chan.get(), localVars, functionName);
+        if (!recv->target.empty() && localVars.find(recv->target) == localVars.end()) {
+            std::cerr << "Error de scope en función '" << functionName << "': ";
+            std::cerr << "variable '" << recv->target << "' no está accesible desde esta función.\n";
+            std::exit(1);
+        }
+    }
+    else if (auto *interp = dynamic_cast<const InterpExpr*>(expr)) {
+        for (const auto &hole : interp->holes) {
+            validateExpressionInFunctionScope(hole.get(), localVars, functionName);
+        }
+    }
     // Literals are always OK - no validation needed
 }
 
+// Declarations inside a block stay visible to the rest of that block
+static void recordLocalDeclaration(const Stmt *stmt, std::map<std::string, VarDeclStmt::Kind> &localVars) {
+    if (auto *varDecl = dynamic_cast<const VarDeclStmt*>(stmt)) {
+        localVars[varDecl->name] = varDecl->type;
+    } else if (auto *inferDecl = dynamic_cast<const InferDeclStmt*>(stmt)) {
+        localVars[inferDecl->name] = VarDeclStmt::INT;
+    }
+}
+
 void TypeAnalyzer::validateStatementInFunctionScope(const Stmt *stmt, const std::map<std::string, VarDeclStmt::Kind> &localVars, const std::string &functionName) {
     std::map<std::string, VarDeclStmt::Kind> updatedLocalVars = localVars;
     
@@ -392,25 +848,50 @@ void TypeAnalyzer::validateStatementInFunctionScope(const Stmt *stmt, const std:
         }
         validateExpressionInFunctionScope(assign->expr.get(), updatedLocalVars, functionName);
     }
+    else if (auto *indexAssign = dynamic_cast<const IndexAssignStmt*>(stmt)) {
+        if (updatedLocalVars.find(indexAssign->name) == updatedLocalVars.end()) {
+            std::cerr << "Error de scope en función '" << functionName << "': ";
+            std::cerr << "variable '" << indexAssign->name << "' no está accesible desde esta función.\n";
+            std::exit(1);
+        }
+        validateExpressionInFunctionScope(indexAssign->index.get(), updatedLocalVars, functionName);
+        validateExpressionInFunctionScope(indexAssign->expr.get(), updatedLocalVars, functionName);
+    }
     else if (auto *print = dynamic_cast<const PrintStmt*>(stmt)) {
         validateExpressionInFunctionScope(print->expr.get(), updatedLocalVars, functionName);
     }
     else if (auto *exprStmt = dynamic_cast<const ExprStmt*>(stmt)) {
         validateExpressionInFunctionScope(exprStmt->expr.get(), updatedLocalVars, functionName);
     }
+    else if (auto *goStmt = dynamic_cast<const GoStmt*>(stmt)) {
+        validateExpressionInFunctionScope(goStmt->call.get(), updatedLocalVars, functionName);
+    }
+    else if (auto *send = dynamic_cast<const SendStmt*>(stmt)) {
+        validateExpressionInFunctionScope(send->chan.get(), updatedLocalVars, functionName);
+        validateExpressionInFunctionScope(send->value.get(), updatedLocalVars, functionName);
+    }
+    else if (auto *closeStmt = dynamic_cast<const CloseStmt*>(stmt)) {
+        validateExpressionInFunctionScope(closeStmt->chan.get(), updatedLocalVars, functionName);
+    }
     else if (auto *ifStmt = dynamic_cast<const IfStmt*>(stmt)) {
         validateExpressionInFunctionScope(ifStmt->cond.get(), updatedLocalVars, functionName);
+        std::map<std::string, VarDeclStmt::Kind> thenLocalVars = updatedLocalVars;
         for (const auto &thenStmt : ifStmt->thenBranch) {
-            validateStatementInFunctionScope(thenStmt.get(), updatedLocalVars, functionName);
+            validateStatementInFunctionScope(thenStmt.get(), thenLocalVars, functionName);
+            recordLocalDeclaration(thenStmt.get(), thenLocalVars);
         }
+        std::map<std::string, VarDeclStmt::Kind> elseLocalVars = updatedLocalVars;
         for (const auto &elseStmt : ifStmt->elseBranch) {
-            validateStatementInFunctionScope(elseStmt.get(), updatedLocalVars, functionName);
+            validateStatementInFunctionScope(elseStmt.get(), elseLocalVars, functionName);
+            recordLocalDeclaration(elseStmt.get(), elseLocalVars);
         }
     }
     else if (auto *whileStmt = dynamic_cast<const WhileStmt*>(stmt)) {
         validateExpressionInFunctionScope(whileStmt->cond.get(), updatedLocalVars, functionName);
+        std::map<std::string, VarDeclStmt::Kind> bodyLocalVars = updatedLocalVars;
         for (const auto &bodyStmt : whileStmt->body) {
-            validateStatementInFunctionScope(bodyStmt.get(), updatedLocalVars, functionName);
+            validateStatementInFunctionScope(bodyStmt.get(), bodyLocalVars, functionName);
+            recordLocalDeclaration(bodyStmt.get(), bodyLocalVars);
         }
     }
     else if (auto *forStmt = dynamic_cast<const ForStmt*>(stmt)) {
@@ -424,8 +905,8 @@ void TypeAnalyzer::validateStatementInFunctionScope(const Stmt *stmt, const std:
                 forLocalVars[varDecl->name] = varDecl->type;
             } else if (auto *inferDecl = dynamic_cast<const InferDeclStmt*>(forStmt->init.get())) {
                 validateExpressionInFunctionScope(inferDecl->init.get(), forLocalVars, functionName);
-                VarDeclStmt::Kind inferredType = inferType(inferDecl->init.get());
-                forLocalVars[inferDecl->name] = inferredType;
+                // Parameters are not in the analyzer's scopes here; only the name matters
+                forLocalVars[inferDecl->name] = VarDeclStmt::INT;
             } else {
                 validateStatementInFunctionScope(forStmt->init.get(), forLocalVars, functionName);
             }
@@ -434,6 +915,16 @@ void TypeAnalyzer::validateStatementInFunctionScope(const Stmt *stmt, const std:
         if (forStmt->post) validateStatementInFunctionScope(forStmt->post.get(), forLocalVars, functionName);
         for (const auto &bodyStmt : forStmt->body) {
             validateStatementInFunctionScope(bodyStmt.get(), forLocalVars, functionName);
+            recordLocalDeclaration(bodyStmt.get(), forLocalVars);
+        }
+    }
+    else if (auto *forIn = dynamic_cast<const ForInStmt*>(stmt)) {
+        validateExpressionInFunctionScope(forIn->iterable.get(), updatedLocalVars, functionName);
+        std::map<std::string, VarDeclStmt::Kind> bodyLocalVars = updatedLocalVars;
+        bodyLocalVars[forIn->var] = VarDeclStmt::INT; // only the name matters here
+        for (const auto &bodyStmt : forIn->body) {
+            validateStatementInFunctionScope(bodyStmt.get(), bodyLocalVars, functionName);
+            recordLocalDeclaration(bodyStmt.get(), bodyLocalVars);
         }
     }
     else if (auto *retStmt = dynamic_cast<const ReturnStmt*>(stmt)) {
@@ -442,3 +933,144 @@ void TypeAnalyzer::validateStatementInFunctionScope(const Stmt *stmt, const std:
         }
     }
 }
+
+void TypeAnalyzer::validateParallelBody(const ForStmt *forStmt) {
+    std::set<std::string> locals;
+    for (const auto &bodyStmt : forStmt->body) {
+        validateParallelStatement(bodyStmt.get(), locals);
+    }
+}
+
+void TypeAnalyzer::validateParallelStatement(const Stmt *stmt, std::set<std::string> &locals) {
+    if (auto *varDecl = dynamic_cast<const VarDeclStmt*>(stmt)) {
+        validateParallelExpression(varDecl->init.get(), locals);
+        locals.insert(varDecl->name);
+    } else if (auto *inferDecl = dynamic_cast<const InferDeclStmt*>(stmt)) {
+        validateParallelExpression(inferDecl->init.get(), locals);
+        locals.insert(inferDecl->name);
+    } else if (auto *assign = dynamic_cast<const AssignStmt*>(stmt)) {
+        if (locals.count(assign->name) == 0) {
+            std::cerr << "Error: no se puede asignar la variable compartida '" << assign->name
+                      << "' dentro de un parallel for (línea " << assign->line << ")\n";
+            std::exit(1);
+        }
+        validateParallelExpression(assign->expr.get(), locals);
+    } else if (auto *indexAssign = dynamic_cast<const IndexAssignStmt*>(stmt)) {
+        // Array elements are disjoint per iteration; a map's table is not
+        if (locals.count(indexAssign->name) == 0 && hasVariable(indexAssign->name) &&
+            isMapType(getVariableType(indexAssign->name))) {
+            std::cerr << "Error: no se puede modificar el map compartido '" << indexAssign->name
+                      << "' dentro de un parallel for (línea " << indexAssign->line << ")\n";
+            std::exit(1);
+        }
+        validateParallelExpression(indexAssign->index.get(), locals);
+        validateParallelExpression(indexAssign->expr.get(), locals);
+    } else if (auto *print = dynamic_cast<const PrintStmt*>(stmt)) {
+        validateParallelExpression(print->expr.get(), locals);
+    } else if (auto *exprStmt = dynamic_cast<const ExprStmt*>(stmt)) {
+        validateParallelExpression(exprStmt->expr.get(), locals);
+    } else if (auto *goStmt = dynamic_cast<const GoStmt*>(stmt)) {
+        validateParallelExpression(goStmt->call.get(), locals);
+    } else if (auto *send = dynamic_cast<const SendStmt*>(stmt)) {
+        validateParallelExpression(send->chan.get(), locals);
+        validateParallelExpression(send->value.get(), locals);
+    } else if (auto *closeStmt = dynamic_cast<const CloseStmt*>(stmt)) {
+        validateParallelExpression(closeStmt->chan.get(), locals);
+    } else if (auto *ifStmt = dynamic_cast<const IfStmt*>(stmt)) {
+        validateParallelExpression(ifStmt->cond.get(), locals);
+        std::set<std::string> thenLocals = locals;
+        for (const auto &thenStmt : ifStmt->thenBranch) {
+            validateParallelStatement(thenStmt.get(), thenLocals);
+        }
+        std::set<std::string> elseLocals = locals;
+        for (const auto &elseStmt : ifStmt->elseBranch) {
+            validateParallelStatement(elseStmt.get(), elseLocals);
+        }
+    } else if (auto *whileStmt = dynamic_cast<const WhileStmt*>(stmt)) {
+        validateParallelExpression(whileStmt->cond.get(), locals);
+        std::set<std::string> bodyLocals = locals;
+        for (const auto &bodyStmt : whileStmt->body) {
+            validateParallelStatement(bodyStmt.get(), bodyLocals);
+        }
+    } else if (auto *forStmt = dynamic_cast<const ForStmt*>(stmt)) {
+        std::set<std::string> forLocals = locals;
+        if (forStmt->init) validateParallelStatement(forStmt->init.get(), forLocals);
+        if (forStmt->cond) validateParallelExpression(forStmt->cond.get(), forLocals);
+        if (forStmt->post) validateParallelStatement(forStmt->post.get(), forLocals);
+        for (const auto &bodyStmt : forStmt->body) {
+            validateParallelStatement(bodyStmt.get(), forLocals);
+        }
+    } else if (auto *forIn = dynamic_cast<const ForInStmt*>(stmt)) {
+        validateParallelExpression(forIn->iterable.get(), locals);
+        std::set<std::string> bodyLocals = locals;
+        bodyLocals.insert(forIn->var);
+        for (const auto &bodyStmt : forIn->body) {
+            validateParallelStatement(bodyStmt.get(), bodyLocals);
+        }
+    } else if (dynamic_cast<const ReturnStmt*>(stmt)) {
+        std::cerr << "Error: 'return' no está permitido dentro de un parallel for (línea " << stmt->line << ")\n";
+        std::exit(1);
+    } else if (dynamic_cast<const FunctionStmt*>(stmt)) {
+        std::cerr << "Error: no se pueden declarar funciones dentro de un parallel for (línea " << stmt->line << ")\n";
+        std::exit(1);
+    }
+}
+
+void TypeAnalyzer::validateParallelExpression(const Expr *expr, const std::set<std::string> &locals) {
+    if (!expr) return;
+    if (auto *unary = dynamic_cast<const UnaryExpr*>(expr)) {
+        if (locals.count(unary->varName) == 0) {
+            std::cerr << "Error: no se puede modificar la variable compartida '" << unary->varName
+                      << "' dentro de un parallel for (línea " << unary->line << ")\n";
+            std::exit(1);
+        }
+    } else if (auto *bin = dynamic_cast<const BinaryExpr*>(expr)) {
+        validateParallelExpression(bin->left.get(), locals);
+        validateParallelExpression(bin->right.get(), locals);
+    } else if (auto *index = dynamic_cast<const IndexExpr*>(expr)) {
+        validateParallelExpression(index->array.get(), locals);
+        validateParallelExpression(index->index.get(), locals);
+    } else if (auto *slice = dynamic_cast<const SliceExpr*>(expr)) {
+        validateParallelExpression(slice->array.get(), locals);
+        validateParallelExpression(slice->lo.get(), locals);
+        validateParallelExpression(slice->hi.get(), locals);
+    } else if (auto *array = dynamic_cast<const ArrayExpr*>(expr)) {
+        for (const auto &elem : array->elements) {
+            validateParallelExpression(elem.get(), locals);
+        }
+    } else if (auto *call = dynamic_cast<const CallExpr*>(expr)) {
+        if (call->callee == "delete" && !hasFunction("delete") && !call->args.empty()) {
+            auto *map = dynamic_cast<const VarExpr*>(call->args[0].get());
+            if (!map || locals.count(map->name) == 0) {
+                std::cerr << "Error: no se puede modificar un map compartido dentro de un parallel for (línea "
+                          << call->line << ")\n";
+                std::exit(1);
+            }
+        }
+        if ((call->callee == "append" || call->callee == "toString") && !hasFunction(call->callee) &&
+            !call->args.empty()) {
+            auto *target = dynamic_cast<const VarExpr*>(call->args[0].get());
+            if (!target || locals.count(target->name) == 0) {
+                std::cerr << "Error: no se puede modificar un builder compartido dentro de un parallel for (línea "
+                          << call->line << ")\n";
+                std::exit(1);
+            }
+        }
+        for (const auto &arg : call->args) {
+            validateParallelExpression(arg.get(), locals);
+        }
+    } else if (auto *chan = dynamic_cast<const ChanExpr*>(expr)) {
+        validateParallelExpression(chan->capacity.get(), locals);
+    } else if (auto *map = dynamic_cast<const MapExpr*>(expr)) {
+        validateParallelExpression(map->sizeHint.get(), locals);
+    } else if (auto *recv = dynamic_cast<const RecvExpr*>(expr)) {
+        validateParallelExpression(recv->chan.get(), locals);
+        if (!recv->target.empty() && locals.count(recv->target) == 0) {
+            std::cerr << "Error: no se puede asignar la variable compartida '" << recv->target
+                      << "' dentro de un parallel for (línea " << recv->line << ")\n";
+            std::exit(1);
+        }
+    } else if (auto *interp = dynamic_cast<const InterpExpr*>(expr)) {
+        for (const auto &hole : interp->holes) validateParallelExpression(hole.get(), locals);
+    }
+}